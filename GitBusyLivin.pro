@@ -44,7 +44,20 @@ SOURCES += src/main.cpp\
     src/ui/bookmarksdock.cpp \
     src/ui/branchdialog.cpp \
     src/ui/gbldialog.cpp \
-    src/ui/stashdialog.cpp
+    src/ui/stashdialog.cpp \
+    src/gbl/gbl_commitstore.cpp \
+    src/gbl/gbl_graphlayout.cpp \
+    src/gbl/gbl_scan.cpp \
+    src/gbl/gbl_search.cpp \
+    src/gbl/gbl_trigramindex.cpp \
+    src/gbl/gbl_scanresultsmodel.cpp \
+    src/gbl/gbl_diffbuffer.cpp \
+    src/ui/diffview.cpp \
+    src/gbl/gbl_diffcache.cpp \
+    src/gbl/gbl_commitdiff.cpp \
+    src/gbl/gbl_statusjournal.cpp \
+    src/gbl/gbl_untrackedcache.cpp \
+    src/gbl/gbl_filelist.cpp
 
 HEADERS  += src/ui/mainwindow.h \
     src/gbl/gbl_repository.h \
@@ -77,7 +90,20 @@ HEADERS  += src/ui/mainwindow.h \
     src/ui/bookmarksdock.h \
     src/ui/branchdialog.h \
     src/ui/gbldialog.h \
-    src/ui/stashdialog.h
+    src/ui/stashdialog.h \
+    src/gbl/gbl_commitstore.h \
+    src/gbl/gbl_graphlayout.h \
+    src/gbl/gbl_scan.h \
+    src/gbl/gbl_search.h \
+    src/gbl/gbl_trigramindex.h \
+    src/gbl/gbl_scanresultsmodel.h \
+    src/gbl/gbl_diffbuffer.h \
+    src/ui/diffview.h \
+    src/gbl/gbl_diffcache.h \
+    src/gbl/gbl_commitdiff.h \
+    src/gbl/gbl_statusjournal.h \
+    src/gbl/gbl_untrackedcache.h \
+    src/gbl/gbl_filelist.h
 
 RESOURCES += \
     resources/gitbusylivin.qrc
@@ -0,0 +1,107 @@
+#include "gbl_commitdiff.h"
+
+/**
+ * @brief GBL_CommitDiff::GBL_CommitDiff
+ * @param pRepo used from the thread that owns it only
+ */
+GBL_CommitDiff::GBL_CommitDiff(GBL_Repository *pRepo)
+{
+    m_pRepo = pRepo;
+}
+
+GBL_CommitDiff::~GBL_CommitDiff()
+{
+    close();
+}
+
+/**
+ * @brief GBL_CommitDiff::open
+ * compares the commit's tree with its parents' trees
+ * @param sOid
+ * @return
+ */
+bool GBL_CommitDiff::open(const QString &sOid)
+{
+    close();
+
+    if (!m_pRepo->get_commit_diffs(GBL_String(sOid), m_diffs))
+    {
+        close();
+        return false;
+    }
+
+    for (int i = 0; i < m_diffs.size(); i++)
+    {
+        int nDeltas = (int)git_diff_num_deltas(m_diffs.at(i));
+        for (int j = 0; j < nDeltas; j++)
+        {
+            const git_diff_delta *pDelta = git_diff_get_delta(m_diffs.at(i), j);
+            m_pathDeltas[QString::fromUtf8(pDelta->new_file.path)].append(qMakePair(i, j));
+        }
+    }
+
+    m_sOid = sOid;
+
+    return true;
+}
+
+void GBL_CommitDiff::close()
+{
+    for (int i = 0; i < m_diffs.size(); i++)
+    {
+        git_diff_free(m_diffs.at(i));
+    }
+
+    m_diffs.clear();
+    m_pathDeltas.clear();
+    m_sOid.clear();
+}
+
+/**
+ * @brief GBL_CommitDiff::getFiles
+ * @param pFileArr gets the files changed against each parent in turn
+ * @return
+ */
+bool GBL_CommitDiff::getFiles(GBL_FileList *pFileArr)
+{
+    for (int i = 0; i < m_diffs.size(); i++)
+    {
+        if (!m_pRepo->get_diff_files(m_diffs.at(i), pFileArr)) return false;
+    }
+
+    return !m_sOid.isEmpty();
+}
+
+/**
+ * @brief GBL_CommitDiff::getPatch
+ * @param sPath file to make the patch of, empty for the whole commit
+ * @param pBuffer gets the lines of the patch against each parent in turn
+ * @param pLimits Q_NULLPTR for no limits
+ * @return
+ */
+bool GBL_CommitDiff::getPatch(const QString &sPath, GBL_DiffBuffer *pBuffer, const GBL_Diff_Limits *pLimits)
+{
+    if (m_sOid.isEmpty()) return false;
+
+    if (sPath.isEmpty())
+    {
+        for (int i = 0; i < m_diffs.size(); i++)
+        {
+            int nDeltas = (int)git_diff_num_deltas(m_diffs.at(i));
+            for (int j = 0; j < nDeltas; j++)
+            {
+                if (!m_pRepo->get_diff_patch(m_diffs.at(i), j, pBuffer, pLimits)) return false;
+            }
+        }
+
+        return true;
+    }
+
+    QVector<QPair<int, int> > deltas = m_pathDeltas.value(sPath);
+    for (int i = 0; i < deltas.size(); i++)
+    {
+        if (!m_pRepo->get_diff_patch(m_diffs.at(deltas.at(i).first), deltas.at(i).second, pBuffer, pLimits)) return false;
+    }
+
+    return true;
+}
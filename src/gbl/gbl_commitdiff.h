@@ -0,0 +1,39 @@
+#ifndef GBL_COMMITDIFF_H
+#define GBL_COMMITDIFF_H
+
+#include "gbl_repository.h"
+
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QString>
+
+/**
+ * @brief The GBL_CommitDiff class
+ * the diffs of one commit against its parents, kept while the commit is
+ * selected. The trees are compared once, the file list and the patch of
+ * each file are read from the same diffs.
+ */
+class GBL_CommitDiff
+{
+public:
+    GBL_CommitDiff(GBL_Repository *pRepo);
+    ~GBL_CommitDiff();
+
+    bool open(const QString &sOid);
+    void close();
+    bool isOpen(const QString &sOid) const { return !m_sOid.isEmpty() && m_sOid == sOid; }
+
+    bool getFiles(GBL_FileList *pFileArr);
+    bool getPatch(const QString &sPath, GBL_DiffBuffer *pBuffer, const GBL_Diff_Limits *pLimits = Q_NULLPTR);
+
+private:
+    GBL_Repository *m_pRepo;
+    QString m_sOid;
+    QVector<git_diff*> m_diffs;
+
+    // path to its deltas, as a diff number and a delta number in that diff
+    QHash<QString, QVector<QPair<int, int> > > m_pathDeltas;
+};
+
+#endif // GBL_COMMITDIFF_H
@@ -0,0 +1,777 @@
+#include "gbl_commitstore.h"
+#include "gbl_graphlayout.h"
+
+#include <QFile>
+#include <QSaveFile>
+
+#include <limits.h>
+
+typedef struct GBL_CommitCache_Header {
+    char magic[4];
+    quint32 version;
+    quint32 rows;
+    quint32 parents;
+    quint32 dangling;
+    quint32 authors;
+    quint32 textSize;
+    quint32 authorTextSize;
+} GBL_CommitCache_Header;
+
+template <typename T>
+static bool write_array(QIODevice &dev, const QVector<T> &vec)
+{
+    qint64 nBytes = (qint64)vec.size() * sizeof(T);
+    return dev.write((const char*)vec.constData(), nBytes) == nBytes;
+}
+
+template <typename T>
+static void read_array(QVector<T> &vec, const uchar *&pData, int nCount)
+{
+    vec.resize(nCount);
+    if (nCount) memcpy(vec.data(), pData, nCount * sizeof(T));
+    pData += nCount * sizeof(T);
+}
+
+/**
+ * @brief GBL_CommitStore::GBL_CommitStore
+ */
+GBL_CommitStore::GBL_CommitStore()
+{
+    clear();
+}
+
+/**
+ * @brief GBL_CommitStore::clear
+ */
+void GBL_CommitStore::clear()
+{
+    m_oids.clear();
+    m_times.clear();
+    m_authors.clear();
+
+    m_text.clear();
+    m_textPos.clear();
+    m_textPos.append(0);
+
+    m_parentPos.clear();
+    m_parentPos.append(0);
+    m_parents.clear();
+    m_danglingOids.clear();
+    m_danglingSlots.clear();
+    m_freeDangling.clear();
+    m_danglingIndex.clear();
+
+    m_rowIndex.clear();
+    m_nRowOffset = 0;
+
+    m_authorNames.clear();
+    m_authorEmails.clear();
+    m_authorIndex.clear();
+
+    clearGraph();
+}
+
+/**
+ * @brief GBL_CommitStore::reserve
+ * @param nRows
+ */
+void GBL_CommitStore::reserve(int nRows)
+{
+    m_oids.reserve(nRows);
+    m_times.reserve(nRows);
+    m_authors.reserve(nRows);
+    m_textPos.reserve(nRows + 1);
+    m_parentPos.reserve(nRows + 1);
+    m_parents.reserve(nRows);
+    m_rowIndex.reserve(nRows);
+}
+
+/**
+ * @brief GBL_CommitStore::addAuthor
+ * interns an author, the same name and email always map to the same id
+ * @param name
+ * @param email
+ * @return author id
+ */
+int GBL_CommitStore::addAuthor(const char *name, const char *email)
+{
+    return addAuthor(name, name ? (int)strlen(name) : 0, email, email ? (int)strlen(email) : 0);
+}
+
+/**
+ * @brief GBL_CommitStore::addAuthor
+ * @param name
+ * @param nNameLen
+ * @param email
+ * @param nEmailLen
+ * @return author id
+ */
+int GBL_CommitStore::addAuthor(const char *name, int nNameLen, const char *email, int nEmailLen)
+{
+    QByteArray key;
+    key.reserve(nNameLen + nEmailLen + 1);
+    key.append(name, nNameLen);
+    key.append('\0');
+    key.append(email, nEmailLen);
+
+    QHash<QByteArray, int>::const_iterator it = m_authorIndex.constFind(key);
+    if (it != m_authorIndex.constEnd()) return it.value();
+
+    int nAuthor = m_authorNames.size();
+    m_authorNames.append(QString::fromUtf8(name, nNameLen));
+    m_authorEmails.append(QString::fromUtf8(email, nEmailLen));
+    m_authorIndex.insert(key, nAuthor);
+
+    return nAuthor;
+}
+
+/**
+ * @brief GBL_CommitStore::appendCommit
+ * appends a commit row, its parents are added with appendParent afterwards
+ * @param oid
+ * @param nAuthor id returned by addAuthor
+ * @param time
+ * @param summary
+ * @return the new row
+ */
+int GBL_CommitStore::appendCommit(const git_oid &oid, int nAuthor, qint64 time, const char *summary)
+{
+    return appendCommit(oid, nAuthor, time, summary, summary ? (int)strlen(summary) : 0);
+}
+
+/**
+ * @brief GBL_CommitStore::appendCommit
+ * @param oid
+ * @param nAuthor
+ * @param time
+ * @param summary
+ * @param nSummaryLen
+ * @return the new row
+ */
+int GBL_CommitStore::appendCommit(const git_oid &oid, int nAuthor, qint64 time, const char *summary, int nSummaryLen)
+{
+    int row = m_oids.size();
+
+    m_oids.append(oid);
+    m_times.append(time);
+    m_authors.append(nAuthor);
+
+    m_text.append(summary, nSummaryLen);
+    m_textPos.append(m_text.size());
+
+    m_parentPos.append(m_parents.size());
+
+    m_rowIndex.insert(oid, row - m_nRowOffset);
+    resolveDangling(oid, row);
+
+    return row;
+}
+
+/**
+ * @brief GBL_CommitStore::appendParent
+ * adds a parent to the last appended commit
+ * @param parentOid
+ */
+void GBL_CommitStore::appendParent(const git_oid &parentOid)
+{
+    addParentSlot(parentOid);
+    m_parentPos.last() = m_parents.size();
+}
+
+/**
+ * @brief GBL_CommitStore::countNew
+ * @param page
+ * @return number of rows in page that append would add
+ */
+int GBL_CommitStore::countNew(const GBL_CommitStore &page) const
+{
+    if (isEmpty()) return page.size();
+
+    int nNew = 0;
+    for (int row = 0; row < page.size(); row++)
+    {
+        if (!m_rowIndex.contains(page.m_oids.at(row))) nNew++;
+    }
+
+    return nNew;
+}
+
+/**
+ * @brief GBL_CommitStore::append
+ * appends the rows of another store that are not here yet, re-interning its
+ * authors and linking its loose parents to rows already here or still to come
+ * @param page
+ * @return number of rows added
+ */
+int GBL_CommitStore::append(const GBL_CommitStore &page)
+{
+    if (isEmpty())
+    {
+        // containers are implicitly shared, taking over a whole page is cheap
+        *this = page;
+        return size();
+    }
+
+    int nBase = size();
+
+    QVector<int> authorMap = internAuthors(page);
+
+    // parents may point further down the page, so map every row first
+    QVector<int> rowMap(page.size());
+    int nNext = nBase;
+    for (int row = 0; row < page.size(); row++)
+    {
+        int nRow = findRow(page.m_oids.at(row));
+        rowMap[row] = nRow >= 0 ? nRow : nNext++;
+    }
+
+    for (int row = 0; row < page.size(); row++)
+    {
+        if (rowMap.at(row) < nBase) continue;
+
+        bool bGraph = graphRowCount() == size() && row < page.graphRowCount();
+        if (bGraph)
+        {
+            appendGraphRow(page.graphNode(row), page.graphSegments(row), page.graphSegmentCount(row));
+        }
+
+        const git_oid &oid = page.m_oids.at(row);
+        m_oids.append(oid);
+        m_times.append(page.m_times.at(row));
+        m_authors.append(authorMap.at(page.m_authors.at(row)));
+        int nTextStart = page.m_textPos.at(row);
+        m_text.append(page.m_text.constData() + nTextStart, page.m_textPos.at(row + 1) - nTextStart);
+        m_textPos.append(m_text.size());
+
+        m_rowIndex.insert(oid, rowMap.at(row) - m_nRowOffset);
+        resolveDangling(oid, rowMap.at(row));
+
+        for (int i = page.m_parentPos.at(row); i < page.m_parentPos.at(row + 1); i++)
+        {
+            int nParent = page.m_parents.at(i);
+            if (nParent >= 0) m_parents.append(rowMap.at(nParent));
+            else addParentSlot(page.m_danglingOids.at(-nParent - 1));
+        }
+        m_parentPos.append(m_parents.size());
+    }
+
+    return size() - nBase;
+}
+
+/**
+ * @brief GBL_CommitStore::prepend
+ * puts newer commits in front of the store. The page must not hold rows
+ * that are already here, which is the case for a walk hiding the old tip.
+ * The graphs are joined only when both are laid out, the page's layout has
+ * to end with lane 0 waiting for the old tip alone.
+ * @param page
+ * @return number of rows added
+ */
+int GBL_CommitStore::prepend(const GBL_CommitStore &page)
+{
+    if (page.isEmpty()) return 0;
+    if (isEmpty()) return append(page);
+
+    int nNew = page.size();
+    int nNewParents = page.m_parents.size();
+    QVector<int> authorMap = internAuthors(page);
+
+    // existing rows move down without touching the oid index
+    m_nRowOffset += nNew;
+
+    QVector<git_oid> oids;
+    oids.reserve(nNew + m_oids.size());
+    oids += page.m_oids;
+    oids += m_oids;
+    m_oids.swap(oids);
+
+    QVector<qint64> times;
+    times.reserve(nNew + m_times.size());
+    times += page.m_times;
+    times += m_times;
+    m_times.swap(times);
+
+    QVector<int> authors;
+    authors.reserve(nNew + m_authors.size());
+    for (int row = 0; row < nNew; row++)
+    {
+        authors.append(authorMap.at(page.m_authors.at(row)));
+    }
+    authors += m_authors;
+    m_authors.swap(authors);
+
+    QVector<int> textPos;
+    textPos.reserve(nNew + m_textPos.size());
+    textPos += page.m_textPos;
+    textPos.removeLast();
+    for (int i = 0; i < m_textPos.size(); i++)
+    {
+        textPos.append(m_textPos.at(i) + page.m_text.size());
+    }
+    m_textPos.swap(textPos);
+    m_text.prepend(page.m_text);
+
+    for (int i = 0; i < m_danglingSlots.size(); i++)
+    {
+        QVector<int> &parentSlots = m_danglingSlots[i];
+        for (int j = 0; j < parentSlots.size(); j++)
+        {
+            parentSlots[j] += nNewParents;
+        }
+    }
+
+    QVector<int> parents;
+    parents.reserve(nNewParents + m_parents.size());
+    for (int i = 0; i < nNewParents; i++)
+    {
+        int nParent = page.m_parents.at(i);
+        if (nParent >= 0) parents.append(nParent);
+        else parents.append(parentRef(page.m_danglingOids.at(-nParent - 1), i));
+    }
+    for (int i = 0; i < m_parents.size(); i++)
+    {
+        int nParent = m_parents.at(i);
+        parents.append(nParent >= 0 ? nParent + nNew : nParent);
+    }
+    m_parents.swap(parents);
+
+    QVector<int> parentPos;
+    parentPos.reserve(nNew + m_parentPos.size());
+    parentPos += page.m_parentPos;
+    parentPos.removeLast();
+    for (int i = 0; i < m_parentPos.size(); i++)
+    {
+        parentPos.append(m_parentPos.at(i) + nNewParents);
+    }
+    m_parentPos.swap(parentPos);
+
+    // the page's graph only fits on top if both sides are laid out
+    if (graphRowCount() == size() - nNew && page.graphRowCount() == nNew)
+    {
+        QVector<quint16> graphNodes;
+        graphNodes.reserve(nNew + m_graphNodes.size());
+        graphNodes += page.m_graphNodes;
+        graphNodes += m_graphNodes;
+        m_graphNodes.swap(graphNodes);
+
+        // the old tip was laid out as a branch tip, now the line from the
+        // page comes in on lane 0, which is all laying it out again changes
+        QVector<quint32> graphSegs;
+        graphSegs.reserve(page.m_graphSegs.size() + m_graphSegs.size() + 1);
+        graphSegs += page.m_graphSegs;
+        graphSegs.append(gbl_graph_segment(GBL_GRAPH_SEG_IN, 0, m_graphNodes.at(nNew)));
+        graphSegs += m_graphSegs;
+        m_graphSegs.swap(graphSegs);
+
+        QVector<int> graphSegPos;
+        graphSegPos.reserve(nNew + m_graphSegPos.size());
+        graphSegPos += page.m_graphSegPos;
+        graphSegPos.removeLast();
+        graphSegPos.append(page.m_graphSegs.size());
+        for (int i = 1; i < m_graphSegPos.size(); i++)
+        {
+            graphSegPos.append(m_graphSegPos.at(i) + page.m_graphSegs.size() + 1);
+        }
+        m_graphSegPos.swap(graphSegPos);
+    }
+    else
+    {
+        clearGraph();
+    }
+
+    for (int row = 0; row < nNew; row++)
+    {
+        const git_oid &oid = m_oids.at(row);
+        m_rowIndex.insert(oid, row - m_nRowOffset);
+        resolveDangling(oid, row);
+    }
+
+    return nNew;
+}
+
+/**
+ * @brief GBL_CommitStore::findRow
+ * @param oid
+ * @return the row holding oid or -1
+ */
+int GBL_CommitStore::findRow(const git_oid &oid) const
+{
+    QHash<git_oid, int>::const_iterator it = m_rowIndex.constFind(oid);
+    if (it == m_rowIndex.constEnd()) return -1;
+
+    return it.value() + m_nRowOffset;
+}
+
+/**
+ * @brief GBL_CommitStore::internAuthors
+ * @param page
+ * @return this store's author id for each of the page's authors
+ */
+QVector<int> GBL_CommitStore::internAuthors(const GBL_CommitStore &page)
+{
+    QVector<int> authorMap(page.authorCount());
+    for (int i = 0; i < page.authorCount(); i++)
+    {
+        authorMap[i] = addAuthor(page.m_authorNames.at(i).toUtf8().constData(),
+                                 page.m_authorEmails.at(i).toUtf8().constData());
+    }
+
+    return authorMap;
+}
+
+/**
+ * @brief GBL_CommitStore::saveCache
+ * writes the store as flat arrays so loadCache can copy them straight
+ * out of a mapped file
+ * @param sFile
+ * @return
+ */
+bool GBL_CommitStore::saveCache(const QString &sFile) const
+{
+    QByteArray authorText;
+    QVector<int> authorPos;
+    authorPos.append(0);
+    for (int i = 0; i < m_authorNames.size(); i++)
+    {
+        authorText.append(m_authorNames.at(i).toUtf8());
+        authorPos.append(authorText.size());
+        authorText.append(m_authorEmails.at(i).toUtf8());
+        authorPos.append(authorText.size());
+    }
+
+    GBL_CommitCache_Header hdr;
+    memcpy(hdr.magic, GBL_COMMITSTORE_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = GBL_COMMITSTORE_CACHE_VERSION;
+    hdr.rows = m_oids.size();
+    hdr.parents = m_parents.size();
+    hdr.dangling = m_danglingOids.size();
+    hdr.authors = m_authorNames.size();
+    hdr.textSize = m_text.size();
+    hdr.authorTextSize = authorText.size();
+
+    QSaveFile file(sFile);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    bool bRet = file.write((const char*)&hdr, sizeof(hdr)) == sizeof(hdr);
+    bRet = bRet && write_array(file, m_oids);
+    bRet = bRet && write_array(file, m_times);
+    bRet = bRet && write_array(file, m_authors);
+    bRet = bRet && write_array(file, m_textPos);
+    bRet = bRet && write_array(file, m_parentPos);
+    bRet = bRet && write_array(file, m_parents);
+    bRet = bRet && write_array(file, m_danglingOids);
+    bRet = bRet && write_array(file, authorPos);
+    bRet = bRet && file.write(m_text) == m_text.size();
+    bRet = bRet && file.write(authorText) == authorText.size();
+
+    if (!bRet)
+    {
+        file.cancelWriting();
+    }
+
+    return file.commit() && bRet;
+}
+
+/**
+ * @brief GBL_CommitStore::loadCache
+ * @param sFile
+ * @return false if the file is missing, from another version or damaged
+ */
+bool GBL_CommitStore::loadCache(const QString &sFile)
+{
+    clear();
+
+    QFile file(sFile);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    qint64 nSize = file.size();
+    if (nSize < (qint64)sizeof(GBL_CommitCache_Header)) return false;
+
+    uchar *pData = file.map(0, nSize);
+    if (!pData) return false;
+
+    bool bRet = readCache(pData, nSize);
+    file.unmap(pData);
+
+    // a cache that can't be read is just read again from the repository
+    if (!bRet) clear();
+
+    return bRet;
+}
+
+/**
+ * @brief GBL_CommitStore::frontier
+ * @return parents referenced by the store that have not been loaded yet
+ */
+QVector<git_oid> GBL_CommitStore::frontier() const
+{
+    return m_danglingIndex.keys().toVector();
+}
+
+/**
+ * @brief GBL_CommitStore::oidString
+ * @param row
+ * @return
+ */
+QString GBL_CommitStore::oidString(int row) const
+{
+    return QString(git_oid_tostr_s(&m_oids.at(row)));
+}
+
+/**
+ * @brief GBL_CommitStore::dateTime
+ * @param row
+ * @return
+ */
+QDateTime GBL_CommitStore::dateTime(int row) const
+{
+    return QDateTime::fromTime_t(m_times.at(row));
+}
+
+/**
+ * @brief GBL_CommitStore::summary
+ * @param row
+ * @return
+ */
+QString GBL_CommitStore::summary(int row) const
+{
+    int nStart = m_textPos.at(row);
+    return QString::fromUtf8(m_text.constData() + nStart, m_textPos.at(row + 1) - nStart);
+}
+
+/**
+ * @brief GBL_CommitStore::author
+ * @param row
+ * @return "name <email>"
+ */
+QString GBL_CommitStore::author(int row) const
+{
+    int nAuthor = m_authors.at(row);
+    return m_authorNames.at(nAuthor) + " <" + m_authorEmails.at(nAuthor) + ">";
+}
+
+/**
+ * @brief GBL_CommitStore::parentRow
+ * @param row
+ * @param nParent
+ * @return the parent's row or -1 if it has not been loaded
+ */
+int GBL_CommitStore::parentRow(int row, int nParent) const
+{
+    int nRow = m_parents.at(m_parentPos.at(row) + nParent);
+    return nRow >= 0 ? nRow : -1;
+}
+
+/**
+ * @brief GBL_CommitStore::parentOid
+ * @param row
+ * @param nParent
+ * @return
+ */
+const git_oid* GBL_CommitStore::parentOid(int row, int nParent) const
+{
+    int nRow = m_parents.at(m_parentPos.at(row) + nParent);
+    if (nRow >= 0) return &m_oids.at(nRow);
+
+    return &m_danglingOids.at(-nRow - 1);
+}
+
+/**
+ * @brief GBL_CommitStore::clearGraph
+ */
+void GBL_CommitStore::clearGraph()
+{
+    m_graphNodes.clear();
+    m_graphSegPos.clear();
+    m_graphSegPos.append(0);
+    m_graphSegs.clear();
+}
+
+/**
+ * @brief GBL_CommitStore::appendGraphRow
+ * graph rows are added in row order, after the commit rows they describe
+ * @param nNodeLane
+ * @param pSegs
+ * @param nSegs
+ */
+void GBL_CommitStore::appendGraphRow(int nNodeLane, const quint32 *pSegs, int nSegs)
+{
+    m_graphNodes.append(nNodeLane);
+    for (int i = 0; i < nSegs; i++)
+    {
+        m_graphSegs.append(pSegs[i]);
+    }
+    m_graphSegPos.append(m_graphSegs.size());
+}
+
+/**
+ * @brief GBL_CommitStore::readCache
+ * @param pData
+ * @param nSize
+ * @return
+ */
+bool GBL_CommitStore::readCache(const uchar *pData, qint64 nSize)
+{
+    GBL_CommitCache_Header hdr;
+    memcpy(&hdr, pData, sizeof(hdr));
+    if (memcmp(hdr.magic, GBL_COMMITSTORE_CACHE_MAGIC, sizeof(hdr.magic)) != 0) return false;
+    if (hdr.version != GBL_COMMITSTORE_CACHE_VERSION) return false;
+
+    qint64 nExpected = sizeof(hdr);
+    nExpected += (qint64)hdr.rows * (sizeof(git_oid) + sizeof(qint64) + sizeof(int));
+    nExpected += (qint64)(hdr.rows + 1) * sizeof(int) * 2;
+    nExpected += (qint64)hdr.parents * sizeof(int);
+    nExpected += (qint64)hdr.dangling * sizeof(git_oid);
+    nExpected += ((qint64)hdr.authors * 2 + 1) * sizeof(int);
+    nExpected += (qint64)hdr.textSize + hdr.authorTextSize;
+    if (nSize != nExpected || hdr.rows > INT_MAX / 2) return false;
+
+    const uchar *p = pData + sizeof(hdr);
+    int nRows = hdr.rows;
+    QVector<int> authorPos;
+
+    read_array(m_oids, p, nRows);
+    read_array(m_times, p, nRows);
+    read_array(m_authors, p, nRows);
+    read_array(m_textPos, p, nRows + 1);
+    read_array(m_parentPos, p, nRows + 1);
+    read_array(m_parents, p, hdr.parents);
+    read_array(m_danglingOids, p, hdr.dangling);
+    read_array(authorPos, p, hdr.authors * 2 + 1);
+    m_text = QByteArray((const char*)p, hdr.textSize);
+    p += hdr.textSize;
+    QByteArray authorText((const char*)p, hdr.authorTextSize);
+
+    // the arrays index each other, make sure they agree before trusting them
+    if (m_textPos.first() != 0 || m_textPos.last() != m_text.size()) return false;
+    if (m_parentPos.first() != 0 || m_parentPos.last() != m_parents.size()) return false;
+    if (authorPos.first() != 0 || authorPos.last() != authorText.size()) return false;
+    for (int i = 0; i < nRows; i++)
+    {
+        if (m_textPos.at(i) > m_textPos.at(i+1) || m_parentPos.at(i) > m_parentPos.at(i+1)) return false;
+        if (m_authors.at(i) < 0 || m_authors.at(i) >= (int)hdr.authors) return false;
+    }
+    for (int i = 0; i < m_parents.size(); i++)
+    {
+        int nParent = m_parents.at(i);
+        if (nParent >= nRows || nParent < -m_danglingOids.size()) return false;
+    }
+    for (int i = 0; i < authorPos.size() - 1; i++)
+    {
+        if (authorPos.at(i) > authorPos.at(i+1)) return false;
+    }
+
+    for (int i = 0; i < (int)hdr.authors; i++)
+    {
+        const char *pName = authorText.constData() + authorPos.at(i*2);
+        const char *pEmail = authorText.constData() + authorPos.at(i*2+1);
+        int nNameLen = authorPos.at(i*2+1) - authorPos.at(i*2);
+        int nEmailLen = authorPos.at(i*2+2) - authorPos.at(i*2+1);
+
+        QByteArray key(pName, nNameLen);
+        key.append('\0');
+        key.append(pEmail, nEmailLen);
+        m_authorIndex.insert(key, i);
+        m_authorNames.append(QString::fromUtf8(pName, nNameLen));
+        m_authorEmails.append(QString::fromUtf8(pEmail, nEmailLen));
+    }
+
+    rebuildIndexes();
+
+    return true;
+}
+
+/**
+ * @brief GBL_CommitStore::rebuildIndexes
+ * recreates the oid lookups from the flat arrays
+ */
+void GBL_CommitStore::rebuildIndexes()
+{
+    m_rowIndex.clear();
+    m_rowIndex.reserve(m_oids.size());
+    m_nRowOffset = 0;
+    for (int row = 0; row < m_oids.size(); row++)
+    {
+        m_rowIndex.insert(m_oids.at(row), row);
+    }
+
+    m_danglingIndex.clear();
+    m_freeDangling.clear();
+    m_danglingSlots.clear();
+    m_danglingSlots.resize(m_danglingOids.size());
+    for (int i = 0; i < m_parents.size(); i++)
+    {
+        int nParent = m_parents.at(i);
+        if (nParent < 0) m_danglingSlots[-nParent - 1].append(i);
+    }
+
+    for (int i = 0; i < m_danglingSlots.size(); i++)
+    {
+        if (m_danglingSlots.at(i).isEmpty()) m_freeDangling.append(i);
+        else m_danglingIndex.insert(m_danglingOids.at(i), i);
+    }
+}
+
+/**
+ * @brief GBL_CommitStore::resolveDangling
+ * points every parent slot waiting on oid at its newly added row
+ * @param oid
+ * @param row
+ */
+void GBL_CommitStore::resolveDangling(const git_oid &oid, int row)
+{
+    QHash<git_oid, int>::iterator it = m_danglingIndex.find(oid);
+    if (it == m_danglingIndex.end()) return;
+
+    int nDangling = it.value();
+    m_danglingIndex.erase(it);
+
+    QVector<int> &parentSlots = m_danglingSlots[nDangling];
+    for (int i = 0; i < parentSlots.size(); i++)
+    {
+        m_parents[parentSlots.at(i)] = row;
+    }
+    parentSlots.resize(0);
+    m_freeDangling.append(nDangling);
+}
+
+/**
+ * @brief GBL_CommitStore::addParentSlot
+ * @param parentOid
+ */
+void GBL_CommitStore::addParentSlot(const git_oid &parentOid)
+{
+    m_parents.append(parentRef(parentOid, m_parents.size()));
+}
+
+/**
+ * @brief GBL_CommitStore::parentRef
+ * @param parentOid
+ * @param nSlot position in m_parents the reference will be stored at
+ * @return the parent's row, or -(n+1) for dangling entry n waiting on it
+ */
+int GBL_CommitStore::parentRef(const git_oid &parentOid, int nSlot)
+{
+    int nRow = findRow(parentOid);
+    if (nRow >= 0) return nRow;
+
+    int nDangling = m_danglingIndex.value(parentOid, -1);
+    if (nDangling < 0)
+    {
+        if (!m_freeDangling.isEmpty())
+        {
+            nDangling = m_freeDangling.takeLast();
+            m_danglingOids[nDangling] = parentOid;
+        }
+        else
+        {
+            nDangling = m_danglingOids.size();
+            m_danglingOids.append(parentOid);
+            m_danglingSlots.append(QVector<int>());
+        }
+        m_danglingIndex.insert(parentOid, nDangling);
+    }
+
+    m_danglingSlots[nDangling].append(nSlot);
+    return -nDangling - 1;
+}
@@ -0,0 +1,124 @@
+#ifndef GBL_COMMITSTORE_H
+#define GBL_COMMITSTORE_H
+
+#include <git2.h>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QString>
+#include <QDateTime>
+
+#include <string.h>
+
+#define GBL_COMMITSTORE_CACHE_MAGIC "GBLH"
+#define GBL_COMMITSTORE_CACHE_VERSION 1
+
+inline bool operator==(const git_oid &a, const git_oid &b)
+{
+    return memcmp(a.id, b.id, GIT_OID_RAWSZ) == 0;
+}
+
+inline uint qHash(const git_oid &oid, uint seed = 0)
+{
+    // oids are already uniformly distributed, the leading bytes make a fine hash
+    uint h;
+    memcpy(&h, oid.id, sizeof(h));
+    return h ^ seed;
+}
+
+/**
+ * @brief The GBL_CommitStore class
+ * columnar storage for commit history. Rows are kept in walk order, oids are
+ * stored as raw git_oid, parents as row indices into the same store, authors
+ * are interned and summaries are kept as utf-8 in a single arena and only
+ * decoded when asked for. Messages are not kept, they are read from the
+ * repository for the one commit whose details are shown.
+ */
+class GBL_CommitStore
+{
+public:
+    GBL_CommitStore();
+
+    void clear();
+    void reserve(int nRows);
+    int size() const { return m_oids.size(); }
+    bool isEmpty() const { return m_oids.isEmpty(); }
+
+    int addAuthor(const char *name, const char *email);
+    int addAuthor(const char *name, int nNameLen, const char *email, int nEmailLen);
+    int appendCommit(const git_oid &oid, int nAuthor, qint64 time, const char *summary);
+    int appendCommit(const git_oid &oid, int nAuthor, qint64 time, const char *summary, int nSummaryLen);
+    void appendParent(const git_oid &parentOid);
+    int countNew(const GBL_CommitStore &page) const;
+    int append(const GBL_CommitStore &page);
+    int prepend(const GBL_CommitStore &page);
+
+    bool saveCache(const QString &sFile) const;
+    bool loadCache(const QString &sFile);
+
+    int findRow(const git_oid &oid) const;
+    QVector<git_oid> frontier() const;
+    const git_oid* oid(int row) const { return &m_oids.at(row); }
+    QString oidString(int row) const;
+    qint64 time(int row) const { return m_times.at(row); }
+    QDateTime dateTime(int row) const;
+    QString summary(int row) const;
+
+    int authorId(int row) const { return m_authors.at(row); }
+    int authorCount() const { return m_authorNames.size(); }
+    QString authorName(int nAuthor) const { return m_authorNames.at(nAuthor); }
+    QString authorEmail(int nAuthor) const { return m_authorEmails.at(nAuthor); }
+    QString author(int row) const;
+
+    int parentCount(int row) const { return m_parentPos.at(row+1) - m_parentPos.at(row); }
+    int parentRow(int row, int nParent) const;
+    const git_oid* parentOid(int row, int nParent) const;
+
+    void clearGraph();
+    void appendGraphRow(int nNodeLane, const quint32 *pSegs, int nSegs);
+    int graphRowCount() const { return m_graphNodes.size(); }
+    int graphNode(int row) const { return m_graphNodes.at(row); }
+    int graphSegmentCount(int row) const { return m_graphSegPos.at(row+1) - m_graphSegPos.at(row); }
+    const quint32* graphSegments(int row) const { return m_graphSegs.constData() + m_graphSegPos.at(row); }
+
+private:
+    bool readCache(const uchar *pData, qint64 nSize);
+    void rebuildIndexes();
+    void resolveDangling(const git_oid &oid, int row);
+    void addParentSlot(const git_oid &parentOid);
+    int parentRef(const git_oid &parentOid, int nSlot);
+    QVector<int> internAuthors(const GBL_CommitStore &page);
+
+    QVector<git_oid> m_oids;
+    QVector<qint64> m_times;
+    QVector<int> m_authors;
+
+    // summary of row i is m_text[m_textPos[i] .. m_textPos[i+1])
+    QByteArray m_text;
+    QVector<int> m_textPos;
+
+    // parents of row i are m_parents[m_parentPos[i] .. m_parentPos[i+1]),
+    // a negative value -(n+1) refers to m_danglingOids[n], a parent not loaded yet.
+    // resolved dangling entries are recycled so only the walk frontier is kept.
+    QVector<int> m_parentPos;
+    QVector<int> m_parents;
+    QVector<git_oid> m_danglingOids;
+    QVector<QVector<int> > m_danglingSlots;
+    QVector<int> m_freeDangling;
+    QHash<git_oid, int> m_danglingIndex;
+
+    // rows are stored relative to m_nRowOffset so prepending doesn't rehash
+    QHash<git_oid, int> m_rowIndex;
+    int m_nRowOffset;
+
+    QVector<QString> m_authorNames;
+    QVector<QString> m_authorEmails;
+    QHash<QByteArray, int> m_authorIndex;
+
+    // graph rows laid out by GBL_GraphLayout, node lane and packed segments per row
+    QVector<quint16> m_graphNodes;
+    QVector<int> m_graphSegPos;
+    QVector<quint32> m_graphSegs;
+};
+
+#endif // GBL_COMMITSTORE_H
@@ -0,0 +1,174 @@
+#include "gbl_diffbuffer.h"
+
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <string.h>
+
+/**
+ * @brief GBL_DiffBuffer::GBL_DiffBuffer
+ */
+GBL_DiffBuffer::GBL_DiffBuffer()
+{
+    m_nMaxLength = 0;
+    m_nMaxLineNum = 0;
+    m_bLimited = false;
+    m_pObserver = Q_NULLPTR;
+    m_nObserveEvery = 0;
+    m_nNextObserve = 0;
+}
+
+void GBL_DiffBuffer::clear()
+{
+    m_text.clear();
+    m_lines.clear();
+    m_nMaxLength = 0;
+    m_nMaxLineNum = 0;
+    m_bLimited = false;
+    m_nNextObserve = m_nObserveEvery;
+}
+
+/**
+ * @brief GBL_DiffBuffer::setObserver
+ * @param pObserver called from addLine, or Q_NULLPTR
+ * @param nEvery lines between calls
+ */
+void GBL_DiffBuffer::setObserver(GBL_DiffObserver *pObserver, int nEvery)
+{
+    m_pObserver = pObserver;
+    m_nObserveEvery = qMax(1, nEvery);
+    m_nNextObserve = m_lines.size() + m_nObserveEvery;
+}
+
+/**
+ * @brief GBL_DiffBuffer::addLine
+ * appends the content of one diff line. File headers and end of file notes
+ * hold more than one line of text, each becomes a line of its own with the
+ * same origin.
+ * @param origin GIT_DIFF_LINE_ value
+ * @param nOldLine
+ * @param nNewLine
+ * @param pContent not null terminated
+ * @param nLen
+ * @return false if the observer wants the diff stopped
+ */
+bool GBL_DiffBuffer::addLine(char origin, int nOldLine, int nNewLine, const char *pContent, int nLen)
+{
+    const char *p = pContent;
+    const char *pEnd = pContent + nLen;
+
+    if (nOldLine > m_nMaxLineNum) m_nMaxLineNum = nOldLine;
+    if (nNewLine > m_nMaxLineNum) m_nMaxLineNum = nNewLine;
+
+    do
+    {
+        const char *pLineEnd = (const char*)memchr(p, '\n', pEnd - p);
+        const char *pNext = pLineEnd ? pLineEnd + 1 : pEnd;
+        if (!pLineEnd) pLineEnd = pEnd;
+        if (pLineEnd > p && pLineEnd[-1] == '\r') pLineEnd--;
+
+        GBL_Diff_Line line;
+        line.offset = m_text.size();
+        line.length = pLineEnd - p;
+        line.old_line_num = nOldLine;
+        line.new_line_num = nNewLine;
+        line.origin = origin;
+        m_text.append(p, line.length);
+        m_lines.append(line);
+
+        if (line.length > m_nMaxLength) m_nMaxLength = line.length;
+
+        // only the first line of a multi-line entry is numbered
+        nOldLine = -1;
+        nNewLine = -1;
+        p = pNext;
+    } while (p < pEnd);
+
+    if (m_pObserver && m_lines.size() >= m_nNextObserve)
+    {
+        m_nNextObserve = m_lines.size() + m_nObserveEvery;
+        return m_pObserver->diffProgress(*this);
+    }
+
+    return true;
+}
+
+/**
+ * @brief GBL_DiffBuffer::lineText
+ * @param nLine
+ * @return the decoded text of a line, without its line break
+ */
+QString GBL_DiffBuffer::lineText(int nLine) const
+{
+    const GBL_Diff_Line &line = m_lines.at(nLine);
+
+    return QString::fromUtf8(m_text.constData() + line.offset, line.length);
+}
+
+#ifdef QT_DEBUG
+/**
+ * @brief GBL_DiffBuffer::benchmark
+ * times capturing a synthetic patch the way the diff callback used to, a
+ * QString per line decoded from the unterminated content and a heap copy of
+ * every line, against appending the raw bytes to a buffer
+ * @param nLines
+ * @return a summary of the lines per second
+ */
+QString GBL_DiffBuffer::benchmark(int nLines)
+{
+    typedef struct GBL_Bench_Line {
+        char line_change_type;
+        int old_line_num;
+        int new_line_num;
+        QString content;
+    } GBL_Bench_Line;
+
+    // like libgit2, line content points into one block that is only null
+    // terminated at its end
+    QByteArray baPatch;
+    QVector<int> offsets;
+    for (int i = 0; i < nLines; i++)
+    {
+        offsets.append(baPatch.size());
+        baPatch += "    int nValue" + QByteArray::number(i) + " = compute(nValue, " + QByteArray::number(i * 7) + ");\n";
+    }
+    offsets.append(baPatch.size());
+    const char *pPatch = baPatch.constData();
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<GBL_Bench_Line*> lines;
+    for (int i = 0; i < nLines; i++)
+    {
+        QString content(pPatch + offsets.at(i));
+        content = content.left(offsets.at(i + 1) - offsets.at(i));
+        GBL_Bench_Line li;
+        li.content = content;
+        li.line_change_type = '+';
+        li.new_line_num = i + 1;
+        li.old_line_num = -1;
+
+        GBL_Bench_Line *pLineItem = new GBL_Bench_Line;
+        *pLineItem = li;
+        lines.append(pLineItem);
+    }
+    qint64 nOldNs = qMax(timer.nsecsElapsed(), (qint64)1);
+    qDeleteAll(lines);
+
+    timer.restart();
+    GBL_DiffBuffer buffer;
+    for (int i = 0; i < nLines; i++)
+    {
+        buffer.addLine('+', -1, i + 1, pPatch + offsets.at(i), offsets.at(i + 1) - offsets.at(i));
+    }
+    qint64 nNewNs = qMax(timer.nsecsElapsed(), (qint64)1);
+
+    QString sResult = QString("%1 lines, %2 bytes\nper line copies: %3 lines/s\nbuffer: %4 lines/s")
+            .arg(nLines).arg(baPatch.size())
+            .arg((qint64)(nLines * 1000000000.0 / nOldNs))
+            .arg((qint64)(nLines * 1000000000.0 / nNewNs));
+    qDebug() << "diff capture benchmark:" << sResult;
+
+    return sResult;
+}
+#endif
@@ -0,0 +1,95 @@
+#ifndef GBL_DIFFBUFFER_H
+#define GBL_DIFFBUFFER_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QString>
+
+/**
+ * @brief The GBL_Diff_Line struct
+ * one displayed diff line, its text is length bytes at offset in the
+ * buffer's text. Line numbers are -1 where a side has no line.
+ */
+typedef struct GBL_Diff_Line {
+    int offset;
+    int length;
+    int old_line_num;
+    int new_line_num;
+    char origin;
+} GBL_Diff_Line;
+
+// default limits of a file's diff before it is only summarized
+#define GBL_DIFF_MAX_BYTES          (2 * 1024 * 1024)
+#define GBL_DIFF_MAX_LINES          20000
+#define GBL_DIFF_MAX_LINE_LENGTH    2000
+
+/**
+ * @brief The GBL_Diff_Limits struct
+ * a file whose blobs or patch go over any of these is summarized instead of
+ * shown line by line
+ */
+typedef struct GBL_Diff_Limits {
+    qint64 max_bytes;
+    int max_lines;
+    int max_line_length;
+} GBL_Diff_Limits;
+
+class GBL_DiffBuffer;
+
+/**
+ * @brief The GBL_DiffObserver class
+ * told about the lines of a diff while it is being captured
+ */
+class GBL_DiffObserver
+{
+public:
+    virtual ~GBL_DiffObserver() {}
+
+    /**
+     * @brief diffProgress
+     * @param buffer the lines so far
+     * @return false to stop the diff
+     */
+    virtual bool diffProgress(const GBL_DiffBuffer &buffer) = 0;
+};
+
+/**
+ * @brief The GBL_DiffBuffer class
+ * the lines of a diff as raw utf-8 in one block of text plus a packed array
+ * of line records, so a diff takes about as much memory as its text
+ */
+class GBL_DiffBuffer
+{
+public:
+    GBL_DiffBuffer();
+
+    void clear();
+    void setObserver(GBL_DiffObserver *pObserver, int nEvery);
+    bool addLine(char origin, int nOldLine, int nNewLine, const char *pContent, int nLen);
+
+    bool isEmpty() const { return m_lines.isEmpty(); }
+    int lineCount() const { return m_lines.size(); }
+    const GBL_Diff_Line& lineAt(int nLine) const { return m_lines.at(nLine); }
+    QString lineText(int nLine) const;
+    int maxLineLength() const { return m_nMaxLength; }
+    int maxLineNumber() const { return m_nMaxLineNum; }
+    int byteCount() const { return m_text.size(); }
+    bool isLimited() const { return m_bLimited; }
+    void setLimited() { m_bLimited = true; }
+
+#ifdef QT_DEBUG
+    static QString benchmark(int nLines);
+#endif
+
+private:
+    QByteArray m_text;
+    QVector<GBL_Diff_Line> m_lines;
+    int m_nMaxLength;
+    int m_nMaxLineNum;
+    bool m_bLimited;
+    GBL_DiffObserver *m_pObserver;
+    int m_nObserveEvery;
+    int m_nNextObserve;
+};
+
+#endif // GBL_DIFFBUFFER_H
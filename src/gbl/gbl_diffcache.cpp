@@ -0,0 +1,96 @@
+#include "gbl_diffcache.h"
+
+#include <QMutexLocker>
+
+/**
+ * @brief GBL_DiffCache::GBL_DiffCache
+ */
+GBL_DiffCache::GBL_DiffCache()
+{
+    m_cache.setMaxCost(GBL_DIFF_CACHE_MAX_BYTES);
+}
+
+/**
+ * @brief GBL_DiffCache::getInstance
+ * @return the cache shared by all repositories
+ */
+GBL_DiffCache* GBL_DiffCache::getInstance()
+{
+    static GBL_DiffCache cache;
+    return &cache;
+}
+
+/**
+ * @brief GBL_DiffCache::key
+ * @param sOid commit
+ * @param nParent parent index or GBL_DIFF_ALL_PARENTS
+ * @param sPath pathspec, empty for the whole commit
+ * @param nOptions git_diff_option_t flags the diff was made with
+ * @return
+ */
+QString GBL_DiffCache::key(const QString &sOid, int nParent, const QString &sPath, quint32 nOptions)
+{
+    return QString("%1:%2:%3:%4").arg(sOid).arg(nParent).arg(nOptions).arg(sPath);
+}
+
+/**
+ * @brief GBL_DiffCache::find
+ * @param sKey
+ * @param buffer gets the cached diff, shared not copied
+ * @return false on a miss
+ */
+bool GBL_DiffCache::find(const QString &sKey, GBL_DiffBuffer &buffer)
+{
+    QMutexLocker locker(&m_mutex);
+    GBL_DiffBuffer *pBuffer = m_cache.object(sKey);
+    if (!pBuffer)
+    {
+        m_nMisses.ref();
+        return false;
+    }
+
+    m_nHits.ref();
+    buffer = *pBuffer;
+
+    return true;
+}
+
+/**
+ * @brief GBL_DiffCache::insert
+ * a diff bigger than the whole cache isn't kept
+ * @param sKey
+ * @param buffer
+ */
+void GBL_DiffCache::insert(const QString &sKey, const GBL_DiffBuffer &buffer)
+{
+    GBL_DiffBuffer *pBuffer = new GBL_DiffBuffer(buffer);
+    pBuffer->setObserver(Q_NULLPTR, 0);
+    int nCost = buffer.byteCount() + buffer.lineCount() * (int)sizeof(GBL_Diff_Line);
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(sKey, pBuffer, qMax(nCost, 1));
+}
+
+void GBL_DiffCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+int GBL_DiffCache::entryCount()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.count();
+}
+
+int GBL_DiffCache::totalCost()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.totalCost();
+}
+
+int GBL_DiffCache::maxCost()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.maxCost();
+}
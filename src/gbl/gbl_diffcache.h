@@ -0,0 +1,52 @@
+#ifndef GBL_DIFFCACHE_H
+#define GBL_DIFFCACHE_H
+
+#include "gbl_diffbuffer.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QString>
+
+// bytes of diff text and line records kept, least recently used go first
+#define GBL_DIFF_CACHE_MAX_BYTES    (64 * 1024 * 1024)
+
+// parent index of a diff against every parent of a commit
+#define GBL_DIFF_ALL_PARENTS        -1
+
+// option bit of a diff made without size limits
+#define GBL_DIFF_CACHE_FULL         0x80000000u
+
+/**
+ * @brief The GBL_DiffCache class
+ * finished commit diffs, keyed by commit oid, parent, pathspec and diff
+ * options. A commit's diff never changes, so one cache serves every tab and
+ * every diff thread. Buffers are implicitly shared, a hit costs no copy.
+ */
+class GBL_DiffCache
+{
+public:
+    static GBL_DiffCache* getInstance();
+
+    static QString key(const QString &sOid, int nParent, const QString &sPath, quint32 nOptions);
+
+    bool find(const QString &sKey, GBL_DiffBuffer &buffer);
+    void insert(const QString &sKey, const GBL_DiffBuffer &buffer);
+    void clear();
+
+    int hitCount() const { return m_nHits.load(); }
+    int missCount() const { return m_nMisses.load(); }
+    int entryCount();
+    int totalCost();
+    int maxCost();
+
+private:
+    GBL_DiffCache();
+
+    QMutex m_mutex;
+    QCache<QString, GBL_DiffBuffer> m_cache;
+    QAtomicInt m_nHits;
+    QAtomicInt m_nMisses;
+};
+
+#endif // GBL_DIFFCACHE_H
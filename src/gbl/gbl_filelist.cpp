@@ -0,0 +1,272 @@
+#include "gbl_filelist.h"
+
+// arena bytes of removed names kept before the arena is packed
+#define GBL_FILELIST_SLACK_BYTES (64 * 1024)
+
+/**
+ * @brief GBL_FileList::GBL_FileList
+ */
+GBL_FileList::GBL_FileList()
+{
+    m_nNameBytes = 0;
+    m_nLastDir = -1;
+}
+
+void GBL_FileList::clear()
+{
+    m_status.clear();
+    m_dirIds.clear();
+    m_names.clear();
+    m_oids.clear();
+    m_nameArena.clear();
+    m_nNameBytes = 0;
+
+    m_dirs.clear();
+    m_dirKeys.clear();
+    m_dirIndex.clear();
+    m_nLastDir = -1;
+}
+
+void GBL_FileList::reserve(int nFiles)
+{
+    m_status.reserve(nFiles);
+    m_dirIds.reserve(nFiles);
+    m_names.reserve(nFiles);
+    m_oids.reserve(nFiles);
+}
+
+void GBL_FileList::swap(GBL_FileList &other)
+{
+    m_status.swap(other.m_status);
+    m_dirIds.swap(other.m_dirIds);
+    m_names.swap(other.m_names);
+    m_oids.swap(other.m_oids);
+    m_nameArena.swap(other.m_nameArena);
+    qSwap(m_nNameBytes, other.m_nNameBytes);
+
+    m_dirs.swap(other.m_dirs);
+    m_dirKeys.swap(other.m_dirKeys);
+    m_dirIndex.swap(other.m_dirIndex);
+    qSwap(m_nLastDir, other.m_nLastDir);
+}
+
+/**
+ * @brief GBL_FileList::internDir
+ * @param pDir utf-8
+ * @param nLen
+ * @return the number of the sub directory, added the first time it is seen
+ */
+int GBL_FileList::internDir(const char *pDir, int nLen)
+{
+    // files come grouped by directory, most of the time it is the last one again
+    if (m_nLastDir >= 0)
+    {
+        const QByteArray &lastKey = m_dirKeys.at(m_nLastDir);
+        if (lastKey.size() == nLen && memcmp(lastKey.constData(), pDir, nLen) == 0) return m_nLastDir;
+    }
+
+    QHash<QByteArray, int>::const_iterator it = m_dirIndex.constFind(QByteArray::fromRawData(pDir, nLen));
+    if (it != m_dirIndex.constEnd())
+    {
+        m_nLastDir = it.value();
+        return m_nLastDir;
+    }
+
+    QByteArray key(pDir, nLen);
+    m_nLastDir = m_dirs.size();
+    m_dirs.append(QString::fromUtf8(key));
+    m_dirKeys.append(key);
+    m_dirIndex.insert(key, m_nLastDir);
+
+    return m_nLastDir;
+}
+
+/**
+ * @brief GBL_FileList::append
+ * @param pSubDir utf-8, stored as given
+ * @param nSubDirLen
+ * @param pName utf-8
+ * @param nNameLen
+ * @param status GBL_FILE_STATUS_ value
+ * @param pOid Q_NULLPTR if there is none
+ */
+void GBL_FileList::append(const char *pSubDir, int nSubDirLen, const char *pName, int nNameLen, char status, const git_oid *pOid)
+{
+    GBL_File_Name name;
+    name.offset = m_nameArena.size();
+    name.length = nNameLen;
+    m_nameArena.append(pName, nNameLen);
+    m_nNameBytes += nNameLen;
+
+    git_oid oid;
+    if (pOid) git_oid_cpy(&oid, pOid);
+    else memset(&oid, 0, sizeof(oid));
+
+    m_status.append(status);
+    m_dirIds.append(internDir(pSubDir, nSubDirLen));
+    m_names.append(name);
+    m_oids.append(oid);
+}
+
+void GBL_FileList::append(const QString &sSubDir, const QString &sName, char status, const git_oid *pOid)
+{
+    QByteArray baDir = sSubDir.toUtf8();
+    QByteArray baName = sName.toUtf8();
+    append(baDir.constData(), baDir.size(), baName.constData(), baName.size(), status, pOid);
+}
+
+/**
+ * @brief GBL_FileList::appendPath
+ * splits the path the way QFileInfo does, a file at the top of the working
+ * tree is in sub directory "."
+ * @param pPath utf-8
+ * @param status
+ * @param pOid
+ */
+void GBL_FileList::appendPath(const char *pPath, char status, const git_oid *pOid)
+{
+    const char *pSlash = strrchr(pPath, '/');
+    if (pSlash)
+    {
+        append(pPath, pSlash - pPath, pSlash + 1, strlen(pSlash + 1), status, pOid);
+    }
+    else
+    {
+        append(".", 1, pPath, strlen(pPath), status, pOid);
+    }
+}
+
+void GBL_FileList::appendPath(const QString &sPath, char status, const git_oid *pOid)
+{
+    QByteArray baPath = sPath.toUtf8();
+    appendPath(baPath.constData(), status, pOid);
+}
+
+/**
+ * @brief GBL_FileList::insert
+ * @param nIndex where the files go
+ * @param list
+ * @param nFrom first file of list to insert
+ * @param nCount
+ */
+void GBL_FileList::insert(int nIndex, const GBL_FileList &list, int nFrom, int nCount)
+{
+    if (nCount <= 0) return;
+
+    m_status.insert(nIndex, list.m_status.mid(nFrom, nCount));
+    m_dirIds.insert(nIndex, nCount, 0);
+    m_names.insert(nIndex, nCount, GBL_File_Name());
+    m_oids.insert(nIndex, nCount, git_oid());
+
+    for (int i = 0; i < nCount; i++)
+    {
+        const QByteArray &dirKey = list.m_dirKeys.at(list.m_dirIds.at(nFrom + i));
+        const GBL_File_Name &from = list.m_names.at(nFrom + i);
+
+        GBL_File_Name name;
+        name.offset = m_nameArena.size();
+        name.length = from.length;
+        m_nameArena.append(list.m_nameArena.constData() + from.offset, from.length);
+        m_nNameBytes += from.length;
+
+        m_dirIds[nIndex + i] = internDir(dirKey.constData(), dirKey.size());
+        m_names[nIndex + i] = name;
+        m_oids[nIndex + i] = list.m_oids.at(nFrom + i);
+    }
+}
+
+/**
+ * @brief GBL_FileList::remove
+ * @param nIndex
+ * @param nCount
+ */
+void GBL_FileList::remove(int nIndex, int nCount)
+{
+    if (nCount <= 0) return;
+
+    for (int i = nIndex; i < nIndex + nCount; i++)
+    {
+        m_nNameBytes -= m_names.at(i).length;
+    }
+
+    m_status.remove(nIndex, nCount);
+    m_dirIds.remove(nIndex, nCount);
+    m_names.remove(nIndex, nCount);
+    m_oids.remove(nIndex, nCount);
+
+    if (m_nameArena.size() - m_nNameBytes > qMax<qint64>(m_nNameBytes, GBL_FILELIST_SLACK_BYTES)) compact();
+}
+
+/**
+ * @brief GBL_FileList::compact
+ * packs the names still in use to the front of a new arena
+ */
+void GBL_FileList::compact()
+{
+    QByteArray arena;
+    arena.reserve(m_nNameBytes);
+    for (int i = 0; i < m_names.size(); i++)
+    {
+        GBL_File_Name &name = m_names[i];
+        quint32 nOffset = arena.size();
+        arena.append(m_nameArena.constData() + name.offset, name.length);
+        name.offset = nOffset;
+    }
+
+    m_nameArena.swap(arena);
+}
+
+QString GBL_FileList::fileName(int nIndex) const
+{
+    const GBL_File_Name &name = m_names.at(nIndex);
+    return QString::fromUtf8(m_nameArena.constData() + name.offset, name.length);
+}
+
+/**
+ * @brief GBL_FileList::pathKey
+ * @param nIndex
+ * @return the sub directory and name as utf-8, to match files across lists
+ */
+QByteArray GBL_FileList::pathKey(int nIndex) const
+{
+    const GBL_File_Name &name = m_names.at(nIndex);
+    QByteArray key = m_dirKeys.at(m_dirIds.at(nIndex));
+    key.append('/');
+    key.append(m_nameArena.constData() + name.offset, name.length);
+
+    return key;
+}
+
+const git_oid* GBL_FileList::oid(int nIndex) const
+{
+    const git_oid *pOid = &m_oids.at(nIndex);
+    return git_oid_iszero(pOid) ? Q_NULLPTR : pOid;
+}
+
+void GBL_FileList::setOid(int nIndex, const git_oid *pOid)
+{
+    if (pOid) git_oid_cpy(&m_oids[nIndex], pOid);
+    else memset(&m_oids[nIndex], 0, sizeof(git_oid));
+}
+
+QString GBL_FileList::oidString(int nIndex) const
+{
+    const git_oid *pOid = oid(nIndex);
+    return pOid ? QString(git_oid_tostr_s(pOid)) : QString();
+}
+
+/**
+ * @brief GBL_FileList::item
+ * @param nIndex
+ * @return the file decoded
+ */
+GBL_File_Item GBL_FileList::item(int nIndex) const
+{
+    GBL_File_Item fileItem;
+    fileItem.status = status(nIndex);
+    fileItem.file_name = fileName(nIndex);
+    fileItem.sub_dir = subDir(nIndex);
+    fileItem.file_oid = oidString(nIndex);
+
+    return fileItem;
+}
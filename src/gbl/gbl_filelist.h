@@ -0,0 +1,84 @@
+#ifndef GBL_FILELIST_H
+#define GBL_FILELIST_H
+
+#include "gbl_commitstore.h"
+
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief The GBL_File_Item struct
+ * one file of a GBL_FileList, decoded for the views
+ */
+typedef struct GBL_File_Item {
+    char status;
+    QString file_name;
+    QString sub_dir;
+    QString file_oid;
+} GBL_File_Item;
+
+typedef struct GBL_File_Name {
+    quint32 offset;
+    quint32 length;
+} GBL_File_Name;
+
+/**
+ * @brief The GBL_FileList class
+ * columnar storage for the files of a status, a tree or a diff. Sub
+ * directories are interned so each is stored once however many files it
+ * holds, names are kept as utf-8 in a single arena and oids as raw git_oid,
+ * a zero oid where there is none. Nothing is decoded until a view asks for
+ * it, and copies share their data until one of them changes.
+ */
+class GBL_FileList
+{
+public:
+    GBL_FileList();
+
+    void clear();
+    void reserve(int nFiles);
+    void swap(GBL_FileList &other);
+    int size() const { return m_status.size(); }
+    bool isEmpty() const { return m_status.isEmpty(); }
+
+    void append(const char *pSubDir, int nSubDirLen, const char *pName, int nNameLen, char status, const git_oid *pOid = Q_NULLPTR);
+    void append(const QString &sSubDir, const QString &sName, char status, const git_oid *pOid = Q_NULLPTR);
+    void appendPath(const char *pPath, char status, const git_oid *pOid = Q_NULLPTR);
+    void appendPath(const QString &sPath, char status, const git_oid *pOid = Q_NULLPTR);
+    void insert(int nIndex, const GBL_FileList &list, int nFrom, int nCount);
+    void remove(int nIndex, int nCount);
+
+    char status(int nIndex) const { return m_status.at(nIndex); }
+    void setStatus(int nIndex, char status) { m_status[nIndex] = status; }
+    QString fileName(int nIndex) const;
+    QString subDir(int nIndex) const { return m_dirs.at(m_dirIds.at(nIndex)); }
+    QByteArray pathKey(int nIndex) const;
+    const git_oid* oid(int nIndex) const;
+    void setOid(int nIndex, const git_oid *pOid);
+    QString oidString(int nIndex) const;
+    GBL_File_Item item(int nIndex) const;
+
+    int dirId(int nIndex) const { return m_dirIds.at(nIndex); }
+    int dirCount() const { return m_dirs.size(); }
+    QString dir(int nDir) const { return m_dirs.at(nDir); }
+
+private:
+    int internDir(const char *pDir, int nLen);
+    void compact();
+
+    QByteArray m_status;
+    QVector<int> m_dirIds;
+    QVector<GBL_File_Name> m_names;
+    QVector<git_oid> m_oids;
+    QByteArray m_nameArena;
+    qint64 m_nNameBytes;
+
+    QVector<QString> m_dirs;
+    QVector<QByteArray> m_dirKeys;
+    QHash<QByteArray, int> m_dirIndex;
+    int m_nLastDir;
+};
+
+#endif // GBL_FILELIST_H
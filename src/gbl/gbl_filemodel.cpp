@@ -3,13 +3,13 @@
 #include <QPixmap>
 #include <QFileInfo>
 #include <QFileIconProvider>
+#include <QHash>
 
 GBL_FileModel::GBL_FileModel(QObject *parent) : QAbstractItemModel(parent),
     m_addDocIcon(QPixmap(":/images/add_doc_icon.png")), m_removeDocIcon(QPixmap(":/images/remove_doc_icon.png")),
     m_modifyDocIcon(QPixmap(":/images/modify_doc_icon.png")), m_unknownDocIcon(QPixmap(":/images/unknown_doc_icon.png"))
 {
-    m_pFileArr = new GBL_File_Array;
-    m_pHistItem = NULL;
+    m_pFileArr = new GBL_FileList;
     m_headings.append(QString("File"));
     m_headings.append(QString("Path"));
     m_pFileTreeRoot = new GBL_FileTreeItem("");
@@ -26,87 +26,162 @@ void GBL_FileModel::cleanUp()
 {
     QAbstractItemModel::resetInternalData();
 
-    if (m_pFileArr->size())
-    {
-        for (int i = 0; i < m_pFileArr->size(); i++)
-        {
-            GBL_File_Item *pFI = m_pFileArr->at(i);
-            delete pFI;
-        }
-    }
-
     m_pFileArr->clear();
     m_pFileTreeRoot->cleanup();
     layoutChanged();
 }
 
-void GBL_FileModel::addFileItem(GBL_File_Item *pFileItem)
+void GBL_FileModel::setFileArray(GBL_FileList *pArr)
 {
-    m_pFileArr->append(pFileItem);
+    cleanUp();
+
+    // the list shares its data with pArr until one of them changes
+    *m_pFileArr = *pArr;
+
+    // each sub directory is walked down the tree once, its files then go straight in
+    QVector<GBL_FileTreeItem*> dirItems(pArr->dirCount(), Q_NULLPTR);
+    for (int i = 0; i < pArr->size(); i++)
+    {
+        int nDir = pArr->dirId(i);
+        GBL_FileTreeItem *pParent = dirItems.at(nDir);
+        if (pParent == NULL)
+        {
+            pParent = m_pFileTreeRoot;
+
+            QString sSubDir = pArr->dir(nDir);
+            if (sSubDir != ".")
+            {
+                QStringList dirParts = sSubDir.split("/");
+                for (int j = 0; j < dirParts.size(); j++)
+                {
+                    QString sfldr = dirParts.at(j);
+
+                    if (sfldr.isEmpty()) continue;
+
+                    GBL_FileTreeItem *pNewParent = pParent->findChild(sfldr);
+                    if (pNewParent == NULL)
+                    {
+                        pNewParent = new GBL_FileTreeItem(sfldr,-1,pParent);
+                        pParent->addChild(pNewParent);
+                    }
+
+                    pParent = pNewParent;
+                }
+            }
+
+            dirItems[nDir] = pParent;
+        }
+
+        pParent->addChild(new GBL_FileTreeItem("",i,pParent));
+    }
+
     layoutChanged();
 }
 
-void GBL_FileModel::setFileArray(GBL_File_Array *pArr)
+/**
+ * @brief GBL_FileModel::updateFileArray
+ * turns the list into pArr by removing, inserting and changing only the rows
+ * that differ, matched by path, so the view keeps its selection and scroll
+ * position. The tree view, or a list in a different order, is set again.
+ * @param pArr
+ */
+void GBL_FileModel::updateFileArray(GBL_FileList *pArr)
 {
-    cleanUp();
+    if (m_nViewType != GBL_FILETREE_VIEW_TYPE_LIST)
+    {
+        setFileArray(pArr);
+        return;
+    }
 
+    QHash<QByteArray, int> newRows;
+    newRows.reserve(pArr->size());
     for (int i = 0; i < pArr->size(); i++)
     {
-        GBL_File_Item *pItem = pArr->at(i);
-        GBL_File_Item *pNewItem = new GBL_File_Item();
-        pNewItem->file_name = pItem->file_name;
-        pNewItem->file_oid = pItem->file_oid;
-        pNewItem->status = pItem->status;
-        pNewItem->sub_dir = pItem->sub_dir;
-        m_pFileArr->append(pNewItem);
-        if (pItem->sub_dir == ".")
+        newRows.insert(pArr->pathKey(i), i);
+    }
+
+    // the rows kept have to be in the same order in both lists
+    int nLastRow = -1;
+    for (int i = 0; i < m_pFileArr->size(); i++)
+    {
+        int nNewRow = newRows.value(m_pFileArr->pathKey(i), -1);
+        if (nNewRow < 0) continue;
+        if (nNewRow <= nLastRow)
         {
-            m_pFileTreeRoot->addChild(new GBL_FileTreeItem("",i,m_pFileTreeRoot));
+            setFileArray(pArr);
+            return;
         }
-        else
+        nLastRow = nNewRow;
+    }
+
+    // remove the rows that are gone back to front, a run at a time
+    int nRow = m_pFileArr->size() - 1;
+    while (nRow >= 0)
+    {
+        if (newRows.contains(m_pFileArr->pathKey(nRow)))
         {
-            QStringList dirParts = pItem->sub_dir.split("/");
-            GBL_FileTreeItem *pParent = m_pFileTreeRoot;
-            for (int j = 0; j < dirParts.size(); j++)
-            {
-                QString sfldr = dirParts.at(j);
+            nRow--;
+            continue;
+        }
 
-                if (sfldr.isEmpty()) continue;
+        int nLast = nRow;
+        while (nRow > 0 && !newRows.contains(m_pFileArr->pathKey(nRow - 1))) nRow--;
 
-                GBL_FileTreeItem *pNewParent = pParent->findChild(sfldr);
-                if (pNewParent == NULL)
-                {
-                    pNewParent = new GBL_FileTreeItem(sfldr,-1,pParent);
-                    pParent->addChild(pNewParent);
-                }
+        beginRemoveRows(QModelIndex(), nRow, nLast);
+        m_pFileArr->remove(nRow, nLast - nRow + 1);
+        endRemoveRows();
 
-                pParent = pNewParent;
-            }
+        nRow--;
+    }
 
-            pParent->addChild(new GBL_FileTreeItem("",i,pParent));
+    // insert the new rows in front of the next row kept, and update the kept ones
+    nRow = 0;
+    int i = 0;
+    while (i < pArr->size())
+    {
+        int nNext = nRow < m_pFileArr->size() ? newRows.value(m_pFileArr->pathKey(nRow)) : pArr->size();
+        if (nNext > i)
+        {
+            beginInsertRows(QModelIndex(), nRow, nRow + nNext - i - 1);
+            m_pFileArr->insert(nRow, *pArr, i, nNext - i);
+            endInsertRows();
 
+            nRow += nNext - i;
+            i = nNext;
+            continue;
+        }
 
+        const git_oid *pOid = m_pFileArr->oid(nRow);
+        const git_oid *pNewOid = pArr->oid(i);
+        bool bOidChanged = (pOid == Q_NULLPTR) != (pNewOid == Q_NULLPTR) || (pOid && !git_oid_equal(pOid, pNewOid));
+        if (m_pFileArr->status(nRow) != pArr->status(i) || bOidChanged)
+        {
+            m_pFileArr->setStatus(nRow, pArr->status(i));
+            m_pFileArr->setOid(nRow, pNewOid);
+            emit dataChanged(index(nRow, 0), index(nRow, columnCount() - 1));
         }
-    }
 
-    layoutChanged();
+        nRow++;
+        i++;
+    }
 }
 
-GBL_File_Item* GBL_FileModel::getFileItemAt(int index)
+bool GBL_FileModel::getFileItemAt(int index, GBL_File_Item *pFileItem)
 {
-    if (m_pFileArr && index >= 0 && index < m_pFileArr->length())
+    if (m_pFileArr && index >= 0 && index < m_pFileArr->size())
     {
-        return m_pFileArr->at(index);
+        *pFileItem = m_pFileArr->item(index);
+        return true;
     }
-    return NULL;
+    return false;
 }
 
-GBL_File_Item* GBL_FileModel::getFileItemFromModelIndex(const QModelIndex mi)
+bool GBL_FileModel::getFileItemFromModelIndex(const QModelIndex mi, GBL_File_Item *pFileItem)
 {
     switch (m_nViewType)
     {
         case GBL_FILETREE_VIEW_TYPE_LIST:
-            return getFileItemAt(mi.row());
+            return getFileItemAt(mi.row(), pFileItem);
             break;
 
         case GBL_FILETREE_VIEW_TYPE_TREE:
@@ -115,23 +190,23 @@ GBL_File_Item* GBL_FileModel::getFileItemFromModelIndex(const QModelIndex mi)
                 int nIndex = pTreeItem->getArrayIndex();
                 if (nIndex >= 0)
                 {
-                    return m_pFileArr->at(nIndex);
+                    return getFileItemAt(nIndex, pFileItem);
                 }
             }
             break;
     }
 
-    return NULL;
+    return false;
 }
 
 void GBL_FileModel::setHistoryItem(GBL_History_Item *pHistItem)
 {
-    m_pHistItem = pHistItem;
+    m_histItem = *pHistItem;
 }
 
 GBL_History_Item* GBL_FileModel::getHistoryItem()
 {
-    return m_pHistItem;
+    return &m_histItem;
 }
 
 QModelIndex GBL_FileModel::index(int row, int column, const QModelIndex &parent) const
@@ -229,7 +304,7 @@ int GBL_FileModel::columnCount(const QModelIndex &parent) const
 
 QVariant GBL_FileModel::data(const QModelIndex &index, int role) const
 {
-    if (index.row() > (m_pFileArr->length()-1) || index.row() < 0 ) { return QVariant(); }
+    if (index.row() > (m_pFileArr->size()-1) || index.row() < 0 ) { return QVariant(); }
 
     switch (m_nViewType)
     {
@@ -238,19 +313,17 @@ QVariant GBL_FileModel::data(const QModelIndex &index, int role) const
 
             if (role == Qt::DisplayRole)
             {
-                GBL_File_Item *pFileItem = m_pFileArr->at(index.row());
                 switch (index.column())
                 {
                     case 0:
-                        return pFileItem->file_name;
+                        return m_pFileArr->fileName(index.row());
                     case 1:
-                        return pFileItem->sub_dir;
+                        return m_pFileArr->subDir(index.row());
                 }
             }
             else if (role == Qt::DecorationRole && index.column() == 0)
             {
-                GBL_File_Item *pFileItem = m_pFileArr->at(index.row());
-                switch (pFileItem->status)
+                switch (m_pFileArr->status(index.row()))
                 {
                     case GBL_FILE_STATUS_ADDED:
                         return QVariant::fromValue(m_addDocIcon);
@@ -267,7 +340,7 @@ QVariant GBL_FileModel::data(const QModelIndex &index, int role) const
                     case GBL_FILE_STATUS_SYSTEM:
                         {
                             QString sPath = m_sRepoPath;
-                            sPath += "/" + pFileItem->sub_dir + pFileItem->file_name;
+                            sPath += "/" + m_pFileArr->subDir(index.row()) + m_pFileArr->fileName(index.row());
                             QFileIconProvider icnp;
                             //qDebug() << sPath;
                             return QVariant::fromValue(icnp.icon(QFileInfo(sPath)));
@@ -291,8 +364,7 @@ QVariant GBL_FileModel::data(const QModelIndex &index, int role) const
                     QString sName;
                     if (nIndex >= 0)
                     {
-                        GBL_File_Item *pFileItem = m_pFileArr->at(nIndex);
-                        sName = pFileItem->file_name;
+                        sName = m_pFileArr->fileName(nIndex);
                     }
                     else
                     {
@@ -305,9 +377,8 @@ QVariant GBL_FileModel::data(const QModelIndex &index, int role) const
                     QFileIconProvider icnp;
                     if (nIndex >= 0)
                     {
-                        GBL_File_Item *pFileItem = m_pFileArr->at(nIndex);
                         QString sPath = m_sRepoPath;
-                        sPath += "/" + pFileItem->sub_dir + pFileItem->file_name;
+                        sPath += "/" + m_pFileArr->subDir(nIndex) + m_pFileArr->fileName(nIndex);
                         QFileInfo fi(sPath);
                         QIcon icn = fi.isFile() ? icnp.icon(fi) : icnp.icon(QFileIconProvider::File);
                         return QVariant::fromValue(icn);
@@ -347,6 +418,7 @@ GBL_FileTreeItem::GBL_FileTreeItem(QString sFolder, int nIndex, GBL_FileTreeItem
     m_sFolder = sFolder;
     m_pParent = parent;
     m_nIndex = nIndex;
+    m_nRow = -1;
 }
 
 GBL_FileTreeItem::~GBL_FileTreeItem()
@@ -363,22 +435,28 @@ void GBL_FileTreeItem::cleanup()
     }
 
     m_children.clear();
+    m_folderChildren.clear();
 }
 
+/**
+ * @brief GBL_FileTreeItem::addChild
+ * the child keeps its row, and a folder goes in the hash findChild looks in
+ * @param pFileTreeItem
+ */
 void GBL_FileTreeItem::addChild(GBL_FileTreeItem *pFileTreeItem)
 {
+    pFileTreeItem->m_nRow = m_children.size();
     m_children.append(pFileTreeItem);
-}
 
-GBL_FileTreeItem* GBL_FileTreeItem::findChild(QString sFolder)
-{
-    for (int i = 0; i < m_children.size(); i++)
+    if (pFileTreeItem->getArrayIndex() < 0 && !m_folderChildren.contains(pFileTreeItem->getFolder()))
     {
-        GBL_FileTreeItem *pTreeItem = m_children.at(i);
-        if (pTreeItem->getFolder() == sFolder) return pTreeItem;
+        m_folderChildren.insert(pFileTreeItem->getFolder(), pFileTreeItem);
     }
+}
 
-    return NULL;
+GBL_FileTreeItem* GBL_FileTreeItem::findChild(QString sFolder)
+{
+    return m_folderChildren.value(sFolder);
 }
 
 GBL_FileTreeItem* GBL_FileTreeItem::getChildAt(int index)
@@ -390,15 +468,3 @@ GBL_FileTreeItem* GBL_FileTreeItem::getChildAt(int index)
 
     return NULL;
 }
-
-int GBL_FileTreeItem::index()
-{
-    if (m_pParent)
-    {
-        return m_pParent->getChildrenList()->indexOf(this);
-    }
-
-    return -1;
-}
-
-
@@ -7,6 +7,7 @@
 #include <QAbstractItemModel>
 #include "gbl_repository.h"
 #include <QIcon>
+#include <QHash>
 
 QT_BEGIN_NAMESPACE
 class GBL_FileTreeItem;
@@ -27,15 +28,17 @@ public:
     int getArrayIndex() { return m_nIndex; }
     int getChildCount() { return m_children.size(); }
     GBL_FileTreeItem_list* getChildrenList() { return &m_children; }
-    int index();
+    int index() { return m_pParent ? m_nRow : -1; }
     void cleanup();
 
 
 private:
     GBL_FileTreeItem_list m_children;
+    QHash<QString, GBL_FileTreeItem*> m_folderChildren;
     GBL_FileTreeItem *m_pParent;
     QString m_sFolder;
     int m_nIndex;
+    int m_nRow;
 };
 
 class GBL_FileModel : public QAbstractItemModel
@@ -55,11 +58,11 @@ public:
                                 int role = Qt::DisplayRole) const;
 
     void cleanUp();
-    void addFileItem(GBL_File_Item *pFileItem);
-    void setFileArray(GBL_File_Array *pArr);
-    GBL_File_Array* getFileArray() { return m_pFileArr; }
-    GBL_File_Item* getFileItemAt(int index);
-    GBL_File_Item* getFileItemFromModelIndex(const QModelIndex mi);
+    void setFileArray(GBL_FileList *pArr);
+    void updateFileArray(GBL_FileList *pArr);
+    GBL_FileList* getFileArray() { return m_pFileArr; }
+    bool getFileItemAt(int index, GBL_File_Item *pFileItem);
+    bool getFileItemFromModelIndex(const QModelIndex mi, GBL_File_Item *pFileItem);
     void setHistoryItem(GBL_History_Item *pHistItem);
     GBL_History_Item* getHistoryItem();
     void setRepoPath(const QString &path) { m_sRepoPath = path; }
@@ -70,8 +73,8 @@ signals:
 public slots:
 
 private:
-    GBL_File_Array *m_pFileArr;
-    GBL_History_Item *m_pHistItem;
+    GBL_FileList *m_pFileArr;
+    GBL_History_Item m_histItem;
     QVector<QString> m_headings;
     QIcon m_addDocIcon, m_removeDocIcon, m_modifyDocIcon, m_unknownDocIcon;
     QString m_sRepoPath;
@@ -0,0 +1,156 @@
+#include "gbl_graphlayout.h"
+
+/**
+ * @brief GBL_GraphLayout::GBL_GraphLayout
+ */
+GBL_GraphLayout::GBL_GraphLayout()
+{
+}
+
+/**
+ * @brief GBL_GraphLayout::reset
+ * forgets the open lanes, the next row laid out starts a new graph
+ */
+void GBL_GraphLayout::reset()
+{
+    m_laneOids.clear();
+    m_laneActive.clear();
+}
+
+/**
+ * @brief GBL_GraphLayout::layout
+ * lays out every row of the store that has no graph yet. Each lane waits
+ * for one commit; a commit takes the leftmost lane waiting for it, closes
+ * the other lanes waiting for it and hands its lane to its first parent.
+ * Further parents join a lane already waiting for them or open a new one.
+ * @param pStore
+ */
+void GBL_GraphLayout::layout(GBL_CommitStore *pStore)
+{
+    for (int row = pStore->graphRowCount(); row < pStore->size(); row++)
+    {
+        const git_oid &oid = *pStore->oid(row);
+        int nNode = -1;
+        int nPassStart = -1;
+
+        m_segs.resize(0);
+
+        // lines coming in from the row above
+        for (int nLane = 0; nLane < m_laneOids.size(); nLane++)
+        {
+            bool bPass = m_laneActive.at(nLane) && !(m_laneOids.at(nLane) == oid);
+
+            if (bPass)
+            {
+                if (nPassStart < 0) nPassStart = nLane;
+                continue;
+            }
+
+            if (nPassStart >= 0)
+            {
+                m_segs.append(gbl_graph_segment(GBL_GRAPH_SEG_PASS, nPassStart, nLane - 1));
+                nPassStart = -1;
+            }
+
+            if (m_laneActive.at(nLane))
+            {
+                if (nNode < 0) nNode = nLane;
+                m_segs.append(gbl_graph_segment(GBL_GRAPH_SEG_IN, nLane, nNode));
+                if (nLane != nNode) m_laneActive[nLane] = false;
+            }
+        }
+
+        if (nPassStart >= 0)
+        {
+            m_segs.append(gbl_graph_segment(GBL_GRAPH_SEG_PASS, nPassStart, m_laneOids.size() - 1));
+        }
+
+        // nothing waits for a branch tip, give it a lane of its own
+        if (nNode < 0)
+        {
+            nNode = allocLane();
+        }
+
+        int nParents = pStore->parentCount(row);
+        if (nParents == 0)
+        {
+            m_laneActive[nNode] = false;
+        }
+        else
+        {
+            m_laneOids[nNode] = *pStore->parentOid(row, 0);
+            m_segs.append(gbl_graph_segment(GBL_GRAPH_SEG_OUT, nNode, nNode));
+
+            for (int i = 1; i < nParents; i++)
+            {
+                const git_oid &parentOid = *pStore->parentOid(row, i);
+                int nLane = findLane(parentOid);
+                if (nLane < 0)
+                {
+                    nLane = allocLane();
+                    m_laneOids[nLane] = parentOid;
+                }
+
+                m_segs.append(gbl_graph_segment(GBL_GRAPH_SEG_OUT, nNode, nLane));
+            }
+        }
+
+        while (!m_laneActive.isEmpty() && !m_laneActive.last())
+        {
+            m_laneActive.removeLast();
+            m_laneOids.removeLast();
+        }
+
+        pStore->appendGraphRow(nNode, m_segs.constData(), m_segs.size());
+    }
+}
+
+/**
+ * @brief GBL_GraphLayout::isSettledOn
+ * @param oid
+ * @return true if the only open lane is the first one, waiting for oid. Rows
+ * laid out from that state fit on top of a graph that starts at oid.
+ */
+bool GBL_GraphLayout::isSettledOn(const git_oid &oid) const
+{
+    return m_laneActive.size() == 1 && m_laneActive.at(0) && m_laneOids.at(0) == oid;
+}
+
+/**
+ * @brief GBL_GraphLayout::allocLane
+ * @return the leftmost free lane, marked active
+ */
+int GBL_GraphLayout::allocLane()
+{
+    int nLane = m_laneActive.indexOf(false);
+    if (nLane < 0 && m_laneActive.size() <= GBL_GRAPH_MAX_LANE)
+    {
+        nLane = m_laneActive.size();
+        m_laneActive.append(false);
+        m_laneOids.append(git_oid());
+    }
+    else if (nLane < 0)
+    {
+        // out of lanes, share the last one rather than overflow the packing
+        nLane = GBL_GRAPH_MAX_LANE;
+    }
+
+    m_laneActive[nLane] = true;
+
+    return nLane;
+}
+
+/**
+ * @brief GBL_GraphLayout::findLane
+ * @param oid
+ * @return the open lane waiting for oid or -1
+ */
+int GBL_GraphLayout::findLane(const git_oid &oid) const
+{
+    for (int nLane = 0; nLane < m_laneOids.size(); nLane++)
+    {
+        if (m_laneActive.at(nLane) && m_laneOids.at(nLane) == oid) return nLane;
+    }
+
+    return -1;
+}
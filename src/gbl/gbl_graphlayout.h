@@ -0,0 +1,54 @@
+#ifndef GBL_GRAPHLAYOUT_H
+#define GBL_GRAPHLAYOUT_H
+
+#include "gbl_commitstore.h"
+
+#include <QVector>
+
+#define GBL_GRAPH_SEG_PASS 0
+#define GBL_GRAPH_SEG_IN   1
+#define GBL_GRAPH_SEG_OUT  2
+
+#define GBL_GRAPH_MAX_LANE 0x7FFF
+
+/**
+ * segments are packed as 2 bits of type, then 15 bits each for the from and to lane.
+ * PASS is a run of lanes going straight through the row (from..to),
+ * IN runs from the top of lane from to the commit node in lane to,
+ * OUT runs from the commit node in lane from to the bottom of lane to.
+ */
+inline quint32 gbl_graph_segment(int nType, int nFrom, int nTo)
+{
+    return ((quint32)nType << 30) | ((quint32)(nFrom & GBL_GRAPH_MAX_LANE) << 15) | (quint32)(nTo & GBL_GRAPH_MAX_LANE);
+}
+
+inline int gbl_graph_segment_type(quint32 seg) { return seg >> 30; }
+inline int gbl_graph_segment_from(quint32 seg) { return (seg >> 15) & GBL_GRAPH_MAX_LANE; }
+inline int gbl_graph_segment_to(quint32 seg) { return seg & GBL_GRAPH_MAX_LANE; }
+
+/**
+ * @brief The GBL_GraphLayout class
+ * assigns commits to lanes in one pass over the rows of a commit store, in
+ * walk order, and stores each row's node lane and line segments back in the
+ * store. The lane state is kept between calls so pages can be laid out as
+ * they are read.
+ */
+class GBL_GraphLayout
+{
+public:
+    GBL_GraphLayout();
+
+    void reset();
+    void layout(GBL_CommitStore *pStore);
+    bool isSettledOn(const git_oid &oid) const;
+
+private:
+    int allocLane();
+    int findLane(const git_oid &oid) const;
+
+    QVector<git_oid> m_laneOids;
+    QVector<bool> m_laneActive;
+    QVector<quint32> m_segs;
+};
+
+#endif // GBL_GRAPHLAYOUT_H
@@ -8,6 +8,8 @@
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QTimer>
+#include <QElapsedTimer>
 
 #include "src/ui/urlpixmap.h"
 #include "src/ui/mainwindow.h"
@@ -16,88 +18,149 @@
 
 GBL_HistoryModel::GBL_HistoryModel(QObject *parent) : QAbstractTableModel(parent)
 {
-    m_pHistArr = new GBL_History_Array;
+    m_pStore = new GBL_CommitStore;
 
     m_headings.append(tr("Graph"));
     m_headings.append(tr("Summary"));
     m_headings.append(tr("Author"));
     m_headings.append(tr("Date"));
-    m_colMap["graph"] = 0;
-    m_colMap["summary"] = 1;
-    m_colMap["author"] = 2;
-    m_colMap["date"] = 3;
+
+    m_bMoreHistory = false;
+    m_bFetching = false;
+
+    m_nPrefetchRow = 0;
+    m_nPrefetchEnd = 0;
+    m_pPrefetchTimer = new QTimer(this);
+    m_pPrefetchTimer->setSingleShot(true);
+    m_pPrefetchTimer->setInterval(0);
+    connect(m_pPrefetchTimer, &QTimer::timeout, this, &GBL_HistoryModel::prefetchBatch);
 }
 
 GBL_HistoryModel::~GBL_HistoryModel()
 {
-    cleanupHistory();
-
-
-    delete m_pHistArr;
+    delete m_pStore;
 }
 
 void GBL_HistoryModel::cleanupHistory()
 {
-    if (m_pHistArr)
+    if (m_pStore)
     {
-        for (int i = 0; i < m_pHistArr->size(); i++)
-        {
-            GBL_History_Item *pHI = m_pHistArr->at(i);
-            delete pHI;
-        }
-
-        m_pHistArr->clear();
+        m_pStore->clear();
     }
 
-    m_histMap.clear();
+    clearRenderCache();
+}
+
+void GBL_HistoryModel::clearRenderCache()
+{
+    m_summaryCache.clear();
+    m_dateCache.clear();
+    m_authorCache.clear();
+    m_avatarCache.clear();
+
+    m_nPrefetchRow = 0;
+    m_nPrefetchEnd = 0;
+    if (m_pPrefetchTimer) m_pPrefetchTimer->stop();
 }
 
 
 void GBL_HistoryModel::reset()
 {
-    QAbstractItemModel::resetInternalData();
+    beginResetModel();
 
     cleanupHistory();
+    m_bMoreHistory = false;
+    m_bFetching = false;
+
+    endResetModel();
 }
 
-void GBL_HistoryModel::addHistoryItem(GBL_History_Item *pHistItem)
+/**
+ * @brief GBL_HistoryModel::addHistoryPage
+ * appends a page of history read by the history thread
+ * @param pPage
+ * @param bMore true if the walk has more commits to give
+ */
+void GBL_HistoryModel::addHistoryPage(GBL_CommitStore *pPage, bool bMore)
 {
-    GBL_History_Item *pNewHistItem = new GBL_History_Item;
-    pNewHistItem->hist_author = pHistItem->hist_author;
-    pNewHistItem->hist_author_email = pHistItem->hist_author_email;
-    pNewHistItem->hist_datetime = pHistItem->hist_datetime;
-    pNewHistItem->hist_message = pHistItem->hist_message;
-    pNewHistItem->hist_oid = pHistItem->hist_oid;
-    pNewHistItem->hist_parents = pHistItem->hist_parents;
-    pNewHistItem->hist_summary = pHistItem->hist_summary;
+    m_bFetching = false;
+    m_bMoreHistory = bMore;
+
+    if (pPage->isEmpty()) return;
 
-    m_pHistArr->append(pNewHistItem);
-    m_histMap.insert(pHistItem->hist_oid, m_pHistArr->size()-1);
+    MainWindow *pMain = MainWindow::getInstance();
+    int nFirst = m_pStore->size();
+    int nNew = m_pStore->countNew(*pPage);
+    if (nNew == 0) return;
+
+    beginInsertRows(QModelIndex(), nFirst, nFirst + nNew - 1);
+
+    m_pStore->append(*pPage);
+
+    endInsertRows();
+
+    // one avatar per author rather than per commit
+    for (int i = 0; i < pPage->authorCount(); i++)
+    {
+        QString sEmail = pPage->authorEmail(i).toLower();
+        pMain->addAvatar(sEmail);
+    }
+
+    // the columns only show up once there is history
+    if (nFirst == 0) layoutChanged();
+
+    pMain->startAvatarDownload();
 }
 
-void GBL_HistoryModel::historyUpdated()
+/**
+ * @brief GBL_HistoryModel::prependHistoryPage
+ * puts commits made since the last load on top, keeping the rows below
+ * @param pPage
+ */
+void GBL_HistoryModel::prependHistoryPage(GBL_CommitStore *pPage)
 {
-    if (m_pHistArr && !m_pHistArr->isEmpty())
-    {
-        MainWindow *pMain = MainWindow::getInstance();
+    if (pPage->isEmpty()) return;
 
-        for (int i = 0; i < m_pHistArr->size(); i++)
-        {
-            GBL_History_Item *pHistItem = m_pHistArr->at(i);
-            m_histMap.insert(pHistItem->hist_oid, i);
-            QString sEmail = pHistItem->hist_author_email.toLower();
-            pMain->addAvatar(sEmail);
-            /*else
-            {
-                qDebug() << "avatarMap.contains = true";
-            }*/
-        }
+    MainWindow *pMain = MainWindow::getInstance();
+    bool bWasEmpty = m_pStore->isEmpty();
 
-        //qDebug() << "avatarMap.size:" << m_avatarMap.size();
+    beginInsertRows(QModelIndex(), 0, pPage->size() - 1);
 
-        pMain->startAvatarDownload();
-        layoutChanged();
+    m_pStore->prepend(*pPage);
+
+    // rows formatted so far move down with the rows they belong to
+    if (!m_summaryCache.isEmpty()) m_summaryCache.insert(0, pPage->size(), QString());
+    if (!m_dateCache.isEmpty()) m_dateCache.insert(0, pPage->size(), QString());
+
+    endInsertRows();
+
+    // the old tip now has a line coming in from the rows above
+    if (!bWasEmpty) emit dataChanged(index(pPage->size(), 0), index(pPage->size(), 0));
+
+    for (int i = 0; i < pPage->authorCount(); i++)
+    {
+        QString sEmail = pPage->authorEmail(i).toLower();
+        pMain->addAvatar(sEmail);
     }
+
+    if (bWasEmpty) layoutChanged();
+
+    pMain->startAvatarDownload();
+}
+
+bool GBL_HistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return false;
+
+    return m_bMoreHistory && !m_bFetching;
+}
+
+void GBL_HistoryModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) return;
+
+    m_bFetching = true;
+    emit historyFetchMore();
 }
 
 
@@ -112,9 +175,9 @@ int GBL_HistoryModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
 
-    if (m_pHistArr)
+    if (m_pStore)
     {
-        return m_pHistArr->length();
+        return m_pStore->size();
     }
 
     return 0;
@@ -123,44 +186,61 @@ int GBL_HistoryModel::rowCount(const QModelIndex &parent) const
 int GBL_HistoryModel::columnCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    if (m_pHistArr && m_pHistArr->length()) return m_headings.size();
+    if (m_pStore && m_pStore->size()) return m_headings.size();
 
     return 0;
 }
 
-GBL_History_Item* GBL_HistoryModel::getHistoryItemAt(int index)
+/**
+ * @brief GBL_HistoryModel::getHistoryItemAt
+ * fills in the details of one commit kept in the store, the message is
+ * not kept and is left for the caller to read from the repository
+ * @param index
+ * @param histItem
+ * @return false if index is out of range
+ */
+bool GBL_HistoryModel::getHistoryItemAt(int index, GBL_History_Item &histItem)
 {
-    if (m_pHistArr && index >= 0 && index < m_pHistArr->length())
+    if (!m_pStore || index < 0 || index >= m_pStore->size()) return false;
+
+    int nAuthor = m_pStore->authorId(index);
+    histItem.hist_oid = m_pStore->oidString(index);
+    histItem.hist_summary = m_pStore->summary(index);
+    histItem.hist_message.clear();
+    histItem.hist_datetime = m_pStore->dateTime(index);
+    histItem.hist_author = m_pStore->author(index);
+    histItem.hist_author_email = m_pStore->authorEmail(nAuthor);
+    histItem.hist_parents.clear();
+    for (int i = 0; i < m_pStore->parentCount(index); i++)
     {
-        return m_pHistArr->at(index);
+        histItem.hist_parents.append(QString(git_oid_tostr_s(m_pStore->parentOid(index, i))));
     }
-    return NULL;
+
+    return true;
 }
 
 QVariant GBL_HistoryModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || !m_pHistArr) { return QVariant(); }
-    if (index.row() > (m_pHistArr->length() -1) || index.row() < 0 ) { return QVariant(); }
+    if (!index.isValid() || !m_pStore) { return QVariant(); }
+    if (index.row() > (m_pStore->size() -1) || index.row() < 0 ) { return QVariant(); }
 
     if (role == Qt::DisplayRole)
     {
-        GBL_History_Item *pHistItem = m_pHistArr->at(index.row());
-        if  (index.column() == m_colMap["summary"])
-            return pHistItem->hist_summary;
-        else if (index.column() == m_colMap["author"])
-            return pHistItem->hist_author;
-        else if (index.column() == m_colMap["date"])
-            return pHistItem->hist_datetime.toString("M/d/yyyy h:mm ap");
-
+        switch (index.column())
+        {
+            case GBL_HISTORY_COL_SUMMARY:
+                return cachedSummary(index.row());
+            case GBL_HISTORY_COL_AUTHOR:
+                return cachedAuthor(index.row());
+            case GBL_HISTORY_COL_DATE:
+                return cachedDate(index.row());
+        }
     }
     else if (role == Qt::DecorationRole)
     {
-        if (index.column() == m_colMap["author"])
+        if (index.column() == GBL_HISTORY_COL_AUTHOR)
         {
-            GBL_History_Item *pHistItem = m_pHistArr->at(index.row());
-            QString sEmail = pHistItem->hist_author_email;
-            MainWindow *pMain = MainWindow::getInstance();
-            QPixmap *pPixMap = pMain->getAvatar(sEmail,true);
+            QPixmap *pPixMap = cachedAvatar(index.row());
 
             if (pPixMap) return QVariant::fromValue(*(pPixMap));
 
@@ -170,6 +250,179 @@ QVariant GBL_HistoryModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+/**
+ * @brief GBL_HistoryModel::cachedSummary
+ * @param row
+ * @return the summary of row, decoded from the store the first time it is shown
+ */
+const QString& GBL_HistoryModel::cachedSummary(int row) const
+{
+    if (m_summaryCache.size() < m_pStore->size()) m_summaryCache.resize(m_pStore->size());
+
+    QString &sSummary = m_summaryCache[row];
+    if (sSummary.isNull()) sSummary = m_pStore->summary(row);
+
+    return sSummary;
+}
+
+/**
+ * @brief GBL_HistoryModel::cachedAuthor
+ * @param row
+ * @return the "name <email>" string of the author of row, built once per author
+ */
+const QString& GBL_HistoryModel::cachedAuthor(int row) const
+{
+    int nAuthor = m_pStore->authorId(row);
+    if (m_authorCache.size() < m_pStore->authorCount()) m_authorCache.resize(m_pStore->authorCount());
+
+    QString &sAuthor = m_authorCache[nAuthor];
+    if (sAuthor.isNull()) sAuthor = m_pStore->author(row);
+
+    return sAuthor;
+}
+
+/**
+ * @brief GBL_HistoryModel::cachedDate
+ * @param row
+ * @return the commit time of row, formatted the first time it is shown
+ */
+const QString& GBL_HistoryModel::cachedDate(int row) const
+{
+    if (m_dateCache.size() < m_pStore->size()) m_dateCache.resize(m_pStore->size());
+
+    QString &sDate = m_dateCache[row];
+    if (sDate.isNull()) sDate = m_pStore->dateTime(row).toString("M/d/yyyy h:mm ap");
+
+    return sDate;
+}
+
+/**
+ * @brief GBL_HistoryModel::cachedAvatar
+ * @param row
+ * @return the small avatar of the author of row. The avatar is looked up
+ * by email once per author, after that only its pixmap is asked for.
+ */
+QPixmap* GBL_HistoryModel::cachedAvatar(int row) const
+{
+    MainWindow *pMain = MainWindow::getInstance();
+    if (!pMain) return Q_NULLPTR;
+
+    int nAuthor = m_pStore->authorId(row);
+    if (m_avatarCache.size() < m_pStore->authorCount()) m_avatarCache.resize(m_pStore->authorCount());
+
+    UrlPixmap *pAvatar = m_avatarCache.at(nAuthor);
+    if (!pAvatar)
+    {
+        pAvatar = pMain->getAvatarHandle(m_pStore->authorEmail(nAuthor));
+        m_avatarCache[nAuthor] = pAvatar;
+    }
+
+    return pMain->getAvatar(pAvatar, true);
+}
+
+/**
+ * @brief GBL_HistoryModel::prefetchRows
+ * formats the rows in range from the event loop a batch at a time, so they
+ * are ready by the time the view paints them
+ * @param nFirst
+ * @param nLast
+ */
+void GBL_HistoryModel::prefetchRows(int nFirst, int nLast)
+{
+    m_nPrefetchRow = qMax(nFirst, 0);
+    m_nPrefetchEnd = qMin(nLast + 1, m_pStore->size());
+
+    if (m_nPrefetchRow < m_nPrefetchEnd) m_pPrefetchTimer->start();
+}
+
+void GBL_HistoryModel::prefetchBatch()
+{
+    int nEnd = qMin(qMin(m_nPrefetchEnd, m_pStore->size()), m_nPrefetchRow + GBL_HISTORY_PREFETCH_BATCH);
+
+    for (; m_nPrefetchRow < nEnd; m_nPrefetchRow++)
+    {
+        cachedSummary(m_nPrefetchRow);
+        cachedAuthor(m_nPrefetchRow);
+        cachedDate(m_nPrefetchRow);
+        cachedAvatar(m_nPrefetchRow);
+    }
+
+    if (m_nPrefetchRow < qMin(m_nPrefetchEnd, m_pStore->size())) m_pPrefetchTimer->start();
+}
+
+#ifdef QT_DEBUG
+/**
+ * @brief GBL_HistoryModel::benchmark
+ * fills a model with a synthetic linear history and times data() over every
+ * display cell, once cold and once with the render caches filled
+ * @param nRows
+ * @return a summary of the calls per second
+ */
+QString GBL_HistoryModel::benchmark(int nRows)
+{
+    GBL_HistoryModel model;
+    GBL_CommitStore *pStore = model.m_pStore;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<int> authors;
+    for (int i = 0; i < 1000; i++)
+    {
+        QByteArray baName = QByteArray("Author ") + QByteArray::number(i);
+        QByteArray baEmail = QByteArray("author") + QByteArray::number(i) + "@example.com";
+        authors.append(pStore->addAuthor(baName.constData(), baEmail.constData()));
+    }
+
+    pStore->reserve(nRows);
+    qint64 nTime = QDateTime::currentDateTime().toTime_t();
+    for (int row = 0; row < nRows; row++)
+    {
+        git_oid oid, parentOid;
+        memset(&oid, 0, sizeof(oid));
+        memset(&parentOid, 0, sizeof(parentOid));
+        int nParent = row + 1;
+        memcpy(oid.id, &row, sizeof(row));
+        memcpy(parentOid.id, &nParent, sizeof(nParent));
+
+        pStore->appendCommit(oid, authors.at(row % authors.size()), nTime - row * 60, "Synthetic commit summary used to time the history model");
+        if (nParent < nRows) pStore->appendParent(parentOid);
+    }
+
+    qint64 nFillMs = timer.elapsed();
+
+    const int cols[] = { GBL_HISTORY_COL_SUMMARY, GBL_HISTORY_COL_AUTHOR, GBL_HISTORY_COL_DATE };
+    qint64 nPassNs[2];
+    qint64 nCalls = 0;
+    for (int nPass = 0; nPass < 2; nPass++)
+    {
+        nCalls = 0;
+        timer.restart();
+        for (int row = 0; row < nRows; row++)
+        {
+            for (int col = 0; col < 3; col++)
+            {
+                QModelIndex index = model.index(row, cols[col]);
+                model.data(index, Qt::DisplayRole);
+                nCalls++;
+            }
+
+            model.data(model.index(row, GBL_HISTORY_COL_AUTHOR), Qt::DecorationRole);
+            nCalls++;
+        }
+        nPassNs[nPass] = qMax(timer.nsecsElapsed(), (qint64)1);
+    }
+
+    QString sResult = QString("%1 rows filled in %2 ms\n%3 data() calls per pass\ncold: %4 calls/s\nwarm: %5 calls/s")
+            .arg(nRows).arg(nFillMs).arg(nCalls)
+            .arg((qint64)(nCalls * 1000000000.0 / nPassNs[0]))
+            .arg((qint64)(nCalls * 1000000000.0 / nPassNs[1]));
+    qDebug() << "history model benchmark:" << sResult;
+
+    return sResult;
+}
+#endif
+
 QVariant GBL_HistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (role == Qt::DisplayRole && orientation == Qt::Horizontal)
@@ -4,9 +4,19 @@
 #include <QAbstractItemModel>
 #include "src/gbl/gbl_repository.h"
 
+#define GBL_HISTORY_COL_GRAPH   0
+#define GBL_HISTORY_COL_SUMMARY 1
+#define GBL_HISTORY_COL_AUTHOR  2
+#define GBL_HISTORY_COL_DATE    3
+
+#define GBL_HISTORY_PREFETCH_BATCH 256
+
 QT_BEGIN_NAMESPACE
+class QTimer;
 QT_END_NAMESPACE
 
+class UrlPixmap;
+
 class GBL_HistoryModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -21,24 +31,53 @@ public:
     Q_INVOKABLE virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     Q_INVOKABLE virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
     //Q_INVOKABLE virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    virtual bool canFetchMore(const QModelIndex &parent) const override;
+    virtual void fetchMore(const QModelIndex &parent) override;
 
-    //void setModelData(GBL_History_Array *pHistArr);
-    void historyUpdated();
-    GBL_History_Array* getHistoryArray() { return m_pHistArr; }
-    GBL_History_Item* getHistoryItemAt(int index);
+    const GBL_CommitStore* getCommitStore() const { return m_pStore; }
+    bool getHistoryItemAt(int index, GBL_History_Item &histItem);
     void reset();
-    void addHistoryItem(GBL_History_Item *pHistItem);
+    void addHistoryPage(GBL_CommitStore *pPage, bool bMore);
+    void prependHistoryPage(GBL_CommitStore *pPage);
+    void prefetchRows(int nFirst, int nLast);
+
+#ifdef QT_DEBUG
+    static QString benchmark(int nRows);
+#endif
+
+signals:
+    void historyFetchMore();
 
 public slots:
 
+private slots:
+    void prefetchBatch();
+
 private:
     void cleanupHistory();
     void cleanupAvatars();
+    void clearRenderCache();
+    const QString& cachedSummary(int row) const;
+    const QString& cachedAuthor(int row) const;
+    const QString& cachedDate(int row) const;
+    QPixmap* cachedAvatar(int row) const;
 
-    GBL_History_Array *m_pHistArr;
-    QMap<QString,int> m_histMap;
+    GBL_CommitStore *m_pStore;
     QVector<QString> m_headings;
-    QMap<QString, int> m_colMap;
+    bool m_bMoreHistory;
+    bool m_bFetching;
+
+    // display strings are formatted once, on first paint or by the prefetch
+    // timer for rows near the visible ones, and kept until reset. summaries and
+    // dates by row, author strings and avatars by interned author.
+    mutable QVector<QString> m_summaryCache;
+    mutable QVector<QString> m_dateCache;
+    mutable QVector<QString> m_authorCache;
+    mutable QVector<UrlPixmap*> m_avatarCache;
+
+    QTimer *m_pPrefetchTimer;
+    int m_nPrefetchRow;
+    int m_nPrefetchEnd;
 };
 
 #endif // GBL_HISTORYMODEL_H
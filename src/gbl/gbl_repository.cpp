@@ -3,6 +3,9 @@
 #include <QDebug>
 #include <QByteArray>
 #include <QFileInfo>
+#include <QElapsedTimer>
+#include <QVarLengthArray>
+#include <limits.h>
 //#include "libgit2/include/git2/sys/repository.h"
 
 #include "gbl_filemodel.h"
@@ -16,6 +19,112 @@ static char git_buf__initbuf[1];
 
 static QByteArrayList g_temp_balist;
 
+/* the parts of a raw commit object the history view needs */
+typedef struct GBL_Raw_Commit {
+    QVarLengthArray<git_oid, 4> parents;
+    const char *name;
+    int name_len;
+    const char *email;
+    int email_len;
+    qint64 time;
+    QByteArray summary;
+} GBL_Raw_Commit;
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * @brief parse_raw_commit
+ * reads parents, author, author time and summary straight from the commit
+ * object buffer. The summary follows git_commit_summary: the first paragraph
+ * with whitespace runs kept and line breaks turned into spaces.
+ * @param pData
+ * @param nSize
+ * @param rc
+ * @return false if the buffer doesn't look like a commit
+ */
+static bool parse_raw_commit(const char *pData, size_t nSize, GBL_Raw_Commit &rc)
+{
+    const char *p = pData;
+    const char *pEnd = pData + nSize;
+    bool bAuthor = false;
+
+    rc.parents.clear();
+    rc.summary.truncate(0);
+
+    // header lines run up to the blank line before the message
+    while (p < pEnd && *p != '\n')
+    {
+        const char *pEol = (const char*)memchr(p, '\n', pEnd - p);
+        if (!pEol) return false;
+
+        if (pEol - p >= 7 + GIT_OID_HEXSZ && memcmp(p, "parent ", 7) == 0)
+        {
+            git_oid parent;
+            if (git_oid_fromstrn(&parent, p + 7, GIT_OID_HEXSZ) < 0) return false;
+            rc.parents.append(parent);
+        }
+        else if (!bAuthor && pEol - p > 7 && memcmp(p, "author ", 7) == 0)
+        {
+            const char *pName = p + 7;
+            const char *pLt = (const char*)memchr(pName, '<', pEol - pName);
+            if (!pLt) return false;
+            const char *pGt = (const char*)memchr(pLt, '>', pEol - pLt);
+            if (!pGt) return false;
+
+            const char *pNameEnd = pLt;
+            while (pNameEnd > pName && pNameEnd[-1] == ' ') pNameEnd--;
+            rc.name = pName;
+            rc.name_len = pNameEnd - pName;
+            rc.email = pLt + 1;
+            rc.email_len = pGt - pLt - 1;
+
+            const char *pTime = pGt + 1;
+            while (pTime < pEol && *pTime == ' ') pTime++;
+            rc.time = 0;
+            while (pTime < pEol && *pTime >= '0' && *pTime <= '9')
+            {
+                rc.time = rc.time * 10 + (*pTime++ - '0');
+            }
+
+            bAuthor = true;
+        }
+
+        p = pEol + 1;
+    }
+
+    if (!bAuthor) return false;
+
+    // step over the blank line and any leading newlines of the message
+    while (p < pEnd && *p == '\n') p++;
+
+    const char *pSpace = Q_NULLPTR;
+    for (; p < pEnd && *p; p++)
+    {
+        if (*p == '\n' && (p + 1 == pEnd || p[1] == '\n' || p[1] == '\0'))
+        {
+            break;
+        }
+        else if (is_space(*p))
+        {
+            if (!pSpace) pSpace = p;
+        }
+        else
+        {
+            for (; pSpace && pSpace < p; pSpace++)
+            {
+                rc.summary.append(*pSpace == '\n' ? ' ' : *pSpace);
+            }
+            pSpace = Q_NULLPTR;
+            rc.summary.append(*p);
+        }
+    }
+
+    return true;
+}
+
 GBL_Repository::GBL_Repository(QObject *parent) : QObject(parent)
 {
     git_libgit2_init();
@@ -301,6 +410,15 @@ bool GBL_Repository::is_bare()
     return git_repository_is_bare(m_pRepo);
 }
 
+/**
+ * @brief GBL_Repository::get_git_dir
+ * @return the path of the repository's .git directory
+ */
+QString GBL_Repository::get_git_dir()
+{
+    return QString::fromUtf8(git_repository_path(m_pRepo));
+}
+
 bool GBL_Repository::get_remotes(QStringList &remote_list)
 {
     git_strarray remotes = {0};
@@ -821,80 +939,302 @@ QStringList GBL_Repository::getBranchNames()
 
 
 /**
- * @brief GBL_Repository::get_history
- * @param pHist_Arr
+ * @brief GBL_Repository::history_walk_begin
+ * starts a walk from HEAD, leaving out everything reachable from hideOids
+ * @param pWalker
+ * @param hideOids
  * @return
  */
-bool GBL_Repository::get_history(GBL_History_Array *io_pHistArr)
+bool GBL_Repository::history_walk_begin(git_revwalk **pWalker, const QVector<git_oid> &hideOids)
 {
-    git_revwalk *walker;
-    git_oid oid;
-    const git_oid *poid;
+    *pWalker = Q_NULLPTR;
+    m_nCommitCount = 0;
 
     try
     {
-        int nMaxRevs = 300;
-        m_nCommitCount = 0;
+        check_libgit_return(git_revwalk_new(pWalker, m_pRepo));
+        check_libgit_return(git_revwalk_push_head(*pWalker));
+        for (int i = 0; i < hideOids.size(); i++)
+        {
+            check_libgit_return(git_revwalk_hide(*pWalker, &hideOids.at(i)));
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+
+        if (*pWalker)
+        {
+            git_revwalk_free(*pWalker);
+            *pWalker = Q_NULLPTR;
+        }
+    }
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::history_walk_from
+ * starts a walk from the given commits, used to carry on below cached history
+ * @param pWalker
+ * @param startOids
+ * @return
+ */
+bool GBL_Repository::history_walk_from(git_revwalk **pWalker, const QVector<git_oid> &startOids)
+{
+    *pWalker = Q_NULLPTR;
 
-        check_libgit_return(git_revwalk_new(&walker, m_pRepo));
-        check_libgit_return(git_revwalk_push_head(walker));
-        //check_libgit_return(git_revwalk_push_range(walker, "HEAD~300..HEAD"));
+    try
+    {
+        check_libgit_return(git_revwalk_new(pWalker, m_pRepo));
+        for (int i = 0; i < startOids.size(); i++)
+        {
+            check_libgit_return(git_revwalk_push(*pWalker, &startOids.at(i)));
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
 
-        while (!git_revwalk_next(&oid, walker))
+        if (*pWalker)
         {
-            if (m_nCommitCount < nMaxRevs)
-            {
-                git_commit *pCommit = nullptr, *pParentCommit = nullptr;
-                git_commit_lookup(&pCommit, m_pRepo, &oid);
-
-                QString soid(git_oid_tostr_s(&oid));
-                GBL_History_Item *pHistItem = new GBL_History_Item;
-                pHistItem->hist_oid = soid;
-                pHistItem->hist_summary = QString(git_commit_summary(pCommit));
-                pHistItem->hist_message = QString(git_commit_message(pCommit));
-                const git_signature *pGit_Sig = git_commit_author(pCommit);
-                QString author;
-                QTextStream(&author) << QString::fromUtf8(pGit_Sig->name) << " <" << pGit_Sig->email << ">";
-                pHistItem->hist_author = author;
-                pHistItem->hist_author_email = QString(pGit_Sig->email);
-                pHistItem->hist_datetime = QDateTime::fromTime_t(pGit_Sig->when.time);
-
-                int nParentCount = git_commit_parentcount(pCommit);
-                if (nParentCount > 0)
-                {
-                    for (int i = 0; i < nParentCount; i++)
-                    {
-                        git_commit_parent(&pParentCommit, pCommit, i);
-                        poid = git_commit_id(pParentCommit);
-                        pHistItem->hist_parents.append(QString(git_oid_tostr_s(poid)));
-                        git_commit_free(pParentCommit);
-                    }
-                }
+            git_revwalk_free(*pWalker);
+            *pWalker = Q_NULLPTR;
+        }
+    }
 
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::get_head_oid
+ * @param oid commit HEAD points at
+ * @param sRefName full name of the HEAD reference, "HEAD" when detached
+ * @return
+ */
+bool GBL_Repository::get_head_oid(git_oid &oid, QString &sRefName)
+{
+    git_reference *pHeadRef = Q_NULLPTR;
 
-                io_pHistArr->append(pHistItem);
+    try
+    {
+        check_libgit_return(git_repository_head(&pHeadRef, m_pRepo));
+        check_libgit_return(git_reference_name_to_id(&oid, m_pRepo, git_reference_name(pHeadRef)));
+        sRefName = QString::fromUtf8(git_reference_name(pHeadRef));
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
 
-                //qDebug() << pHistItem->hist_summary << pHistItem->hist_author << pHistItem->hist_datetime;
+    if (pHeadRef) git_reference_free(pHeadRef);
 
-                // free the commit
-                git_commit_free(pCommit);
-            }
+    return m_iErrorCode >= 0;
+}
 
-            m_nCommitCount++;
-        }
+/**
+ * @brief GBL_Repository::is_descendant_of
+ * @param commit
+ * @param ancestor
+ * @return true if ancestor is reachable from commit
+ */
+bool GBL_Repository::is_descendant_of(const git_oid &commit, const git_oid &ancestor)
+{
+    return git_graph_descendant_of(m_pRepo, &commit, &ancestor) == 1;
+}
+
+/**
+ * @brief GBL_Repository::get_commit_message
+ * @param oid_str
+ * @param sMessage
+ * @return
+ */
+bool GBL_Repository::get_commit_message(GBL_String oid_str, QString &sMessage)
+{
+    git_commit *pCommit = Q_NULLPTR;
+    git_oid oid;
 
+    try
+    {
+        check_libgit_return(git_oid_fromstr(&oid, oid_str.toConstChar()));
+        check_libgit_return(git_commit_lookup(&pCommit, m_pRepo, &oid));
+        sMessage = QString::fromUtf8(git_commit_message(pCommit));
     }
     catch(GBL_RepositoryException &e)
     {
+        Q_UNUSED(e);
     }
 
-    qDebug() << "commit count:" << m_nCommitCount;
+    if (pCommit) git_commit_free(pCommit);
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::get_history
+ * reads at most nMaxRevs commits from a walk started with history_walk_begin,
+ * leaving the walker positioned after the last commit read.
+ * @param pWalker
+ * @param io_pStore
+ * @param nMaxRevs
+ * @param bMore set when the page filled up and the walk may continue
+ * @return
+ */
+bool GBL_Repository::get_history(git_revwalk *pWalker, GBL_CommitStore *io_pStore, int nMaxRevs, bool &bMore)
+{
+    git_oid oid;
+    git_odb *pOdb = Q_NULLPTR;
+    GBL_Raw_Commit rawCommit;
+    int nRevs = 0;
+
+    bMore = false;
+    m_iErrorCode = 0;
+
+    if (!pWalker) return false;
+
+    // without an odb every commit goes through git_commit_lookup
+    if (git_repository_odb(&pOdb, m_pRepo) < 0) pOdb = Q_NULLPTR;
+    rawCommit.summary.reserve(256);
+
+    while (nRevs < nMaxRevs && !git_revwalk_next(&oid, pWalker))
+    {
+        if (!(pOdb && read_raw_commit(pOdb, oid, &rawCommit, io_pStore)) && !read_commit(oid, io_pStore)) continue;
+
+        nRevs++;
+    }
 
-    if (walker) git_revwalk_free(walker);
+    if (pOdb) git_odb_free(pOdb);
+
+    m_nCommitCount += nRevs;
+    bMore = nRevs == nMaxRevs;
+
+    qDebug() << "commit count:" << m_nCommitCount;
 
     return m_iErrorCode >= 0;
 }
 
+#ifdef QT_DEBUG
+/**
+ * @brief GBL_Repository::history_benchmark
+ * walks the first nCommits commits from HEAD twice, once parsing the raw odb
+ * objects and once through git_commit_lookup, and times the reads alone
+ * @param nCommits
+ * @return a summary of the cost per commit of each path
+ */
+QString GBL_Repository::history_benchmark(int nCommits)
+{
+    QVector<git_oid> oids;
+    git_revwalk *pWalker = Q_NULLPTR;
+    git_oid oid;
+
+    if (!history_walk_begin(&pWalker)) return get_error_msg();
+
+    oids.reserve(nCommits);
+    while (oids.size() < nCommits && !git_revwalk_next(&oid, pWalker))
+    {
+        oids.append(oid);
+    }
+    git_revwalk_free(pWalker);
+
+    if (oids.isEmpty()) return QString("no commits to read");
+
+    git_odb *pOdb = Q_NULLPTR;
+    if (git_repository_odb(&pOdb, m_pRepo) < 0) return get_error_msg();
+
+    QElapsedTimer timer;
+    GBL_Raw_Commit rawCommit;
+    rawCommit.summary.reserve(256);
+
+    GBL_CommitStore rawStore;
+    rawStore.reserve(oids.size());
+    int nRawRead = 0;
+    timer.start();
+    for (int i = 0; i < oids.size(); i++)
+    {
+        if (read_raw_commit(pOdb, oids.at(i), &rawCommit, &rawStore)) nRawRead++;
+    }
+    qint64 nRawNs = qMax(timer.nsecsElapsed(), (qint64)1);
+
+    git_odb_free(pOdb);
+
+    GBL_CommitStore lookupStore;
+    lookupStore.reserve(oids.size());
+    int nLookupRead = 0;
+    timer.restart();
+    for (int i = 0; i < oids.size(); i++)
+    {
+        if (read_commit(oids.at(i), &lookupStore)) nLookupRead++;
+    }
+    qint64 nLookupNs = qMax(timer.nsecsElapsed(), (qint64)1);
+
+    QString sResult = QString("%1 commits walked\nraw odb parse: %2 read, %3 ns per commit\ngit_commit_lookup: %4 read, %5 ns per commit")
+            .arg(oids.size())
+            .arg(nRawRead).arg(nRawNs / oids.size())
+            .arg(nLookupRead).arg(nLookupNs / oids.size());
+
+    return sResult;
+}
+#endif
+
+/**
+ * @brief GBL_Repository::read_raw_commit
+ * appends a commit parsed from its raw odb object, no git_commit is built
+ * @param pOdb
+ * @param oid
+ * @param pRawCommit scratch space reused between commits
+ * @param io_pStore
+ * @return false if the object couldn't be read or parsed
+ */
+bool GBL_Repository::read_raw_commit(git_odb *pOdb, const git_oid &oid, GBL_Raw_Commit *pRawCommit, GBL_CommitStore *io_pStore)
+{
+    git_odb_object *pObj = Q_NULLPTR;
+    if (git_odb_read(&pObj, pOdb, &oid) < 0) return false;
+
+    bool bRet = git_odb_object_type(pObj) == GIT_OBJ_COMMIT &&
+                parse_raw_commit((const char*)git_odb_object_data(pObj), git_odb_object_size(pObj), *pRawCommit);
+
+    if (bRet)
+    {
+        int nAuthor = io_pStore->addAuthor(pRawCommit->name, pRawCommit->name_len, pRawCommit->email, pRawCommit->email_len);
+        io_pStore->appendCommit(oid, nAuthor, pRawCommit->time, pRawCommit->summary.constData(), pRawCommit->summary.size());
+        for (int i = 0; i < pRawCommit->parents.size(); i++)
+        {
+            io_pStore->appendParent(pRawCommit->parents.at(i));
+        }
+    }
+
+    git_odb_object_free(pObj);
+
+    return bRet;
+}
+
+/**
+ * @brief GBL_Repository::read_commit
+ * appends a commit through git_commit_lookup, parents are read by id only
+ * @param oid
+ * @param io_pStore
+ * @return
+ */
+bool GBL_Repository::read_commit(const git_oid &oid, GBL_CommitStore *io_pStore)
+{
+    git_commit *pCommit = Q_NULLPTR;
+    if (git_commit_lookup(&pCommit, m_pRepo, &oid) < 0) return false;
+
+    const git_signature *pGit_Sig = git_commit_author(pCommit);
+    int nAuthor = io_pStore->addAuthor(pGit_Sig->name, pGit_Sig->email);
+    io_pStore->appendCommit(oid, nAuthor, pGit_Sig->when.time, git_commit_summary(pCommit));
+
+    unsigned int nParentCount = git_commit_parentcount(pCommit);
+    for (unsigned int i = 0; i < nParentCount; i++)
+    {
+        io_pStore->appendParent(*git_commit_parent_id(pCommit, i));
+    }
+
+    git_commit_free(pCommit);
+
+    return true;
+}
+
 bool GBL_Repository::add_to_index(QStringList *pList)
 {
     git_index *index = Q_NULLPTR;
@@ -1050,7 +1390,7 @@ bool GBL_Repository::commit_index(GBL_String sMessage)
  * @param pFileMod
  * @return
  */
-bool GBL_Repository::get_tree_from_commit_oid(GBL_String oid_str, GBL_File_Array *pHistFileArr)
+bool GBL_Repository::get_tree_from_commit_oid(GBL_String oid_str, GBL_FileList *pHistFileArr)
 {
 
    git_oid oid;
@@ -1123,86 +1463,321 @@ bool GBL_Repository::get_blob_content(GBL_String oid_str, QString& content)
 }
 
 /**
- * @brief GBL_Repository::tree_walk
- * @param pTroid
- * @param pFileMod
+ * @brief GBL_Repository::get_tree_blobs
+ * lists every blob in the tree of a commit with its raw oid and full path
+ * @param pCommitOid the commit, or Q_NULLPTR for HEAD
+ * @param pBlobArr
+ * @return
  */
-void GBL_Repository::tree_walk(const git_oid *pTroid, GBL_File_Array *pHistFileArr)
+bool GBL_Repository::get_tree_blobs(const git_oid *pCommitOid, GBL_Blob_Array *pBlobArr)
 {
+    git_object *pCommitObj = Q_NULLPTR;
     git_tree *pTree = Q_NULLPTR;
-    m_iErrorCode = git_tree_lookup(&pTree, m_pRepo, pTroid);
-    if (m_iErrorCode >= 0)
+
+    try
     {
-        GBL_Tree_Walk_Payload twp;
-        twp.file_arr = pHistFileArr;
-        twp.repo = this;
+        if (pCommitOid)
+        {
+            check_libgit_return(git_object_lookup(&pCommitObj, m_pRepo, pCommitOid, GIT_OBJ_COMMIT));
+        }
+        else
+        {
+            check_libgit_return(git_revparse_single(&pCommitObj, m_pRepo, "HEAD^{commit}"));
+        }
 
-        m_iErrorCode = git_tree_walk(pTree, GIT_TREEWALK_POST, reinterpret_cast<git_treewalk_cb>(tree_walk_callback), &twp);
-        git_tree_free(pTree);
+        check_libgit_return(git_commit_tree(&pTree, (git_commit*)pCommitObj));
+        check_libgit_return(git_tree_walk(pTree, GIT_TREEWALK_PRE, reinterpret_cast<git_treewalk_cb>(tree_blobs_callback), pBlobArr));
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
     }
+
+    if (pTree) git_tree_free(pTree);
+    if (pCommitObj) git_object_free(pCommitObj);
+
+    return m_iErrorCode >= 0;
 }
 
 /**
- * @brief GBL_Repository::tree_walk_callback
- * @param root
- * @param entry
- * @param payload
+ * @brief GBL_Repository::get_commit_oids
+ * lists the commits of a range, oldest first
+ * @param sRange empty for the history of HEAD, a revision for its history,
+ * or a range like "v1.0..master"
+ * @param oids
  * @return
  */
-int GBL_Repository::tree_walk_callback(const char *root, const git_tree_entry *entry, void *payload)
+bool GBL_Repository::get_commit_oids(const QString &sRange, QVector<git_oid> &oids)
 {
-    //qDebug() << "root:" << root;
-    //qDebug() << "entry.filename:" << git_tree_entry_name(entry);
-    git_otype type = git_tree_entry_type(entry);
-    //qDebug() << "type:" << type;
+    git_revwalk *pWalker = Q_NULLPTR;
+    git_object *pObj = Q_NULLPTR;
+    oids.clear();
 
-    GBL_Tree_Walk_Payload *ptwp = reinterpret_cast<GBL_Tree_Walk_Payload*>(payload);
-    GBL_File_Array *pHistFileArr = ptwp->file_arr;
-
-    if (type == GIT_OBJ_BLOB)
+    try
     {
-        GBL_File_Item *pFItem = new GBL_File_Item;
-        pFItem->file_name = git_tree_entry_name(entry);
-        pFItem->sub_dir = QString(root);
-        pFItem->status = GBL_FILE_STATUS_SYSTEM;
+        check_libgit_return(git_revwalk_new(&pWalker, m_pRepo));
+        git_revwalk_sorting(pWalker, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME | GIT_SORT_REVERSE);
 
-        const git_oid *pTroid = git_tree_entry_id(entry);
-        pFItem->file_oid = QString(git_oid_tostr_s(pTroid));
-        pHistFileArr->append(pFItem);
+        if (sRange.isEmpty())
+        {
+            check_libgit_return(git_revwalk_push_head(pWalker));
+        }
+        else if (sRange.contains(".."))
+        {
+            check_libgit_return(git_revwalk_push_range(pWalker, sRange.toUtf8().constData()));
+        }
+        else
+        {
+            QString sRev = sRange + "^{commit}";
+            check_libgit_return(git_revparse_single(&pObj, m_pRepo, sRev.toUtf8().constData()));
+            check_libgit_return(git_revwalk_push(pWalker, git_object_id(pObj)));
+        }
+
+        git_oid oid;
+        while (!git_revwalk_next(&oid, pWalker))
+        {
+            oids.append(oid);
+        }
     }
-    /*if (type == GIT_OBJ_TREE)
+    catch(GBL_RepositoryException &e)
     {
-        const git_oid *pTroid = git_tree_entry_id(entry);
-        GBL_Tree_Walk_Payload twp;
-        twp.file_arr = pHistFileArr;
-        twp.repo = ptwp->repo;
-        ptwp->repo->tree_walk(pTroid, pHistFileArr);
-    }*/
+        Q_UNUSED(e);
+    }
 
-    return 1;
+    if (pObj) git_object_free(pObj);
+    if (pWalker) git_revwalk_free(pWalker);
+
+    return m_iErrorCode >= 0;
 }
 
 /**
- * @brief GBL_Repository::get_commit_to_parent_diff_files
- * @param oid_str
- * @param pFileMod
+ * @brief GBL_Repository::get_commit_tree_oid
+ * @param commitOid
+ * @param treeOid
  * @return
  */
-bool GBL_Repository::get_commit_to_parent_diff_files(GBL_String oid_str, GBL_File_Array *pHistFileArr)
+bool GBL_Repository::get_commit_tree_oid(const git_oid &commitOid, git_oid &treeOid)
 {
-    return get_commit_to_parent_diff(oid_str, GIT_DIFF_FORMAT_NAME_STATUS,  diff_print_files_callback, pHistFileArr);
+    git_commit *pCommit = Q_NULLPTR;
+
+    try
+    {
+        check_libgit_return(git_commit_lookup(&pCommit, m_pRepo, &commitOid));
+        treeOid = *git_commit_tree_id(pCommit);
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    if (pCommit) git_commit_free(pCommit);
+
+    return m_iErrorCode >= 0;
 }
 
 /**
- * @brief GBL_Repository::get_commit_to_parent_diff_lines
+ * @brief GBL_Repository::get_tree_entries
+ * lists the blobs and subtrees directly in a tree, submodules are left out
+ * @param treeOid
+ * @param entries
+ * @return
+ */
+bool GBL_Repository::get_tree_entries(const git_oid &treeOid, GBL_Tree_Entry_Array &entries)
+{
+    git_tree *pTree = Q_NULLPTR;
+    entries.resize(0);
+
+    try
+    {
+        check_libgit_return(git_tree_lookup(&pTree, m_pRepo, &treeOid));
+
+        size_t nCount = git_tree_entrycount(pTree);
+        for (size_t i = 0; i < nCount; i++)
+        {
+            const git_tree_entry *pEntry = git_tree_entry_byindex(pTree, i);
+            git_otype type = git_tree_entry_type(pEntry);
+            if (type != GIT_OBJ_BLOB && type != GIT_OBJ_TREE) continue;
+
+            GBL_Tree_Entry entry;
+            entry.entry_oid = *git_tree_entry_id(pEntry);
+            entry.name = QString::fromUtf8(git_tree_entry_name(pEntry));
+            entry.is_tree = type == GIT_OBJ_TREE;
+            entries.append(entry);
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    if (pTree) git_tree_free(pTree);
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::tree_blobs_callback
+ * @param root
+ * @param entry
+ * @param payload GBL_Blob_Array to append to
+ * @return
+ */
+int GBL_Repository::tree_blobs_callback(const char *root, const git_tree_entry *entry, void *payload)
+{
+    if (git_tree_entry_type(entry) == GIT_OBJ_BLOB)
+    {
+        GBL_Blob_Array *pBlobArr = reinterpret_cast<GBL_Blob_Array*>(payload);
+        GBL_Blob_Item blobItem;
+        blobItem.blob_oid = *git_tree_entry_id(entry);
+        blobItem.path = QString::fromUtf8(root);
+        blobItem.path += QString::fromUtf8(git_tree_entry_name(entry));
+        pBlobArr->append(blobItem);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief GBL_Repository::read_blob
+ * looks a blob up and points data at the content of a text blob, nothing is
+ * copied. Binary blobs are only flagged and data is left empty.
+ * @param oid
+ * @param pBlob gets the blob, free it with git_blob_free once data is done
+ * with, data is only valid until then
+ * @param data
+ * @param bBinary
+ * @return
+ */
+bool GBL_Repository::read_blob(const git_oid &oid, git_blob **pBlob, QByteArray &data, bool &bBinary)
+{
+    *pBlob = Q_NULLPTR;
+    data.clear();
+    bBinary = false;
+
+    try
+    {
+        check_libgit_return(git_blob_lookup(pBlob, m_pRepo, &oid));
+        bBinary = git_blob_is_binary(*pBlob) != 0;
+        git_off_t nSize = git_blob_rawsize(*pBlob);
+        if (!bBinary && nSize < INT_MAX)
+        {
+            data = QByteArray::fromRawData((const char*)git_blob_rawcontent(*pBlob), (int)nSize);
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::get_missing_objects
+ * @param oids
+ * @param missing gets the oids not in the object database
+ * @return
+ */
+bool GBL_Repository::get_missing_objects(const QVector<git_oid> &oids, QSet<git_oid> &missing)
+{
+    git_odb *pOdb = Q_NULLPTR;
+
+    missing.clear();
+
+    try
+    {
+        check_libgit_return(git_repository_odb(&pOdb, m_pRepo));
+        for (int i = 0; i < oids.size(); i++)
+        {
+            if (!git_odb_exists(pOdb, &oids.at(i))) missing.insert(oids.at(i));
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    if (pOdb) git_odb_free(pOdb);
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::tree_walk
+ * @param pTroid
+ * @param pFileMod
+ */
+void GBL_Repository::tree_walk(const git_oid *pTroid, GBL_FileList *pHistFileArr)
+{
+    git_tree *pTree = Q_NULLPTR;
+    m_iErrorCode = git_tree_lookup(&pTree, m_pRepo, pTroid);
+    if (m_iErrorCode >= 0)
+    {
+        GBL_Tree_Walk_Payload twp;
+        twp.file_arr = pHistFileArr;
+        twp.repo = this;
+
+        m_iErrorCode = git_tree_walk(pTree, GIT_TREEWALK_POST, reinterpret_cast<git_treewalk_cb>(tree_walk_callback), &twp);
+        git_tree_free(pTree);
+    }
+}
+
+/**
+ * @brief GBL_Repository::tree_walk_callback
+ * @param root
+ * @param entry
+ * @param payload
+ * @return
+ */
+int GBL_Repository::tree_walk_callback(const char *root, const git_tree_entry *entry, void *payload)
+{
+    //qDebug() << "root:" << root;
+    //qDebug() << "entry.filename:" << git_tree_entry_name(entry);
+    git_otype type = git_tree_entry_type(entry);
+    //qDebug() << "type:" << type;
+
+    GBL_Tree_Walk_Payload *ptwp = reinterpret_cast<GBL_Tree_Walk_Payload*>(payload);
+    GBL_FileList *pHistFileArr = ptwp->file_arr;
+
+    if (type == GIT_OBJ_BLOB)
+    {
+        // root is the sub directory with its trailing slash, as the views expect
+        const char *pName = git_tree_entry_name(entry);
+        pHistFileArr->append(root, strlen(root), pName, strlen(pName), GBL_FILE_STATUS_SYSTEM, git_tree_entry_id(entry));
+    }
+    /*if (type == GIT_OBJ_TREE)
+    {
+        const git_oid *pTroid = git_tree_entry_id(entry);
+        GBL_Tree_Walk_Payload twp;
+        twp.file_arr = pHistFileArr;
+        twp.repo = ptwp->repo;
+        ptwp->repo->tree_walk(pTroid, pHistFileArr);
+    }*/
+
+    return 1;
+}
+
+/**
+ * @brief GBL_Repository::get_commit_to_parent_diff_files
+ * @param oid_str
+ * @param pFileMod
+ * @return
+ */
+bool GBL_Repository::get_commit_to_parent_diff_files(GBL_String oid_str, GBL_FileList *pHistFileArr)
+{
+    return get_commit_to_parent_diff(oid_str, GIT_DIFF_FORMAT_NAME_STATUS,  diff_print_files_callback, pHistFileArr);
+}
+
+/**
+ * @brief GBL_Repository::get_commit_to_parent_diff_lines
  * @param oid_str
- * @param pMain
+ * @param pBuffer gets the lines of the patch
  * @param path
  * @return
  */
-bool GBL_Repository::get_commit_to_parent_diff_lines(GBL_String oid_str, MainWindow *pMain, char *path)
+bool GBL_Repository::get_commit_to_parent_diff_lines(GBL_String oid_str, GBL_DiffBuffer *pBuffer, char *path)
 {
-    return get_commit_to_parent_diff(oid_str, GIT_DIFF_FORMAT_PATCH, diff_print_lines_callback, pMain, path);
+    return get_commit_to_parent_diff(oid_str, GIT_DIFF_FORMAT_PATCH, diff_print_lines_callback, pBuffer, path);
 }
 
 /**
@@ -1266,29 +1841,269 @@ bool GBL_Repository::get_commit_to_parent_diff(GBL_String oid_str, git_diff_form
     return m_iErrorCode >= 0;
 }
 
+/**
+ * @brief GBL_Repository::get_commit_diffs
+ * diffs a commit against each of its parents, or against an empty tree if it
+ * has none
+ * @param oid_str
+ * @param diffs gets one diff per parent, freed by the caller
+ * @return
+ */
+bool GBL_Repository::get_commit_diffs(GBL_String oid_str, QVector<git_diff*> &diffs)
+{
+    git_oid oid;
+    git_commit *pCommit = Q_NULLPTR, *pParentCommit = Q_NULLPTR;
+    git_tree *pTree = Q_NULLPTR, *pParentTree = Q_NULLPTR;
+    git_diff *pDiff = Q_NULLPTR;
+    git_diff_options diffopts = GIT_DIFF_OPTIONS_INIT;
+
+    try
+    {
+        check_libgit_return(git_oid_fromstr(&oid, oid_str.toConstChar()));
+        check_libgit_return(git_commit_lookup(&pCommit, m_pRepo, &oid));
+        check_libgit_return(git_commit_tree(&pTree, pCommit));
+
+        unsigned int nParentCount = git_commit_parentcount(pCommit);
+        if (nParentCount == 0)
+        {
+            check_libgit_return(git_diff_tree_to_tree(&pDiff, m_pRepo, Q_NULLPTR, pTree, &diffopts));
+            diffs.append(pDiff);
+            pDiff = Q_NULLPTR;
+        }
+
+        for (unsigned int i = 0; i < nParentCount; i++)
+        {
+            check_libgit_return(git_commit_parent(&pParentCommit, pCommit, i));
+            check_libgit_return(git_commit_tree(&pParentTree, pParentCommit));
+            check_libgit_return(git_diff_tree_to_tree(&pDiff, m_pRepo, pParentTree, pTree, &diffopts));
+            diffs.append(pDiff);
+            pDiff = Q_NULLPTR;
+            git_tree_free(pParentTree);
+            pParentTree = Q_NULLPTR;
+            git_commit_free(pParentCommit);
+            pParentCommit = Q_NULLPTR;
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    if (pParentTree) git_tree_free(pParentTree);
+    if (pParentCommit) git_commit_free(pParentCommit);
+    if (pTree) git_tree_free(pTree);
+    if (pCommit) git_commit_free(pCommit);
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::get_diff_files
+ * @param pDiff
+ * @param pFileArr gets an item per delta, in the order of the diff
+ * @return
+ */
+bool GBL_Repository::get_diff_files(git_diff *pDiff, GBL_FileList *pFileArr)
+{
+    size_t nDeltas = git_diff_num_deltas(pDiff);
+    for (size_t i = 0; i < nDeltas; i++)
+    {
+        const git_diff_delta *pDelta = git_diff_get_delta(pDiff, i);
+        pFileArr->appendPath(pDelta->new_file.path, delta_status(pDelta->status));
+    }
+
+    return true;
+}
+
+/**
+ * @brief GBL_Repository::get_diff_patch
+ * makes the patch of one delta of a diff, the trees aren't compared again.
+ * A binary file, or one over the limits, only gets a summary.
+ * @param pDiff
+ * @param nDelta
+ * @param pBuffer gets the lines of the patch
+ * @param pLimits Q_NULLPTR for no limits
+ * @return
+ */
+bool GBL_Repository::get_diff_patch(git_diff *pDiff, size_t nDelta, GBL_DiffBuffer *pBuffer, const GBL_Diff_Limits *pLimits)
+{
+    git_patch *pPatch = Q_NULLPTR;
+    const git_diff_delta *pDelta = git_diff_get_delta(pDiff, nDelta);
+    m_iErrorCode = 0;
+
+    // the size is known before the blobs are loaded
+    if (pLimits && qMax(diff_file_size(pDelta->old_file), diff_file_size(pDelta->new_file)) > pLimits->max_bytes)
+    {
+        add_diff_summary(pBuffer, pDelta, tr("File over %1 bytes, diff not shown").arg(pLimits->max_bytes));
+        pBuffer->setLimited();
+        return true;
+    }
+
+    try
+    {
+        check_libgit_return(git_patch_from_diff(&pPatch, pDiff, nDelta));
+        if (pPatch)
+        {
+            const git_diff_delta *pPatchDelta = git_patch_get_delta(pPatch);
+            QString sNote;
+            if (pPatchDelta->flags & GIT_DIFF_FLAG_BINARY)
+            {
+                sNote = tr("Binary file");
+            }
+            else if (pLimits)
+            {
+                sNote = get_patch_over_limits(pPatch, pLimits);
+                if (!sNote.isEmpty()) pBuffer->setLimited();
+            }
+
+            if (sNote.isEmpty())
+            {
+                check_libgit_return(git_patch_print(pPatch, diff_print_lines_callback, pBuffer));
+            }
+            else
+            {
+                add_diff_summary(pBuffer, pPatchDelta, sNote);
+            }
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    if (pPatch) git_patch_free(pPatch);
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::get_diff_patches
+ * @param pDiff
+ * @param pBuffer gets the patch of every delta in turn
+ * @param pLimits Q_NULLPTR for no limits
+ * @return
+ */
+bool GBL_Repository::get_diff_patches(git_diff *pDiff, GBL_DiffBuffer *pBuffer, const GBL_Diff_Limits *pLimits)
+{
+    size_t nDeltas = git_diff_num_deltas(pDiff);
+    for (size_t i = 0; i < nDeltas; i++)
+    {
+        if (!get_diff_patch(pDiff, i, pBuffer, pLimits)) return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief GBL_Repository::get_patch_over_limits
+ * @param pPatch
+ * @param pLimits
+ * @return why the patch is too big to show, empty if it isn't
+ */
+QString GBL_Repository::get_patch_over_limits(git_patch *pPatch, const GBL_Diff_Limits *pLimits)
+{
+    size_t nContext = 0, nAdditions = 0, nDeletions = 0;
+    git_patch_line_stats(&nContext, &nAdditions, &nDeletions, pPatch);
+
+    size_t nLines = nContext + nAdditions + nDeletions;
+    if (nLines > (size_t)pLimits->max_lines)
+    {
+        return tr("%1 lines, +%2 -%3, diff not shown").arg(nLines).arg(nAdditions).arg(nDeletions);
+    }
+
+    size_t nHunks = git_patch_num_hunks(pPatch);
+    for (size_t i = 0; i < nHunks; i++)
+    {
+        int nHunkLines = git_patch_num_lines_in_hunk(pPatch, i);
+        for (int j = 0; j < nHunkLines; j++)
+        {
+            const git_diff_line *pLine = Q_NULLPTR;
+            if (git_patch_get_line_in_hunk(&pLine, pPatch, i, j) < 0) continue;
+            if (pLine->content_len > (size_t)pLimits->max_line_length)
+            {
+                return tr("Lines over %1 characters, +%2 -%3, diff not shown").arg(pLimits->max_line_length).arg(nAdditions).arg(nDeletions);
+            }
+        }
+    }
+
+    return QString();
+}
+
+/**
+ * @brief GBL_Repository::diff_file_size
+ * @param file
+ * @return the size of one side of a delta, read from the object database
+ * when the diff didn't load it
+ */
+qint64 GBL_Repository::diff_file_size(const git_diff_file &file)
+{
+    if (file.size > 0 || !(file.flags & GIT_DIFF_FLAG_VALID_ID)) return (qint64)file.size;
+
+    git_odb *pOdb = Q_NULLPTR;
+    size_t nSize = 0;
+    git_otype type;
+    if (git_repository_odb(&pOdb, m_pRepo) < 0) return 0;
+    if (git_odb_read_header(&nSize, &type, pOdb, &file.id) < 0) nSize = 0;
+    git_odb_free(pOdb);
+
+    return (qint64)nSize;
+}
+
+/**
+ * @brief GBL_Repository::add_diff_summary
+ * a file header plus the sizes and ids of both sides in place of a patch
+ * @param pBuffer
+ * @param pDelta
+ * @param sNote why there is no patch
+ */
+void GBL_Repository::add_diff_summary(GBL_DiffBuffer *pBuffer, const git_diff_delta *pDelta, const QString &sNote)
+{
+    char oldId[GIT_OID_HEXSZ + 1], newId[GIT_OID_HEXSZ + 1];
+    git_oid_tostr(oldId, sizeof(oldId), &pDelta->old_file.id);
+    git_oid_tostr(newId, sizeof(newId), &pDelta->new_file.id);
+    qint64 nOldSize = diff_file_size(pDelta->old_file);
+    qint64 nNewSize = diff_file_size(pDelta->new_file);
+    qint64 nChange = nNewSize - nOldSize;
+
+    QByteArray baHeader = QString("diff --git a/%1 b/%2").arg(QString::fromUtf8(pDelta->old_file.path)).arg(QString::fromUtf8(pDelta->new_file.path)).toUtf8();
+    pBuffer->addLine(GIT_DIFF_LINE_FILE_HDR, -1, -1, baHeader.constData(), baHeader.size());
+
+    QStringList lines;
+    lines.append(sNote);
+    lines.append(tr("old %1 %2 bytes").arg(QString::fromLatin1(oldId)).arg(nOldSize));
+    lines.append(tr("new %1 %2 bytes (%3%4)").arg(QString::fromLatin1(newId)).arg(nNewSize).arg(nChange >= 0 ? "+" : "").arg(nChange));
+    for (int i = 0; i < lines.size(); i++)
+    {
+        QByteArray baLine = lines.at(i).toUtf8();
+        pBuffer->addLine(GIT_DIFF_LINE_HUNK_HDR, -1, -1, baLine.constData(), baLine.size());
+    }
+}
+
 /**
  * @brief GBL_Repository::get_index_to_work_diff
- * @param pMain
+ * @param pBuffer gets the lines of the patch
  * @param pList
+ * @param pLimits Q_NULLPTR for no limits
  * @return
  */
-bool GBL_Repository::get_index_to_work_diff(MainWindow *pMain, QStringList *pList)
+bool GBL_Repository::get_index_to_work_diff(GBL_DiffBuffer *pBuffer, QStringList *pList, const GBL_Diff_Limits *pLimits)
 {
     git_diff *diff = Q_NULLPTR;
     git_diff_options diffopts = GIT_DIFF_OPTIONS_INIT;
+    // local since diffs run on more than one thread
+    QByteArrayList paths;
     if (pList && pList->size())
     {
         diffopts.pathspec.count = pList->size();
         diffopts.pathspec.strings = (char**)::malloc(sizeof(char*) * pList->size());
         diffopts.flags = GIT_DIFF_INCLUDE_UNTRACKED|GIT_DIFF_SHOW_UNTRACKED_CONTENT|GIT_DIFF_RECURSE_UNTRACKED_DIRS;
 
-        g_temp_balist.clear();
         for (int i = 0; i < pList->size(); i++)
         {
             QString path = pList->at(i);
             QByteArray baPath = path.toUtf8();
-            g_temp_balist.append(baPath);
-            diffopts.pathspec.strings[i] = const_cast<char*>(g_temp_balist.at(i).data());
+            paths.append(baPath);
+            diffopts.pathspec.strings[i] = const_cast<char*>(paths.at(i).data());
         }
 
         //diffopts.pathspec.count = pList->size();
@@ -1297,36 +2112,45 @@ bool GBL_Repository::get_index_to_work_diff(MainWindow *pMain, QStringList *pLis
     try
     {
         check_libgit_return(git_diff_index_to_workdir(&diff, m_pRepo, Q_NULLPTR, &diffopts));
-        check_libgit_return(git_diff_print(diff, GIT_DIFF_FORMAT_PATCH, diff_print_lines_callback, pMain));
+        get_diff_patches(diff, pBuffer, pLimits);
     }
     catch(GBL_RepositoryException &e)
     {
     }
 
     if (diff) git_diff_free(diff);
+    ::free(diffopts.pathspec.strings);
 
     return m_iErrorCode >= 0;
 }
 
-bool GBL_Repository::get_index_to_head_diff(MainWindow *pMain, QStringList *pList)
+/**
+ * @brief GBL_Repository::get_index_to_head_diff
+ * @param pBuffer gets the lines of the patch
+ * @param pList
+ * @param pLimits Q_NULLPTR for no limits
+ * @return
+ */
+bool GBL_Repository::get_index_to_head_diff(GBL_DiffBuffer *pBuffer, QStringList *pList, const GBL_Diff_Limits *pLimits)
 {
     git_object *obj = Q_NULLPTR;
     git_diff *diff = Q_NULLPTR;
     git_tree *tree = Q_NULLPTR;
     git_diff_options diffopts = GIT_DIFF_OPTIONS_INIT;
+    // local since diffs run on more than one thread
+    QByteArrayList paths;
     if (pList && pList->size())
     {
         diffopts.pathspec.count = pList->size();
         diffopts.pathspec.strings = (char**)::malloc(sizeof(char*) * pList->size());
         //diffopts.flags = GIT_DIFF_INCLUDE_UNTRACKED|GIT_DIFF_SHOW_UNTRACKED_CONTENT|GIT_DIFF_RECURSE_UNTRACKED_DIRS;
 
-        g_temp_balist.clear();
         for (int i = 0; i < pList->size(); i++)
         {
             QString path = pList->at(i);
             QByteArray baPath = path.toUtf8();
-            g_temp_balist.append(baPath);
-            diffopts.pathspec.strings[i] = const_cast<char*>(g_temp_balist.at(i).data());
+            paths.append(baPath);
+            diffopts.pathspec.strings[i] = const_cast<char*>(paths.at(i).data());
         }
 
         //diffopts.pathspec.count = pList->size();
@@ -1337,7 +2161,7 @@ bool GBL_Repository::get_index_to_head_diff(MainWindow *pMain, QStringList *pLis
         check_libgit_return(git_revparse_single(&obj, m_pRepo, "HEAD^{tree}"));
         check_libgit_return(git_tree_lookup(&tree, m_pRepo, git_object_id(obj)));
         check_libgit_return(git_diff_tree_to_index(&diff, m_pRepo, tree, Q_NULLPTR, &diffopts));
-        check_libgit_return(git_diff_print(diff, GIT_DIFF_FORMAT_PATCH, diff_print_lines_callback, pMain));
+        get_diff_patches(diff, pBuffer, pLimits);
     }
     catch(GBL_RepositoryException &e)
     {
@@ -1346,81 +2170,76 @@ bool GBL_Repository::get_index_to_head_diff(MainWindow *pMain, QStringList *pLis
     if (obj) git_object_free(obj);
     if (tree) git_tree_free(tree);
     if (diff) git_diff_free(diff);
+    ::free(diffopts.pathspec.strings);
 
     return m_iErrorCode >= 0;
 }
 
 /**
- * @brief GBL_Repository::diff_print_files_callback
- * @param pDelta
- * @param pHunk
- * @param pLine
- * @param payload
- * @return
+ * @brief GBL_Repository::delta_status
+ * @param status
+ * @return the GBL_FILE_STATUS_ value of a diff delta
  */
-int GBL_Repository::diff_print_files_callback(const git_diff_delta *pDelta, const git_diff_hunk *pHunk, const git_diff_line *pLine, void *payload)
+char GBL_Repository::delta_status(git_delta_t status)
 {
-    //qDebug() << "old_file" << pDelta->old_file.path;
-    //qDebug() << "new_file" << pDelta->new_file.path;lkj
-    Q_UNUSED(pHunk);
-    Q_UNUSED(pLine);
-
-    GBL_File_Array *pFileArr = reinterpret_cast<GBL_File_Array*>(payload);
-
-    GBL_File_Item *pFItem = new GBL_File_Item;
-    QFileInfo fi(pDelta->new_file.path);
-    pFItem->file_name = QString(fi.fileName());
-    pFItem->sub_dir = QString(fi.path());
-
-    switch (pDelta->status)
+    switch (status)
     {
         case GIT_DELTA_ADDED:
-            pFItem->status = GBL_FILE_STATUS_ADDED;
-            break;
+            return GBL_FILE_STATUS_ADDED;
         case GIT_DELTA_CONFLICTED:
-            pFItem->status = GBL_FILE_STATUS_CONFLICTED;
-            break;
+            return GBL_FILE_STATUS_CONFLICTED;
         case GIT_DELTA_COPIED:
-            pFItem->status = GBL_FILE_STATUS_COPIED;
-            break;
+            return GBL_FILE_STATUS_COPIED;
         case GIT_DELTA_DELETED:
-            pFItem->status = GBL_FILE_STATUS_DELETED;
-            break;
+            return GBL_FILE_STATUS_DELETED;
         case GIT_DELTA_IGNORED:
-            pFItem->status = GBL_FILE_STATUS_IGNORED;
-            break;
+            return GBL_FILE_STATUS_IGNORED;
         case GIT_DELTA_MODIFIED:
-            pFItem->status = GBL_FILE_STATUS_MODIFIED;
-            break;
-         case GIT_DELTA_RENAMED:
-            pFItem->status = GBL_FILE_STATUS_RENAMED;
-            break;
+            return GBL_FILE_STATUS_MODIFIED;
+        case GIT_DELTA_RENAMED:
+            return GBL_FILE_STATUS_RENAMED;
         case GIT_DELTA_TYPECHANGE:
-           pFItem->status = GBL_FILE_STATUS_TYPECHANGE;
-           break;
+            return GBL_FILE_STATUS_TYPECHANGE;
         case GIT_DELTA_UNREADABLE:
-           pFItem->status = GBL_FILE_STATUS_UNREADABLE;
-           break;
+            return GBL_FILE_STATUS_UNREADABLE;
         case GIT_DELTA_UNTRACKED:
-           pFItem->status = GBL_FILE_STATUS_UNTRACKED;
-           break;
+            return GBL_FILE_STATUS_UNTRACKED;
         default:
-            pFItem->status = GBL_FILE_STATUS_UNKNOWN;
-
+            return GBL_FILE_STATUS_UNKNOWN;
     }
+}
 
-    //pFItem->status = pDelta->status;
-    pFileArr->append(pFItem);
+/**
+ * @brief GBL_Repository::diff_print_files_callback
+ * @param pDelta
+ * @param pHunk
+ * @param pLine
+ * @param payload
+ * @return
+ */
+int GBL_Repository::diff_print_files_callback(const git_diff_delta *pDelta, const git_diff_hunk *pHunk, const git_diff_line *pLine, void *payload)
+{
+    //qDebug() << "old_file" << pDelta->old_file.path;
+    //qDebug() << "new_file" << pDelta->new_file.path;lkj
+    Q_UNUSED(pHunk);
+    Q_UNUSED(pLine);
+
+    GBL_FileList *pFileArr = reinterpret_cast<GBL_FileList*>(payload);
+
+    pFileArr->appendPath(pDelta->new_file.path, delta_status(pDelta->status));
 
     return 0;
 }
 
 /**
  * @brief GBL_Repository::diff_print_lines_callback
+ * appends the raw utf-8 content of a line to the buffer, the content isn't
+ * null terminated so only content_len bytes are read. The buffer's observer
+ * can stop the diff.
  * @param pDelta
  * @param pHunk
  * @param pLine
- * @param payload
+ * @param payload GBL_DiffBuffer to append to
  * @return
  */
 int GBL_Repository::diff_print_lines_callback(const git_diff_delta *pDelta, const git_diff_hunk *pHunk, const git_diff_line *pLine, void *payload)
@@ -1428,45 +2247,70 @@ int GBL_Repository::diff_print_lines_callback(const git_diff_delta *pDelta, cons
     Q_UNUSED(pDelta);
     Q_UNUSED(pHunk);
 
-    //qDebug() << "old_file" << pDelta->old_file.path;
-    //qDebug() << "new_file" << pDelta->new_file.path;
-
-    /*if (pHunk)
+    if (pLine)
     {
-        qDebug() << "git_diff_hunk_new_lines" << pHunk->new_lines;
-        qDebug() << "git_diff-hunk_new_start" << pHunk->new_start;
-        qDebug() << "git_diff_hunk_old_lines" << pHunk->old_lines;
-        qDebug() << "git_diff-hunk_old_start" << pHunk->old_start;
-        QString sHeader;
-        for (int i = 0; i < pHunk->header_len; i++)
+        GBL_DiffBuffer *pBuffer = reinterpret_cast<GBL_DiffBuffer*>(payload);
+        if (!pBuffer->addLine(pLine->origin, pLine->old_lineno, pLine->new_lineno, pLine->content, (int)pLine->content_len))
         {
-            sHeader += pHunk->header[i];
+            return GIT_EUSER;
         }
-        qDebug() << "git_diff_hunk_header" << sHeader;
-    }*/
-
-    if (pLine)
-    {
-        //qDebug() << "git_diff_line_origin" << pLine->origin;
-        //qDebug() << "git_diff_line_new_line#" << pLine->new_lineno;
-        //qDebug() << "git_diff_line_old_line#" << pLine->old_lineno;
-        QString content(pLine->content);
-        content = content.left(pLine->content_len);
-        //qDebug() << "git_diff_line_content" << content;
-        GBL_Line_Item li;
-        li.content = content;
-        li.line_change_type = pLine->origin;
-        li.new_line_num = pLine->new_lineno;
-        li.old_line_num = pLine->old_lineno;
-        MainWindow *pMain = reinterpret_cast<MainWindow*>(payload);
-        pMain->addToDiffView(&li);
-
     }
 
     return 0;
 }
 
-bool GBL_Repository::get_repo_status(GBL_File_Array *pStagedArr, GBL_File_Array *pUnstagedArr)
+/**
+ * @brief GBL_Repository::index_status
+ * @param status git_status_t flags
+ * @return the GBL_FILE_STATUS_ value of the index side
+ */
+char GBL_Repository::index_status(unsigned int status)
+{
+    char c = GBL_FILE_STATUS_UNKNOWN;
+
+    if (status & GIT_STATUS_INDEX_NEW)
+        c = GBL_FILE_STATUS_ADDED;
+    if (status & GIT_STATUS_INDEX_MODIFIED)
+        c = GBL_FILE_STATUS_MODIFIED;
+    if (status & GIT_STATUS_INDEX_DELETED)
+        c = GBL_FILE_STATUS_DELETED;
+    if (status & GIT_STATUS_INDEX_RENAMED)
+        c = GBL_FILE_STATUS_RENAMED;
+    if (status & GIT_STATUS_INDEX_TYPECHANGE)
+        c = GBL_FILE_STATUS_TYPECHANGE;
+    if (status & GIT_STATUS_IGNORED)
+        c = GBL_FILE_STATUS_IGNORED;
+
+    return c;
+}
+
+/**
+ * @brief GBL_Repository::workdir_status
+ * @param status git_status_t flags
+ * @return the GBL_FILE_STATUS_ value of the working tree side, untracked
+ * files are GBL_FILE_STATUS_UNKNOWN
+ */
+char GBL_Repository::workdir_status(unsigned int status)
+{
+    char c = GBL_FILE_STATUS_UNKNOWN;
+
+    if (status & GIT_STATUS_WT_NEW)
+        c = GBL_FILE_STATUS_UNKNOWN;
+    if (status & GIT_STATUS_WT_MODIFIED)
+        c = GBL_FILE_STATUS_MODIFIED;
+    if (status & GIT_STATUS_WT_DELETED)
+        c = GBL_FILE_STATUS_DELETED;
+    if (status & GIT_STATUS_WT_RENAMED)
+        c = GBL_FILE_STATUS_RENAMED;
+    if (status & GIT_STATUS_WT_TYPECHANGE)
+        c = GBL_FILE_STATUS_TYPECHANGE;
+    if (status & GIT_STATUS_IGNORED)
+        c = GBL_FILE_STATUS_IGNORED;
+
+    return c;
+}
+
+bool GBL_Repository::get_repo_status(GBL_FileList *pStagedArr, GBL_FileList *pUnstagedArr)
 {
     git_status_list *status;
     git_status_options opts = GIT_STATUS_OPTIONS_INIT;
@@ -1491,25 +2335,7 @@ bool GBL_Repository::get_repo_status(GBL_File_Array *pStagedArr, GBL_File_Array
                 qDebug() << "new_file" << s->head_to_index->new_file.path;
                 qDebug() << "old_file" << s->head_to_index->old_file.path;
                 */
-                GBL_File_Item *pFItem = new GBL_File_Item;
-                QFileInfo fi(s->head_to_index->new_file.path);
-                pFItem->file_name = QString(fi.fileName());
-                pFItem->sub_dir = QString(fi.path());
-
-                if (s->status & GIT_STATUS_INDEX_NEW)
-                    pFItem->status = GBL_FILE_STATUS_ADDED;
-                if (s->status & GIT_STATUS_INDEX_MODIFIED)
-                    pFItem->status = GBL_FILE_STATUS_MODIFIED;
-                if (s->status & GIT_STATUS_INDEX_DELETED)
-                    pFItem->status = GBL_FILE_STATUS_DELETED;
-                if (s->status & GIT_STATUS_INDEX_RENAMED)
-                    pFItem->status = GBL_FILE_STATUS_RENAMED;
-                if (s->status & GIT_STATUS_INDEX_TYPECHANGE)
-                    pFItem->status = GBL_FILE_STATUS_TYPECHANGE;
-                if (s->status & GIT_STATUS_IGNORED)
-                    pFItem->status = GBL_FILE_STATUS_IGNORED;
-
-                pStagedArr->append(pFItem);
+                pStagedArr->appendPath(s->head_to_index->new_file.path, index_status(s->status));
             }
 
             if (s->index_to_workdir)
@@ -1518,24 +2344,7 @@ bool GBL_Repository::get_repo_status(GBL_File_Array *pStagedArr, GBL_File_Array
                 //qDebug() << "new_file" << s->index_to_workdir->new_file.path;
                 //qDebug() << "old_file" << s->index_to_workdir->old_file.path;
 
-                GBL_File_Item *pFItem = new GBL_File_Item;
-                QFileInfo fi(s->index_to_workdir->new_file.path);
-                pFItem->file_name = QString(fi.fileName());
-                pFItem->sub_dir = QString(fi.path());
-                if (s->status & GIT_STATUS_WT_NEW)
-                    pFItem->status = GBL_FILE_STATUS_UNKNOWN;
-                if (s->status & GIT_STATUS_WT_MODIFIED)
-                    pFItem->status = GBL_FILE_STATUS_MODIFIED;
-                if (s->status & GIT_STATUS_WT_DELETED)
-                    pFItem->status = GBL_FILE_STATUS_DELETED;
-                if (s->status & GIT_STATUS_WT_RENAMED)
-                    pFItem->status = GBL_FILE_STATUS_RENAMED;
-                if (s->status & GIT_STATUS_WT_TYPECHANGE)
-                    pFItem->status = GBL_FILE_STATUS_TYPECHANGE;
-                if (s->status & GIT_STATUS_IGNORED)
-                    pFItem->status = GBL_FILE_STATUS_IGNORED;
-                pUnstagedArr->append(pFItem);
-
+                pUnstagedArr->appendPath(s->index_to_workdir->new_file.path, workdir_status(s->status));
             }
         }
 
@@ -1549,6 +2358,149 @@ bool GBL_Repository::get_repo_status(GBL_File_Array *pStagedArr, GBL_File_Array
     return false;
 }
 
+/**
+ * @brief GBL_Repository::get_status_entries
+ * @param entries gets the changed paths, keyed by path
+ * @param show which sides to compare
+ * @param pPaths limits the paths looked at, Q_NULLPTR for all of them
+ * @param bExact the paths are file paths rather than patterns
+ * @param bUntracked list untracked files, without them untracked directories
+ * aren't walked at all
+ * @return
+ */
+bool GBL_Repository::get_status_entries(GBL_Status_Map &entries, git_status_show_t show, const QStringList *pPaths, bool bExact, bool bUntracked)
+{
+    git_status_list *status = Q_NULLPTR;
+    git_status_options opts = GIT_STATUS_OPTIONS_INIT;
+    opts.show = show;
+    opts.flags = bUntracked ? GIT_STATUS_OPT_INCLUDE_UNTRACKED | GIT_STATUS_OPT_RECURSE_UNTRACKED_DIRS : 0;
+    if (bExact) opts.flags |= GIT_STATUS_OPT_DISABLE_PATHSPEC_MATCH;
+
+    QByteArrayList paths;
+    if (pPaths && pPaths->size())
+    {
+        opts.pathspec.count = pPaths->size();
+        opts.pathspec.strings = (char**)::malloc(sizeof(char*) * pPaths->size());
+        for (int i = 0; i < pPaths->size(); i++)
+        {
+            paths.append(pPaths->at(i).toUtf8());
+            opts.pathspec.strings[i] = const_cast<char*>(paths.at(i).data());
+        }
+    }
+
+    try
+    {
+        check_libgit_return(git_status_list_new(&status, m_pRepo, &opts));
+
+        size_t nCount = git_status_list_entrycount(status);
+        for (size_t i = 0; i < nCount; i++)
+        {
+            const git_status_entry *s = git_status_byindex(status, i);
+            const git_diff_delta *pDelta = s->head_to_index ? s->head_to_index : s->index_to_workdir;
+            if (!pDelta) continue;
+
+            GBL_Status_Entry &entry = entries[QString::fromUtf8(pDelta->new_file.path)];
+            entry.staged = s->head_to_index ? index_status(s->status) : 0;
+            entry.unstaged = s->index_to_workdir ? workdir_status(s->status) : 0;
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    if (status) git_status_list_free(status);
+    ::free(opts.pathspec.strings);
+
+    return m_iErrorCode >= 0;
+}
+
+/**
+ * @brief GBL_Repository::is_path_ignored
+ * @param sPath relative to the working tree
+ * @return
+ */
+bool GBL_Repository::is_path_ignored(const QString &sPath)
+{
+    int nIgnored = 0;
+    QByteArray baPath = sPath.toUtf8();
+    if (git_ignore_path_is_ignored(&nIgnored, m_pRepo, baPath.constData()) < 0) return false;
+
+    return nIgnored != 0;
+}
+
+/**
+ * @brief index_lower_bound
+ * @return the first index entry whose path doesn't sort before key
+ */
+static size_t index_lower_bound(git_index *index, size_t nCount, const QByteArray &key, bool bIgnoreCase)
+{
+    size_t lo = 0, hi = nCount;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        const char *path = git_index_get_byindex(index, mid)->path;
+        int nCmp = bIgnoreCase ? qstrnicmp(path, key.constData(), key.size()) : qstrncmp(path, key.constData(), key.size());
+        if (nCmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * @brief GBL_Repository::get_index_dir_entries
+ * lists what the index holds directly in one directory without visiting the
+ * rest of the index, entries are sorted so each subdirectory is skipped over
+ * @param sDir relative to the working tree, empty for its root
+ * @param files gets the paths of the files in sDir
+ * @param subdirs gets the paths of the directories in sDir
+ * @return
+ */
+bool GBL_Repository::get_index_dir_entries(const QString &sDir, QStringList &files, QStringList &subdirs)
+{
+    git_index *index = Q_NULLPTR;
+
+    try
+    {
+        check_libgit_return(git_repository_index(&index, m_pRepo));
+
+        bool bIgnoreCase = (git_index_caps(index) & GIT_INDEXCAP_IGNORE_CASE) != 0;
+        size_t nCount = git_index_entrycount(index);
+        QByteArray baPrefix = sDir.isEmpty() ? QByteArray() : sDir.toUtf8() + '/';
+
+        size_t i = index_lower_bound(index, nCount, baPrefix, bIgnoreCase);
+        while (i < nCount)
+        {
+            const char *path = git_index_get_byindex(index, i)->path;
+            int nCmp = bIgnoreCase ? qstrnicmp(path, baPrefix.constData(), baPrefix.size()) : qstrncmp(path, baPrefix.constData(), baPrefix.size());
+            if (nCmp != 0) break;
+
+            const char *rest = path + baPrefix.size();
+            const char *slash = strchr(rest, '/');
+            if (!slash)
+            {
+                files.append(QString::fromUtf8(path));
+                i++;
+                continue;
+            }
+
+            // '0' follows '/', so this is the first entry past the subdirectory
+            QByteArray baSub(path, slash - path);
+            subdirs.append(QString::fromUtf8(baSub));
+            i = index_lower_bound(index, nCount, baSub + '0', bIgnoreCase);
+        }
+    }
+    catch(GBL_RepositoryException &e)
+    {
+        Q_UNUSED(e);
+    }
+
+    if (index) git_index_free(index);
+
+    return m_iErrorCode >= 0;
+}
+
 GBL_RefItem::GBL_RefItem(QString sKey, QString sRef, GBL_RefItem *pParent)
 {
     m_sKey = sKey;
@@ -1556,6 +2508,7 @@ GBL_RefItem::GBL_RefItem(QString sKey, QString sRef, GBL_RefItem *pParent)
     m_sRef = sRef;
     m_pParentRef = pParent;
     m_pIcon = Q_NULLPTR;
+    m_nRow = -1;
 }
 
 GBL_RefItem::~GBL_RefItem()
@@ -1572,23 +2525,26 @@ void GBL_RefItem::cleanup()
     }
 
     m_refChildren.clear();
+    m_refChildIndex.clear();
 
 }
 
+/**
+ * @brief GBL_RefItem::addChild
+ * the child keeps its row and is hashed by key for findChild
+ * @param pRef
+ */
 void GBL_RefItem::addChild(GBL_RefItem *pRef)
 {
+    pRef->m_nRow = m_refChildren.size();
     m_refChildren.append(pRef);
+
+    if (!m_refChildIndex.contains(pRef->getKey())) m_refChildIndex.insert(pRef->getKey(), pRef);
 }
 
 GBL_RefItem* GBL_RefItem::findChild(QString sKey)
 {
-    for (int i = 0; i < m_refChildren.size(); i++)
-    {
-        GBL_RefItem *pRef = m_refChildren.at(i);
-        if (pRef->getKey() == sKey) return pRef;
-    }
-
-    return Q_NULLPTR;
+    return m_refChildIndex.value(sKey);
 }
 
 GBL_RefItem* GBL_RefItem::getChildAt(int index)
@@ -1615,16 +2571,6 @@ QStringList GBL_RefItem::getChildrenKeys()
 
 }
 
-int GBL_RefItem::index()
-{
-    if (m_pParentRef)
-    {
-        return m_pParentRef->getChildrenList()->indexOf(this);
-    }
-
-    return -1;
-}
-
 GBL_RefItem& GBL_RefItem::operator=(GBL_RefItem &ref)
 {
     cleanup();
@@ -1637,7 +2583,7 @@ GBL_RefItem& GBL_RefItem::operator=(GBL_RefItem &ref)
     {
         GBL_RefItem *pRefItem = new GBL_RefItem("","",this);
         *pRefItem = *ref.getChildAt(i);
-        m_refChildren.append(pRefItem);
+        addChild(pRefItem);
     }
 
     return *this;
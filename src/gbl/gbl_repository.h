@@ -2,6 +2,9 @@
 #define GBL_REPOSITORY_H
 
 #include "gbl_string.h"
+#include "gbl_commitstore.h"
+#include "gbl_diffbuffer.h"
+#include "gbl_filelist.h"
 
 #include <QObject>
 #include <git2.h>
@@ -9,6 +12,7 @@
 #include <QException>
 #include <QMap>
 #include <QStringList>
+#include <QSet>
 
 #define GBL_FILE_STATUS_ADDED 'A'
 #define GBL_FILE_STATUS_DELETED 'D'
@@ -23,6 +27,8 @@
 #define GBL_FILE_STATUS_UNKNOWN '?'
 #define GBL_FILE_STATUS_SYSTEM 'S'
 
+#define GBL_HISTORY_PAGE_SIZE 500
+
 
 
 typedef struct GBL_History_Item {
@@ -35,26 +41,33 @@ typedef struct GBL_History_Item {
     QStringList hist_parents;
 } GBL_History_Item;
 
-typedef QVector<GBL_History_Item*> GBL_History_Array;
+/**
+ * @brief The GBL_Status_Entry struct
+ * GBL_FILE_STATUS_ values of a path in the index and in the working tree,
+ * 0 where that side is clean
+ */
+typedef struct GBL_Status_Entry {
+    char staged;
+    char unstaged;
+} GBL_Status_Entry;
+
+typedef QMap<QString, GBL_Status_Entry> GBL_Status_Map;
 
-typedef struct GBL_File_Item {
-    char status;
-    QString file_name;
-    QString sub_dir;
-    QString file_oid;
-} GBL_File_Item;
+typedef struct GBL_Blob_Item {
+    git_oid blob_oid;
+    QString path;
+} GBL_Blob_Item;
 
-typedef QVector<GBL_File_Item*> GBL_File_Array;
+typedef QVector<GBL_Blob_Item> GBL_Blob_Array;
 
+typedef struct GBL_Tree_Entry {
+    git_oid entry_oid;
+    QString name;
+    bool is_tree;
+} GBL_Tree_Entry;
 
-typedef struct GBL_Line_Item {
-    char line_change_type;
-    int old_line_num;
-    int new_line_num;
-    QString content;
-} GBL_Line_Item;
+typedef QVector<GBL_Tree_Entry> GBL_Tree_Entry_Array;
 
-typedef QVector<GBL_Line_Item*> GBL_Line_Array;
 typedef QMap<QString, QString> GBL_Config_Map;
 
 
@@ -64,6 +77,7 @@ class MainWindow;
 class GBL_RefItem;
 class GBL_RefsModel;
 class GBL_HistoryModel;
+struct GBL_Raw_Commit;
 class GBL_Repository;
 QT_END_NAMESPACE
 
@@ -72,7 +86,7 @@ typedef QList<GBL_RefItem*> GBL_Ref_Children;
 
 
 typedef struct GBL_Tree_Walk_Payload {
-    GBL_File_Array *file_arr;
+    GBL_FileList *file_arr;
     GBL_Repository *repo;
 } GBL_Tree_Walk_Payload;
 
@@ -100,7 +114,7 @@ public:
     QStringList getChildrenKeys();
     int getChildCount() { return m_refChildren.size(); }
     GBL_Ref_Children* getChildrenList() { return &m_refChildren; }
-    int index();
+    int index() { return m_pParentRef ? m_nRow : -1; }
     QString getKey() { return m_sKey; }
     QString getRef() { return m_sRef; }
     QString getName() { return m_sName; }
@@ -117,9 +131,11 @@ private:
     QString m_sName;
     QString m_sRef;
     GBL_Ref_Children m_refChildren;
+    QHash<QString, GBL_RefItem*> m_refChildIndex;
     GBL_RefItem *m_pParentRef;
     QIcon *m_pIcon;
     TYPE m_eType;
+    int m_nRow;
 };
 
 
@@ -134,6 +150,10 @@ public:
     ~GBL_Repository();
 
     static int tree_walk_callback(const char *root, const git_tree_entry *entry, void *payload);
+    static int tree_blobs_callback(const char *root, const git_tree_entry *entry, void *payload);
+    static char delta_status(git_delta_t status);
+    static char index_status(unsigned int status);
+    static char workdir_status(unsigned int status);
     static int diff_print_files_callback(const git_diff_delta*, const git_diff_hunk*, const git_diff_line*, void *payload);
     static int diff_print_lines_callback(const git_diff_delta*, const git_diff_hunk*, const git_diff_line*, void *payload);
     static int staged_cb(const char *path, const char *matched_pathspec, void *payload);
@@ -144,6 +164,7 @@ public:
     bool init_repo(GBL_String path, bool bare=false);
     bool open_repo(GBL_String path);
     bool is_bare();
+    QString get_git_dir();
     bool clone_repo(GBL_String srcUrl, GBL_String dstPath);
     bool is_remote_repo(GBL_String path);
     bool add_to_index(QStringList *pList);
@@ -169,18 +190,39 @@ public:
     bool fill_stashes();
     GBL_RefItem* get_references() { return m_pRefRoot; }
     QStringList getBranchNames();
-    bool get_history(GBL_History_Array *io_pHistArr);
-    bool get_tree_from_commit_oid(GBL_String oid_str, GBL_File_Array *pHistFileArr);
-    void tree_walk(const git_oid *pTroid, GBL_File_Array *pHistFileArr);
-    bool get_commit_to_parent_diff_files(GBL_String oid_str, GBL_File_Array *pHistFileArr);
-    bool get_commit_to_parent_diff_lines(GBL_String oid_str, MainWindow *pMain, char *path);
-    bool get_index_to_work_diff(MainWindow *pMain, QStringList *pList);
-    bool get_index_to_head_diff(MainWindow *pMain, QStringList *pList);
+    bool history_walk_begin(git_revwalk **pWalker, const QVector<git_oid> &hideOids = QVector<git_oid>());
+    bool history_walk_from(git_revwalk **pWalker, const QVector<git_oid> &startOids);
+    bool get_head_oid(git_oid &oid, QString &sRefName);
+    bool is_descendant_of(const git_oid &commit, const git_oid &ancestor);
+    bool get_commit_message(GBL_String oid_str, QString &sMessage);
+    bool get_history(git_revwalk *pWalker, GBL_CommitStore *io_pStore, int nMaxRevs, bool &bMore);
+#ifdef QT_DEBUG
+    QString history_benchmark(int nCommits);
+#endif
+    bool get_tree_from_commit_oid(GBL_String oid_str, GBL_FileList *pHistFileArr);
+    void tree_walk(const git_oid *pTroid, GBL_FileList *pHistFileArr);
+    bool get_commit_to_parent_diff_files(GBL_String oid_str, GBL_FileList *pHistFileArr);
+    bool get_commit_to_parent_diff_lines(GBL_String oid_str, GBL_DiffBuffer *pBuffer, char *path);
+    bool get_commit_diffs(GBL_String oid_str, QVector<git_diff*> &diffs);
+    bool get_diff_files(git_diff *pDiff, GBL_FileList *pFileArr);
+    bool get_diff_patch(git_diff *pDiff, size_t nDelta, GBL_DiffBuffer *pBuffer, const GBL_Diff_Limits *pLimits = Q_NULLPTR);
+    bool get_diff_patches(git_diff *pDiff, GBL_DiffBuffer *pBuffer, const GBL_Diff_Limits *pLimits = Q_NULLPTR);
+    bool get_index_to_work_diff(GBL_DiffBuffer *pBuffer, QStringList *pList, const GBL_Diff_Limits *pLimits = Q_NULLPTR);
+    bool get_index_to_head_diff(GBL_DiffBuffer *pBuffer, QStringList *pList, const GBL_Diff_Limits *pLimits = Q_NULLPTR);
     bool get_blob_content(GBL_String oid_str, QString& content);
+    bool get_tree_blobs(const git_oid *pCommitOid, GBL_Blob_Array *pBlobArr);
+    bool get_commit_oids(const QString &sRange, QVector<git_oid> &oids);
+    bool get_commit_tree_oid(const git_oid &commitOid, git_oid &treeOid);
+    bool get_tree_entries(const git_oid &treeOid, GBL_Tree_Entry_Array &entries);
+    bool read_blob(const git_oid &oid, git_blob **pBlob, QByteArray &data, bool &bBinary);
+    bool get_missing_objects(const QVector<git_oid> &oids, QSet<git_oid> &missing);
     bool get_global_config_info(GBL_Config_Map **out);
     bool set_global_config_info(GBL_Config_Map *cfgMap);
 
-    bool get_repo_status(GBL_File_Array *pStagedArr, GBL_File_Array *pUnstagedArr);
+    bool get_repo_status(GBL_FileList *pStagedArr, GBL_FileList *pUnstagedArr);
+    bool get_status_entries(GBL_Status_Map &entries, git_status_show_t show, const QStringList *pPaths = Q_NULLPTR, bool bExact = false, bool bUntracked = true);
+    bool is_path_ignored(const QString &sPath);
+    bool get_index_dir_entries(const QString &sDir, QStringList &files, QStringList &subdirs);
 
     git_repository* get_repository() { return m_pRepo; }
     void set_repository(git_repository *pRepo) { m_pRepo = pRepo; }
@@ -197,7 +239,12 @@ private:
     //void cleanup_history();
     void init_ref_items();
     void check_libgit_return(int ret);
+    QString get_patch_over_limits(git_patch *pPatch, const GBL_Diff_Limits *pLimits);
+    qint64 diff_file_size(const git_diff_file &file);
+    void add_diff_summary(GBL_DiffBuffer *pBuffer, const git_diff_delta *pDelta, const QString &sNote);
     bool get_commit_to_parent_diff(GBL_String oid_str, git_diff_format_t format, git_diff_line_cb callback, void *payload, char *path=Q_NULLPTR);
+    bool read_raw_commit(git_odb *pOdb, const git_oid &oid, GBL_Raw_Commit *pRawCommit, GBL_CommitStore *io_pStore);
+    bool read_commit(const git_oid &oid, GBL_CommitStore *io_pStore);
 
     git_repository *m_pRepo;
     int m_iErrorCode;
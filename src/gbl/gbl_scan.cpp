@@ -0,0 +1,988 @@
+#include "gbl_scan.h"
+#include "gbl_threads.h"
+#include "gbl_storage.h"
+
+#include <QThread>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QMutexLocker>
+
+#include <string.h>
+
+/**
+ * @brief gbl_scan_snippet
+ * decodes the text around a hit, within its line, without splitting a utf-8 sequence
+ */
+static QString gbl_scan_snippet(const char *pLine, const char *pLineEnd, const char *pHit, int nHitLen)
+{
+    const char *pStart = pHit - pLine > GBL_SCAN_SNIPPET_CONTEXT ? pHit - GBL_SCAN_SNIPPET_CONTEXT : pLine;
+    const char *pStop = pLineEnd - pHit > nHitLen + GBL_SCAN_SNIPPET_CONTEXT ? pHit + nHitLen + GBL_SCAN_SNIPPET_CONTEXT : pLineEnd;
+
+    while (pStart > pLine && ((uchar)*pStart & 0xC0) == 0x80) pStart--;
+    while (pStop < pLineEnd && ((uchar)*pStop & 0xC0) == 0x80) pStop++;
+
+    return QString::fromUtf8(pStart, pStop - pStart).trimmed();
+}
+
+static inline void gbl_scan_widen(GBL_Scan_Range &range, const GBL_Scan_Range &other)
+{
+    if (other.first < range.first) range.first = other.first;
+    if (other.last > range.last) range.last = other.last;
+}
+
+/**
+ * @brief GBL_ScanJob::GBL_ScanJob
+ * @param repoPaths
+ * @param sSearch
+ * @param nSearchType
+ * @param nOptions SCAN_THREAD_OPTION_ flags
+ * @param sRange commits to search with SCAN_THREAD_OPTION_HISTORY, empty for
+ * the history of HEAD
+ * @param pOwner thread whose interruption cancels the scan
+ */
+GBL_ScanJob::GBL_ScanJob(const QStringList &repoPaths, const GBL_String &sSearch, int nSearchType, int nOptions, const GBL_String &sRange, QThread *pOwner)
+{
+    m_sSearch = sSearch;
+    m_sRange = sRange;
+    m_nSearchType = nSearchType;
+    m_nOptions = nOptions;
+    m_pOwner = pOwner;
+
+    for (int i = 0; i < repoPaths.size(); i++)
+    {
+        GBL_Scan_Repo *pScanRepo = new GBL_Scan_Repo;
+        pScanRepo->repo_path = repoPaths.at(i);
+        m_repos.append(pScanRepo);
+    }
+
+    // the search is prepared once here and only read by the tasks
+    m_bUnicodeFold = m_nSearchType == SCAN_THREAD_SEARCH_TYPE_INSENSITIVE && !GBL_SearchKernel::isAscii(m_sSearch.toUtf8());
+    if (m_nSearchType == SCAN_THREAD_SEARCH_TYPE_REGEX)
+    {
+        m_re.setPattern(m_sSearch);
+        m_re.optimize();
+    }
+    else
+    {
+        m_kernel.setPattern(m_sSearch.toUtf8(), m_nSearchType == SCAN_THREAD_SEARCH_TYPE_SENSITIVE);
+    }
+
+    // the index folds ASCII letters only, it would rule out the other cases of the rest
+    if ((m_nOptions & SCAN_THREAD_OPTION_USE_INDEX) && !m_bUnicodeFold)
+    {
+        m_literals = GBL_TrigramIndex::searchLiterals(m_sSearch, m_nSearchType == SCAN_THREAD_SEARCH_TYPE_REGEX);
+    }
+
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    if (m_nOptions & SCAN_THREAD_OPTION_BLOB_CACHE)
+    {
+        loadBlobCache();
+    }
+}
+
+/**
+ * @brief GBL_ScanJob::~GBL_ScanJob
+ */
+GBL_ScanJob::~GBL_ScanJob()
+{
+    cancel();
+    m_pool.waitForDone();
+
+    for (int i = 0; i < m_repos.size(); i++)
+    {
+        delete m_repos.at(i);
+    }
+}
+
+/**
+ * @brief GBL_ScanJob::start
+ * queues a task for every repository
+ */
+void GBL_ScanJob::start()
+{
+    for (int i = 0; i < m_repos.size(); i++)
+    {
+        m_pool.start(new GBL_ScanRepoTask(this, i));
+    }
+}
+
+/**
+ * @brief GBL_ScanJob::cancel
+ * drops the tasks not started yet, running tasks stop at their next blob
+ */
+void GBL_ScanJob::cancel()
+{
+    m_bCancel.store(1);
+    m_pool.clear();
+}
+
+/**
+ * @brief GBL_ScanJob::wait
+ * @param nMsecs
+ * @return true if every task has finished
+ */
+bool GBL_ScanJob::wait(int nMsecs)
+{
+    return m_pool.waitForDone(nMsecs);
+}
+
+bool GBL_ScanJob::isCancelled() const
+{
+    return m_bCancel.load() || (m_pOwner && m_pOwner->isInterruptionRequested());
+}
+
+/**
+ * @brief GBL_ScanJob::scanRepo
+ * lists the blobs in HEAD of one repository, queues all chunks but the first
+ * and searches the first itself. When history is searched the commits are
+ * listed and split into chunks instead, the blobs are searched once all of
+ * them are done.
+ * @param nRepo
+ */
+void GBL_ScanJob::scanRepo(int nRepo)
+{
+    GBL_Scan_Repo *pScanRepo = m_repos.at(nRepo);
+    if (isCancelled())
+    {
+        finishRepo(pScanRepo);
+        return;
+    }
+
+    GBL_Repository repo;
+    if (!repo.open_repo(pScanRepo->repo_path))
+    {
+        finishRepo(pScanRepo);
+        return;
+    }
+
+    if (m_nOptions & SCAN_THREAD_OPTION_HISTORY)
+    {
+        if (!repo.get_commit_oids(m_sRange, pScanRepo->commits) || pScanRepo->commits.isEmpty())
+        {
+            finishRepo(pScanRepo);
+            return;
+        }
+
+        int nChunks = (pScanRepo->commits.size() + GBL_SCAN_HISTORY_CHUNK - 1) / GBL_SCAN_HISTORY_CHUNK;
+        pScanRepo->chunk_leaves.resize(nChunks);
+        pScanRepo->pending.store(nChunks);
+
+        for (int nChunk = 1; nChunk < nChunks; nChunk++)
+        {
+            m_pool.start(new GBL_ScanHistoryTask(this, nRepo, nChunk), GBL_SCAN_CHUNK_PRIORITY);
+        }
+
+        scanHistoryChunk(&repo, nRepo, 0);
+        return;
+    }
+
+    if (!repo.get_tree_blobs(Q_NULLPTR, &pScanRepo->blobs))
+    {
+        finishRepo(pScanRepo);
+        return;
+    }
+
+    queueChunks(&repo, nRepo);
+}
+
+/**
+ * @brief GBL_ScanJob::scanHistoryChunk
+ * lists the blobs of one chunk of a repository's commits, the last chunk to
+ * finish merges them and starts searching
+ * @param pRepo open repository, or Q_NULLPTR if it couldn't be opened
+ * @param nRepo
+ * @param nChunk
+ */
+void GBL_ScanJob::scanHistoryChunk(GBL_Repository *pRepo, int nRepo, int nChunk)
+{
+    GBL_Scan_Repo *pScanRepo = m_repos.at(nRepo);
+    int nStart = nChunk * GBL_SCAN_HISTORY_CHUNK;
+    int nEnd = qMin(nStart + GBL_SCAN_HISTORY_CHUNK, pScanRepo->commits.size());
+
+    if (pRepo)
+    {
+        GBL_ScanHistoryWalk walk(pRepo);
+        for (int i = nStart; i < nEnd && !isCancelled(); i++)
+        {
+            walk.addCommit(pScanRepo->commits.at(i), i);
+        }
+
+        walk.takeLeaves(pScanRepo->chunk_leaves[nChunk]);
+    }
+
+    if (!pScanRepo->pending.deref())
+    {
+        mergeHistory(pScanRepo);
+        queueChunks(pRepo, nRepo);
+    }
+}
+
+/**
+ * @brief GBL_ScanJob::queueChunks
+ * splits a repository's blobs into chunks, queues all but the first and
+ * searches the first itself
+ * @param pRepo open repository, or Q_NULLPTR if it couldn't be opened
+ * @param nRepo
+ */
+void GBL_ScanJob::queueChunks(GBL_Repository *pRepo, int nRepo)
+{
+    GBL_Scan_Repo *pScanRepo = m_repos.at(nRepo);
+    if (!pRepo || isCancelled())
+    {
+        finishRepo(pScanRepo);
+        return;
+    }
+
+    if ((m_nOptions & SCAN_THREAD_OPTION_USE_INDEX) && !m_literals.isEmpty())
+    {
+        pruneWithIndex(pRepo, pScanRepo);
+    }
+
+    int nChunks = (pScanRepo->blobs.size() + GBL_SCAN_CHUNK_SIZE - 1) / GBL_SCAN_CHUNK_SIZE;
+    if (nChunks == 0)
+    {
+        finishRepo(pScanRepo);
+        return;
+    }
+
+    pScanRepo->chunk_matches.resize(nChunks);
+    pScanRepo->pending.store(nChunks);
+
+    for (int nChunk = 1; nChunk < nChunks; nChunk++)
+    {
+        m_pool.start(new GBL_ScanChunkTask(this, nRepo, nChunk), GBL_SCAN_CHUNK_PRIORITY);
+    }
+
+    scanChunk(pRepo, nRepo, 0);
+}
+
+/**
+ * @brief GBL_ScanJob::mergeHistory
+ * joins the blobs listed by every commit chunk into the repository's blobs,
+ * a blob at a path seen by more than one chunk gets the union of their ranges
+ * @param pScanRepo
+ */
+void GBL_ScanJob::mergeHistory(GBL_Scan_Repo *pScanRepo)
+{
+    QHash<QPair<QString, git_oid>, int> blobIndex;
+    GBL_Blob_Array blobs;
+    QVector<GBL_Scan_Range> ranges;
+
+    for (int nChunk = 0; nChunk < pScanRepo->chunk_leaves.size(); nChunk++)
+    {
+        const GBL_Scan_Leaf_Array &leaves = pScanRepo->chunk_leaves.at(nChunk);
+        for (int i = 0; i < leaves.size(); i++)
+        {
+            const GBL_Scan_Leaf &leaf = leaves.at(i);
+            QPair<QString, git_oid> key(leaf.blob.path, leaf.blob.blob_oid);
+            QHash<QPair<QString, git_oid>, int>::const_iterator it = blobIndex.constFind(key);
+            if (it == blobIndex.constEnd())
+            {
+                blobIndex.insert(key, blobs.size());
+                blobs.append(leaf.blob);
+                ranges.append(leaf.range);
+            }
+            else
+            {
+                gbl_scan_widen(ranges[it.value()], leaf.range);
+            }
+        }
+    }
+
+    pScanRepo->chunk_leaves = QVector<GBL_Scan_Leaf_Array>();
+    pScanRepo->blobs.swap(blobs);
+    pScanRepo->ranges.swap(ranges);
+}
+
+/**
+ * @brief GBL_ScanJob::mergeMatches
+ * joins the matches of a searched history that have the same path, text and
+ * occurrence of that text, they are the same line in different versions of a
+ * file. Lines repeated within a version stay apart. The line number is the
+ * one in the newest version.
+ * @param pScanRepo
+ */
+void GBL_ScanJob::mergeMatches(GBL_Scan_Repo *pScanRepo)
+{
+    QHash<QString, int> matchIndex;
+    GBL_Scan_Match_Array merged;
+
+    for (int nChunk = 0; nChunk < pScanRepo->chunk_matches.size(); nChunk++)
+    {
+        const GBL_Scan_Match_Array &matches = pScanRepo->chunk_matches.at(nChunk);
+        for (int i = 0; i < matches.size(); i++)
+        {
+            const GBL_Scan_Match &match = matches.at(i);
+            QString sKey = match.file_path + '\n' + QString::number(match.occurrence) + '\n' + match.snippet;
+            QHash<QString, int>::const_iterator it = matchIndex.constFind(sKey);
+            if (it == matchIndex.constEnd())
+            {
+                matchIndex.insert(sKey, merged.size());
+                merged.append(match);
+                continue;
+            }
+
+            GBL_Scan_Match &prev = merged[it.value()];
+            if (match.first_commit < prev.first_commit) prev.first_commit = match.first_commit;
+            if (match.last_commit > prev.last_commit)
+            {
+                prev.last_commit = match.last_commit;
+                prev.line_no = match.line_no;
+            }
+        }
+    }
+
+    char oidStr[GIT_OID_HEXSZ + 1];
+    for (int i = 0; i < merged.size(); i++)
+    {
+        GBL_Scan_Match &match = merged[i];
+        if (match.first_commit < 0) continue;
+
+        git_oid_tostr(oidStr, sizeof(oidStr), &pScanRepo->commits.at(match.first_commit));
+        match.first_oid = QString::fromLatin1(oidStr);
+        git_oid_tostr(oidStr, sizeof(oidStr), &pScanRepo->commits.at(match.last_commit));
+        match.last_oid = QString::fromLatin1(oidStr);
+    }
+
+    pScanRepo->chunk_matches.resize(1);
+    pScanRepo->chunk_matches[0].swap(merged);
+}
+
+/**
+ * @brief GBL_ScanJob::scanChunk
+ * searches one chunk of a repository's blobs, the last chunk to finish
+ * marks the repository done
+ * @param pRepo open repository, or Q_NULLPTR if it couldn't be opened
+ * @param nRepo
+ * @param nChunk
+ */
+void GBL_ScanJob::scanChunk(GBL_Repository *pRepo, int nRepo, int nChunk)
+{
+    GBL_Scan_Repo *pScanRepo = m_repos.at(nRepo);
+    GBL_Scan_Match_Array &matches = pScanRepo->chunk_matches[nChunk];
+    int nStart = nChunk * GBL_SCAN_CHUNK_SIZE;
+    int nEnd = qMin(nStart + GBL_SCAN_CHUNK_SIZE, pScanRepo->blobs.size());
+
+    QByteArray data;
+
+    for (int i = nStart; pRepo && i < nEnd; i++)
+    {
+        if (isCancelled()) break;
+
+        const GBL_Blob_Item &blobItem = pScanRepo->blobs.at(i);
+        const GBL_Scan_Range *pRange = i < pScanRepo->ranges.size() ? &pScanRepo->ranges.at(i) : Q_NULLPTR;
+        GBL_Scan_Hit_Array hits;
+
+        // forks and vendored copies share blobs, each is only searched once
+        int nBlob = lookupBlob(blobItem.blob_oid, hits);
+        if (nBlob == GBL_SCAN_BLOB_KNOWN)
+        {
+            m_nSharedBlobs.fetchAndAddRelaxed(1);
+            addMatches(blobItem.path, hits, pRange, matches);
+            continue;
+        }
+
+        // the content is searched where libgit2 holds it, until the blob is freed
+        git_blob *pBlob = Q_NULLPTR;
+        bool bBinary = false;
+        bool bRead = pRepo->read_blob(blobItem.blob_oid, &pBlob, data, bBinary);
+        if (bRead)
+        {
+            m_nBlobs.fetchAndAddRelaxed(1);
+            m_nBytes.fetchAndAddRelaxed(data.size());
+
+            if (!bBinary && m_nSearchType == SCAN_THREAD_SEARCH_TYPE_REGEX)
+            {
+                searchBlobRegex(data, hits);
+            }
+            else if (!bBinary && m_bUnicodeFold)
+            {
+                searchBlobText(data, hits);
+            }
+            else if (!bBinary)
+            {
+                searchBlob(data, hits);
+            }
+        }
+        data.clear();
+        if (pBlob) git_blob_free(pBlob);
+
+        if (nBlob == GBL_SCAN_BLOB_CLAIMED)
+        {
+            storeBlob(blobItem.blob_oid, hits, bRead);
+        }
+
+        addMatches(blobItem.path, hits, pRange, matches);
+    }
+
+    if (!pScanRepo->pending.deref())
+    {
+        finishRepo(pScanRepo);
+    }
+}
+
+/**
+ * @brief GBL_ScanJob::searchBlob
+ * finds the literal in the raw blob, one hit per line. Only the text around
+ * each hit is decoded.
+ * @param data
+ * @param hits
+ * @return the number of hits added
+ */
+int GBL_ScanJob::searchBlob(const QByteArray &data, GBL_Scan_Hit_Array &hits) const
+{
+    const char *pData = data.constData();
+    const char *pEnd = pData + data.size();
+    const char *pLine = pData;
+    const char *p = pData;
+    int nLine = 1;
+    int nFound = 0;
+
+    while (nFound < GBL_SCAN_MAX_FILE_MATCHES && p < pEnd && (p = m_kernel.find(p, pEnd)))
+    {
+        // count the lines passed since the last hit
+        const char *pNewline;
+        while ((pNewline = (const char*)memchr(pLine, '\n', p - pLine)))
+        {
+            nLine++;
+            pLine = pNewline + 1;
+        }
+
+        const char *pLineEnd = (const char*)memchr(p, '\n', pEnd - p);
+        if (!pLineEnd) pLineEnd = pEnd;
+
+        GBL_Scan_Hit hit;
+        hit.line_no = nLine;
+        hit.snippet = gbl_scan_snippet(pLine, pLineEnd, p, m_kernel.size());
+        hits.append(hit);
+        nFound++;
+
+        p = pLineEnd;
+    }
+
+    return nFound;
+}
+
+/**
+ * @brief GBL_ScanJob::searchBlobRegex
+ * matches the expression compiled for the scan against the decoded blob,
+ * one hit per line
+ * @param data
+ * @param hits
+ * @return the number of hits added
+ */
+int GBL_ScanJob::searchBlobRegex(const QByteArray &data, GBL_Scan_Hit_Array &hits) const
+{
+    if (!m_re.isValid()) return 0;
+
+    QString content = QString::fromUtf8(data);
+    QRegularExpressionMatchIterator it = m_re.globalMatch(content);
+    int nLine = 1;
+    int nLineStart = 0;
+    int nNextLine = 0;
+    int nFound = 0;
+
+    while (nFound < GBL_SCAN_MAX_FILE_MATCHES && it.hasNext())
+    {
+        QRegularExpressionMatch reMatch = it.next();
+        int nPos = reMatch.capturedStart();
+        if (nPos < nNextLine) continue;
+
+        int nNewline;
+        while ((nNewline = content.indexOf('\n', nLineStart)) >= 0 && nNewline < nPos)
+        {
+            nLine++;
+            nLineStart = nNewline + 1;
+        }
+
+        int nLineEnd = nNewline >= 0 ? nNewline : content.size();
+        int nStart = qMax(nLineStart, nPos - GBL_SCAN_SNIPPET_CONTEXT);
+        int nStop = qMin(nLineEnd, nPos + reMatch.capturedLength() + GBL_SCAN_SNIPPET_CONTEXT);
+
+        GBL_Scan_Hit hit;
+        hit.line_no = nLine;
+        hit.snippet = content.mid(nStart, nStop - nStart).trimmed();
+        hits.append(hit);
+        nFound++;
+
+        nNextLine = nLineEnd + 1;
+    }
+
+    return nFound;
+}
+
+/**
+ * @brief GBL_ScanJob::searchBlobText
+ * finds the search in the decoded blob ignoring case beyond ASCII, for the
+ * case insensitive searches the kernel can't fold, one hit per line
+ * @param data
+ * @param hits
+ * @return the number of hits added
+ */
+int GBL_ScanJob::searchBlobText(const QByteArray &data, GBL_Scan_Hit_Array &hits) const
+{
+    QString content = QString::fromUtf8(data);
+    QString sSearch = m_sSearch;
+    int nLine = 1;
+    int nLineStart = 0;
+    int nPos = 0;
+    int nFound = 0;
+
+    while (nFound < GBL_SCAN_MAX_FILE_MATCHES && (nPos = content.indexOf(sSearch, nPos, Qt::CaseInsensitive)) >= 0)
+    {
+        int nNewline;
+        while ((nNewline = content.indexOf('\n', nLineStart)) >= 0 && nNewline < nPos)
+        {
+            nLine++;
+            nLineStart = nNewline + 1;
+        }
+
+        int nLineEnd = nNewline >= 0 ? nNewline : content.size();
+        int nStart = qMax(nLineStart, nPos - GBL_SCAN_SNIPPET_CONTEXT);
+        int nStop = qMin(nLineEnd, nPos + sSearch.size() + GBL_SCAN_SNIPPET_CONTEXT);
+
+        GBL_Scan_Hit hit;
+        hit.line_no = nLine;
+        hit.snippet = content.mid(nStart, nStop - nStart).trimmed();
+        hits.append(hit);
+        nFound++;
+
+        nPos = nLineEnd + 1;
+        if (nPos >= content.size()) break;
+    }
+
+    return nFound;
+}
+
+/**
+ * @brief GBL_ScanJob::lookupBlob
+ * @param oid
+ * @param hits filled in if the blob was searched already
+ * @return GBL_SCAN_BLOB_KNOWN if the blob was searched, GBL_SCAN_BLOB_CLAIMED
+ * if the caller is the first to see it and has to store its hits, or
+ * GBL_SCAN_BLOB_BUSY if another task is searching it right now
+ */
+int GBL_ScanJob::lookupBlob(const git_oid &oid, GBL_Scan_Hit_Array &hits)
+{
+    QMutexLocker locker(&m_blobMutex);
+
+    QHash<git_oid, GBL_Scan_Blob>::const_iterator it = m_blobs.constFind(oid);
+    if (it == m_blobs.constEnd())
+    {
+        GBL_Scan_Blob scanBlob;
+        scanBlob.pending = true;
+        m_blobs.insert(oid, scanBlob);
+
+        return GBL_SCAN_BLOB_CLAIMED;
+    }
+
+    if (it.value().pending) return GBL_SCAN_BLOB_BUSY;
+
+    hits = it.value().hits;
+
+    return GBL_SCAN_BLOB_KNOWN;
+}
+
+/**
+ * @brief GBL_ScanJob::storeBlob
+ * @param oid a blob claimed with lookupBlob
+ * @param hits
+ * @param bSearched false if the blob couldn't be read, the claim is dropped
+ * so another repository holding the blob can try
+ */
+void GBL_ScanJob::storeBlob(const git_oid &oid, const GBL_Scan_Hit_Array &hits, bool bSearched)
+{
+    QMutexLocker locker(&m_blobMutex);
+
+    if (!bSearched)
+    {
+        m_blobs.remove(oid);
+        return;
+    }
+
+    GBL_Scan_Blob &scanBlob = m_blobs[oid];
+    scanBlob.pending = false;
+    scanBlob.hits = hits;
+}
+
+/**
+ * @brief GBL_ScanJob::addMatches
+ * @param sPath
+ * @param hits
+ * @param pRange commits the blob was seen in, Q_NULLPTR outside history
+ * @param matches
+ */
+void GBL_ScanJob::addMatches(const QString &sPath, const GBL_Scan_Hit_Array &hits, const GBL_Scan_Range *pRange, GBL_Scan_Match_Array &matches) const
+{
+    QHash<QString, int> occurrences;
+    for (int i = 0; i < hits.size(); i++)
+    {
+        GBL_Scan_Match match;
+        match.file_path = sPath;
+        match.line_no = hits.at(i).line_no;
+        match.snippet = hits.at(i).snippet;
+        match.occurrence = pRange ? occurrences[match.snippet]++ : 0;
+        match.first_commit = pRange ? pRange->first : -1;
+        match.last_commit = pRange ? pRange->last : -1;
+        matches.append(match);
+    }
+}
+
+/**
+ * @brief GBL_ScanJob::loadBlobCache
+ * reads the blobs searched for the same search by earlier scans
+ * @return
+ */
+bool GBL_ScanJob::loadBlobCache()
+{
+    QFile file(GBL_Storage::getScanCacheFile(m_sSearch, m_nSearchType));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray baMagic;
+    quint32 nVersion = 0, nCount = 0;
+    in >> baMagic >> nVersion >> nCount;
+    if (baMagic != GBL_SCAN_CACHE_MAGIC || nVersion != GBL_SCAN_CACHE_VERSION) return false;
+
+    QHash<git_oid, GBL_Scan_Blob> blobs;
+    blobs.reserve(nCount);
+    for (quint32 n = 0; n < nCount && in.status() == QDataStream::Ok; n++)
+    {
+        git_oid oid;
+        quint32 nHits = 0;
+        if (in.readRawData((char*)oid.id, GIT_OID_RAWSZ) != GIT_OID_RAWSZ) return false;
+        in >> nHits;
+
+        GBL_Scan_Blob scanBlob;
+        scanBlob.pending = false;
+        for (quint32 i = 0; i < nHits && in.status() == QDataStream::Ok; i++)
+        {
+            qint32 nLine = 0;
+            GBL_Scan_Hit hit;
+            in >> nLine >> hit.snippet;
+            hit.line_no = nLine;
+            scanBlob.hits.append(hit);
+        }
+
+        blobs.insert(oid, scanBlob);
+    }
+
+    if (in.status() != QDataStream::Ok) return false;
+
+    QMutexLocker locker(&m_blobMutex);
+    m_blobs.swap(blobs);
+
+    return true;
+}
+
+/**
+ * @brief GBL_ScanJob::saveBlobCache
+ * writes every blob searched by this scan and the ones loaded with it,
+ * only call once the scan has finished
+ * @return
+ */
+bool GBL_ScanJob::saveBlobCache()
+{
+    QMutexLocker locker(&m_blobMutex);
+
+    QSaveFile file(GBL_Storage::getScanCacheFile(m_sSearch, m_nSearchType));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << QByteArray(GBL_SCAN_CACHE_MAGIC) << (quint32)GBL_SCAN_CACHE_VERSION << (quint32)m_blobs.size();
+
+    QHash<git_oid, GBL_Scan_Blob>::const_iterator it;
+    for (it = m_blobs.constBegin(); it != m_blobs.constEnd(); ++it)
+    {
+        const GBL_Scan_Hit_Array &hits = it.value().hits;
+        out.writeRawData((const char*)it.key().id, GIT_OID_RAWSZ);
+        out << (quint32)hits.size();
+        for (int i = 0; i < hits.size(); i++)
+        {
+            out << (qint32)hits.at(i).line_no << hits.at(i).snippet;
+        }
+    }
+
+    if (out.status() != QDataStream::Ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+/**
+ * @brief GBL_ScanJob::pruneWithIndex
+ * brings the repository's trigram index up to date with the blobs to search
+ * and drops the blobs that can't hold the search. The index keeps the blobs
+ * of every scan, HEAD or history, and only loses the ones gone from the
+ * object database.
+ * @param pRepo
+ * @param pScanRepo
+ */
+void GBL_ScanJob::pruneWithIndex(GBL_Repository *pRepo, GBL_Scan_Repo *pScanRepo)
+{
+    QString sIndexFile = GBL_Storage::getTrigramIndexFile(pScanRepo->repo_path);
+    GBL_TrigramIndex index;
+    index.load(sIndexFile);
+
+    // checking costs a lookup per blob, so only once the index has doubled
+    if (index.blobCount() - index.checkedCount() > qMax(index.checkedCount(), GBL_SCAN_INDEX_SLACK))
+    {
+        QSet<git_oid> missing;
+        if (pRepo->get_missing_objects(index.blobOids(), missing))
+        {
+            index.removeBlobs(missing);
+            index.setChecked();
+        }
+    }
+
+    QByteArray data;
+    for (int i = 0; i < pScanRepo->blobs.size(); i++)
+    {
+        if (isCancelled()) return;
+
+        const git_oid &oid = pScanRepo->blobs.at(i).blob_oid;
+        if (index.contains(oid)) continue;
+
+        git_blob *pBlob = Q_NULLPTR;
+        bool bBinary = false;
+        if (pRepo->read_blob(oid, &pBlob, data, bBinary))
+        {
+            index.addBlob(oid, data.constData(), bBinary ? 0 : data.size());
+        }
+        data.clear();
+        if (pBlob) git_blob_free(pBlob);
+    }
+
+    if (index.isModified())
+    {
+        index.save(sIndexFile);
+    }
+
+    QSet<git_oid> candidates;
+    if (!index.candidates(m_literals, candidates)) return;
+
+    GBL_Blob_Array blobs;
+    QVector<GBL_Scan_Range> ranges;
+    for (int i = 0; i < pScanRepo->blobs.size(); i++)
+    {
+        const GBL_Blob_Item &blobItem = pScanRepo->blobs.at(i);
+        if (!index.contains(blobItem.blob_oid) || candidates.contains(blobItem.blob_oid))
+        {
+            blobs.append(blobItem);
+            if (i < pScanRepo->ranges.size()) ranges.append(pScanRepo->ranges.at(i));
+        }
+    }
+
+    m_nPrunedBlobs.fetchAndAddRelaxed(pScanRepo->blobs.size() - blobs.size());
+    pScanRepo->blobs.swap(blobs);
+    pScanRepo->ranges.swap(ranges);
+}
+
+/**
+ * @brief GBL_ScanJob::finishRepo
+ * @param pScanRepo
+ */
+void GBL_ScanJob::finishRepo(GBL_Scan_Repo *pScanRepo)
+{
+    if (!pScanRepo->commits.isEmpty())
+    {
+        mergeMatches(pScanRepo);
+    }
+
+    pScanRepo->blobs = GBL_Blob_Array();
+    pScanRepo->ranges = QVector<GBL_Scan_Range>();
+    pScanRepo->chunk_leaves = QVector<GBL_Scan_Leaf_Array>();
+    pScanRepo->commits = QVector<git_oid>();
+    pScanRepo->done.storeRelease(1);
+    m_nFinished.ref();
+}
+
+/**
+ * @brief GBL_ScanRepoTask::GBL_ScanRepoTask
+ * @param pJob
+ * @param nRepo
+ */
+GBL_ScanRepoTask::GBL_ScanRepoTask(GBL_ScanJob *pJob, int nRepo)
+{
+    m_pJob = pJob;
+    m_nRepo = nRepo;
+}
+
+void GBL_ScanRepoTask::run()
+{
+    m_pJob->scanRepo(m_nRepo);
+}
+
+/**
+ * @brief GBL_ScanHistoryTask::GBL_ScanHistoryTask
+ * @param pJob
+ * @param nRepo
+ * @param nChunk
+ */
+GBL_ScanHistoryTask::GBL_ScanHistoryTask(GBL_ScanJob *pJob, int nRepo, int nChunk)
+{
+    m_pJob = pJob;
+    m_nRepo = nRepo;
+    m_nChunk = nChunk;
+}
+
+void GBL_ScanHistoryTask::run()
+{
+    GBL_Repository repo;
+    const GBL_Scan_Repo *pScanRepo = m_pJob->repo(m_nRepo);
+    bool bOpen = !m_pJob->isCancelled() && repo.open_repo(pScanRepo->repo_path);
+
+    m_pJob->scanHistoryChunk(bOpen ? &repo : Q_NULLPTR, m_nRepo, m_nChunk);
+}
+
+/**
+ * @brief GBL_ScanChunkTask::GBL_ScanChunkTask
+ * @param pJob
+ * @param nRepo
+ * @param nChunk
+ */
+GBL_ScanChunkTask::GBL_ScanChunkTask(GBL_ScanJob *pJob, int nRepo, int nChunk)
+{
+    m_pJob = pJob;
+    m_nRepo = nRepo;
+    m_nChunk = nChunk;
+}
+
+void GBL_ScanChunkTask::run()
+{
+    GBL_Repository repo;
+    const GBL_Scan_Repo *pScanRepo = m_pJob->repo(m_nRepo);
+    bool bOpen = !m_pJob->isCancelled() && repo.open_repo(pScanRepo->repo_path);
+
+    m_pJob->scanChunk(bOpen ? &repo : Q_NULLPTR, m_nRepo, m_nChunk);
+}
+
+/**
+ * @brief GBL_ScanHistoryWalk::GBL_ScanHistoryWalk
+ * @param pRepo repository the commits are read from
+ */
+GBL_ScanHistoryWalk::GBL_ScanHistoryWalk(GBL_Repository *pRepo)
+{
+    m_pRepo = pRepo;
+}
+
+/**
+ * @brief GBL_ScanHistoryWalk::addCommit
+ * @param commitOid
+ * @param nCommit number of the commit in the repository's commits
+ * @return
+ */
+bool GBL_ScanHistoryWalk::addCommit(const git_oid &commitOid, int nCommit)
+{
+    git_oid treeOid;
+    if (!m_pRepo->get_commit_tree_oid(commitOid, treeOid)) return false;
+
+    return addTree(QString(), 0, treeOid, nCommit) >= 0;
+}
+
+/**
+ * @brief GBL_ScanHistoryWalk::addTree
+ * @param sPrefix path of the tree, empty or ending in a slash
+ * @param nDepth
+ * @param treeOid
+ * @param nCommit
+ * @return the node of the tree, or -1 if it couldn't be read
+ */
+int GBL_ScanHistoryWalk::addTree(const QString &sPrefix, int nDepth, const git_oid &treeOid, int nCommit)
+{
+    GBL_Scan_Range range;
+    range.first = nCommit;
+    range.last = nCommit;
+
+    QPair<QString, git_oid> key(sPrefix, treeOid);
+    QHash<QPair<QString, git_oid>, int>::const_iterator it = m_nodeIndex.constFind(key);
+    if (it != m_nodeIndex.constEnd())
+    {
+        gbl_scan_widen(m_nodes[it.value()].range, range);
+        return it.value();
+    }
+
+    GBL_Tree_Entry_Array entries;
+    if (!m_pRepo->get_tree_entries(treeOid, entries)) return -1;
+
+    // nodes are only referred to by number, m_nodes grows while recursing
+    int nNode = m_nodes.size();
+    GBL_Scan_Tree_Node node;
+    node.range = range;
+    m_nodes.append(node);
+    m_nodeIndex.insert(key, nNode);
+    if (m_depthNodes.size() <= nDepth) m_depthNodes.resize(nDepth + 1);
+    m_depthNodes[nDepth].append(nNode);
+
+    for (int i = 0; i < entries.size(); i++)
+    {
+        const GBL_Tree_Entry &entry = entries.at(i);
+        if (entry.is_tree)
+        {
+            int nChild = addTree(sPrefix + entry.name + '/', nDepth + 1, entry.entry_oid, nCommit);
+            if (nChild >= 0) m_nodes[nNode].trees.append(nChild);
+            continue;
+        }
+
+        QPair<QString, git_oid> leafKey(sPrefix + entry.name, entry.entry_oid);
+        QHash<QPair<QString, git_oid>, int>::const_iterator itLeaf = m_leafIndex.constFind(leafKey);
+        int nLeaf;
+        if (itLeaf == m_leafIndex.constEnd())
+        {
+            nLeaf = m_leaves.size();
+            GBL_Scan_Leaf leaf;
+            leaf.blob.blob_oid = entry.entry_oid;
+            leaf.blob.path = leafKey.first;
+            leaf.range = range;
+            m_leaves.append(leaf);
+            m_leafIndex.insert(leafKey, nLeaf);
+        }
+        else
+        {
+            nLeaf = itLeaf.value();
+            gbl_scan_widen(m_leaves[nLeaf].range, range);
+        }
+
+        m_nodes[nNode].leaves.append(nLeaf);
+    }
+
+    return nNode;
+}
+
+/**
+ * @brief GBL_ScanHistoryWalk::takeLeaves
+ * pushes every tree's range down to its subtrees and blobs, shallow trees
+ * first since a tree's parents are all one level up, then hands the blobs over
+ * @param leaves
+ */
+void GBL_ScanHistoryWalk::takeLeaves(GBL_Scan_Leaf_Array &leaves)
+{
+    for (int nDepth = 0; nDepth < m_depthNodes.size(); nDepth++)
+    {
+        const QVector<int> &nodes = m_depthNodes.at(nDepth);
+        for (int i = 0; i < nodes.size(); i++)
+        {
+            const GBL_Scan_Tree_Node &node = m_nodes.at(nodes.at(i));
+            for (int j = 0; j < node.trees.size(); j++)
+            {
+                gbl_scan_widen(m_nodes[node.trees.at(j)].range, node.range);
+            }
+            for (int j = 0; j < node.leaves.size(); j++)
+            {
+                gbl_scan_widen(m_leaves[node.leaves.at(j)].range, node.range);
+            }
+        }
+    }
+
+    leaves.clear();
+    leaves.swap(m_leaves);
+    m_leafIndex.clear();
+}
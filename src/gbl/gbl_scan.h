@@ -0,0 +1,273 @@
+#ifndef GBL_SCAN_H
+#define GBL_SCAN_H
+
+#include "gbl_string.h"
+#include "gbl_repository.h"
+#include "gbl_search.h"
+#include "gbl_trigramindex.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QStringList>
+#include <QRegularExpression>
+#include <QMutex>
+#include <QHash>
+#include <QPair>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+#define GBL_SCAN_CHUNK_SIZE         512
+#define GBL_SCAN_CHUNK_PRIORITY     1
+#define GBL_SCAN_UPDATE_MSECS       250
+#define GBL_SCAN_MAX_FILE_MATCHES   1000
+#define GBL_SCAN_SNIPPET_CONTEXT    50
+
+// commits per task when searching history
+#define GBL_SCAN_HISTORY_CHUNK      128
+
+#define GBL_SCAN_CACHE_MAGIC        "GBLS"
+#define GBL_SCAN_CACHE_VERSION      1
+
+// blobs added to an index before it is checked against the object database
+#define GBL_SCAN_INDEX_SLACK        1024
+
+// results of GBL_ScanJob::lookupBlob
+#define GBL_SCAN_BLOB_KNOWN         1
+#define GBL_SCAN_BLOB_CLAIMED       0
+#define GBL_SCAN_BLOB_BUSY          -1
+
+typedef struct GBL_Scan_Hit {
+    int line_no;
+    QString snippet;
+} GBL_Scan_Hit;
+
+typedef QVector<GBL_Scan_Hit> GBL_Scan_Hit_Array;
+
+/**
+ * @brief The GBL_Scan_Blob struct
+ * hits of one blob, shared by every path and repository holding the blob.
+ * pending is set while the blob is being searched.
+ */
+typedef struct GBL_Scan_Blob {
+    bool pending;
+    GBL_Scan_Hit_Array hits;
+} GBL_Scan_Blob;
+
+/**
+ * @brief The GBL_Scan_Range struct
+ * first and last commit something was seen in, as numbers into the
+ * repository's commits, oldest first
+ */
+typedef struct GBL_Scan_Range {
+    int first;
+    int last;
+} GBL_Scan_Range;
+
+typedef struct GBL_Scan_Leaf {
+    GBL_Blob_Item blob;
+    GBL_Scan_Range range;
+} GBL_Scan_Leaf;
+
+typedef QVector<GBL_Scan_Leaf> GBL_Scan_Leaf_Array;
+
+/**
+ * @brief The GBL_Scan_Match struct
+ * first_commit and last_commit are -1 unless history was searched, the oids
+ * are filled in once the repository is done. occurrence counts the lines
+ * before this one in the same blob with the same snippet.
+ */
+typedef struct GBL_Scan_Match {
+    QString repo_name;
+    QString file_path;
+    int line_no;
+    QString snippet;
+    int occurrence;
+    int first_commit;
+    int last_commit;
+    QString first_oid;
+    QString last_oid;
+} GBL_Scan_Match;
+
+typedef QVector<GBL_Scan_Match> GBL_Scan_Match_Array;
+
+/**
+ * @brief The GBL_Scan_Repo struct
+ * one repository of a scan. Its blobs are searched in chunks that may run on
+ * different threads, each chunk only writes its own match array. When history
+ * is searched the commits are first listed in chunks the same way, and ranges
+ * holds the commits each blob was seen in.
+ */
+typedef struct GBL_Scan_Repo {
+    GBL_String repo_path;
+    GBL_Blob_Array blobs;
+    QVector<git_oid> commits;
+    QVector<GBL_Scan_Range> ranges;
+    QVector<GBL_Scan_Leaf_Array> chunk_leaves;
+    QVector<GBL_Scan_Match_Array> chunk_matches;
+    QAtomicInt pending;
+    QAtomicInt done;
+} GBL_Scan_Repo;
+
+/**
+ * @brief The GBL_ScanJob class
+ * one scan over a list of repositories, run on a pool with a thread per core.
+ * Every repository is a task, a repository with more than one chunk of blobs
+ * queues its other chunks ahead of the repositories not started yet, so
+ * repositories finish roughly in the order they were listed.
+ */
+class GBL_ScanJob
+{
+public:
+    GBL_ScanJob(const QStringList &repoPaths, const GBL_String &sSearch, int nSearchType, int nOptions, const GBL_String &sRange, QThread *pOwner);
+    ~GBL_ScanJob();
+
+    void start();
+    void cancel();
+    bool wait(int nMsecs = -1);
+    bool isCancelled() const;
+
+    int repoCount() const { return m_repos.size(); }
+    int finishedCount() const { return m_nFinished.load(); }
+    bool isRepoDone(int nRepo) const { return m_repos.at(nRepo)->done.loadAcquire() != 0; }
+    const GBL_Scan_Repo* repo(int nRepo) const { return m_repos.at(nRepo); }
+    qint64 blobCount() const { return m_nBlobs.load(); }
+    qint64 byteCount() const { return m_nBytes.load(); }
+    qint64 sharedBlobCount() const { return m_nSharedBlobs.load(); }
+    qint64 prunedBlobCount() const { return m_nPrunedBlobs.load(); }
+
+    bool loadBlobCache();
+    bool saveBlobCache();
+
+    void scanRepo(int nRepo);
+    void scanHistoryChunk(GBL_Repository *pRepo, int nRepo, int nChunk);
+    void scanChunk(GBL_Repository *pRepo, int nRepo, int nChunk);
+
+private:
+    void queueChunks(GBL_Repository *pRepo, int nRepo);
+    void mergeHistory(GBL_Scan_Repo *pScanRepo);
+    void mergeMatches(GBL_Scan_Repo *pScanRepo);
+    int searchBlob(const QByteArray &data, GBL_Scan_Hit_Array &hits) const;
+    int searchBlobRegex(const QByteArray &data, GBL_Scan_Hit_Array &hits) const;
+    int searchBlobText(const QByteArray &data, GBL_Scan_Hit_Array &hits) const;
+    int lookupBlob(const git_oid &oid, GBL_Scan_Hit_Array &hits);
+    void storeBlob(const git_oid &oid, const GBL_Scan_Hit_Array &hits, bool bSearched);
+    void addMatches(const QString &sPath, const GBL_Scan_Hit_Array &hits, const GBL_Scan_Range *pRange, GBL_Scan_Match_Array &matches) const;
+    void finishRepo(GBL_Scan_Repo *pScanRepo);
+    void pruneWithIndex(GBL_Repository *pRepo, GBL_Scan_Repo *pScanRepo);
+
+    QThreadPool m_pool;
+    QVector<GBL_Scan_Repo*> m_repos;
+    GBL_String m_sSearch;
+    GBL_String m_sRange;
+    int m_nSearchType;
+    int m_nOptions;
+    GBL_SearchKernel m_kernel;
+    bool m_bUnicodeFold;
+    QRegularExpression m_re;
+    QList<QByteArray> m_literals;
+    QThread *m_pOwner;
+    QAtomicInt m_bCancel;
+    QAtomicInt m_nFinished;
+    QAtomicInteger<qint64> m_nBlobs;
+    QAtomicInteger<qint64> m_nBytes;
+    QAtomicInteger<qint64> m_nSharedBlobs;
+    QAtomicInteger<qint64> m_nPrunedBlobs;
+
+    // every blob searched so far in this scan, by oid
+    QMutex m_blobMutex;
+    QHash<git_oid, GBL_Scan_Blob> m_blobs;
+};
+
+/**
+ * @brief The GBL_Scan_Tree_Node struct
+ * one tree at one path and the commits it was seen in
+ */
+typedef struct GBL_Scan_Tree_Node {
+    GBL_Scan_Range range;
+    QVector<int> trees;
+    QVector<int> leaves;
+} GBL_Scan_Tree_Node;
+
+/**
+ * @brief The GBL_ScanHistoryWalk class
+ * collects the blobs of a run of commits with the commits each was seen in.
+ * A tree is only listed the first time it shows up at a path, later commits
+ * holding it just widen its range, and the ranges are pushed down to the
+ * subtrees and blobs once at the end. Most commits only touch a few trees,
+ * so a commit costs about as much as the trees it changed.
+ */
+class GBL_ScanHistoryWalk
+{
+public:
+    GBL_ScanHistoryWalk(GBL_Repository *pRepo);
+
+    bool addCommit(const git_oid &commitOid, int nCommit);
+    void takeLeaves(GBL_Scan_Leaf_Array &leaves);
+
+private:
+    int addTree(const QString &sPrefix, int nDepth, const git_oid &treeOid, int nCommit);
+
+    GBL_Repository *m_pRepo;
+    QVector<GBL_Scan_Tree_Node> m_nodes;
+    QVector<QVector<int> > m_depthNodes;
+    QHash<QPair<QString, git_oid>, int> m_nodeIndex;
+    GBL_Scan_Leaf_Array m_leaves;
+    QHash<QPair<QString, git_oid>, int> m_leafIndex;
+};
+
+/**
+ * @brief The GBL_ScanRepoTask class
+ * opens a repository, lists its blobs or commits and handles the first chunk
+ */
+class GBL_ScanRepoTask : public QRunnable
+{
+public:
+    GBL_ScanRepoTask(GBL_ScanJob *pJob, int nRepo);
+
+    void run() override;
+
+private:
+    GBL_ScanJob *m_pJob;
+    int m_nRepo;
+};
+
+/**
+ * @brief The GBL_ScanHistoryTask class
+ * lists the blobs of one further chunk of a repository's commits
+ */
+class GBL_ScanHistoryTask : public QRunnable
+{
+public:
+    GBL_ScanHistoryTask(GBL_ScanJob *pJob, int nRepo, int nChunk);
+
+    void run() override;
+
+private:
+    GBL_ScanJob *m_pJob;
+    int m_nRepo;
+    int m_nChunk;
+};
+
+/**
+ * @brief The GBL_ScanChunkTask class
+ * searches one further chunk of a repository's blobs with its own handle on
+ * the repository, libgit2 repositories aren't shared between threads
+ */
+class GBL_ScanChunkTask : public QRunnable
+{
+public:
+    GBL_ScanChunkTask(GBL_ScanJob *pJob, int nRepo, int nChunk);
+
+    void run() override;
+
+private:
+    GBL_ScanJob *m_pJob;
+    int m_nRepo;
+    int m_nChunk;
+};
+
+#endif // GBL_SCAN_H
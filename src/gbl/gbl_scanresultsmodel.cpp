@@ -0,0 +1,111 @@
+#include "gbl_scanresultsmodel.h"
+
+GBL_ScanResultsModel::GBL_ScanResultsModel(QObject *parent) : QAbstractTableModel(parent)
+{
+    m_headings.append(tr("Repository"));
+    m_headings.append(tr("File"));
+    m_headings.append(tr("Line"));
+    m_headings.append(tr("Text"));
+    m_headings.append(tr("First Commit"));
+    m_headings.append(tr("Last Commit"));
+}
+
+GBL_ScanResultsModel::~GBL_ScanResultsModel()
+{
+
+}
+
+void GBL_ScanResultsModel::reset()
+{
+    beginResetModel();
+    m_matches.clear();
+    endResetModel();
+}
+
+/**
+ * @brief GBL_ScanResultsModel::addResults
+ * appends a batch of matches after the rows already shown
+ * @param batch
+ */
+void GBL_ScanResultsModel::addResults(const GBL_Scan_Match_Array &batch)
+{
+    if (batch.isEmpty()) return;
+
+    int nFirst = m_matches.size();
+    beginInsertRows(QModelIndex(), nFirst, nFirst + batch.size() - 1);
+    m_matches += batch;
+    endInsertRows();
+}
+
+const GBL_Scan_Match* GBL_ScanResultsModel::getMatchAt(int row) const
+{
+    if (row < 0 || row >= m_matches.size()) return Q_NULLPTR;
+
+    return &m_matches.at(row);
+}
+
+int GBL_ScanResultsModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+
+    return m_matches.size();
+}
+
+int GBL_ScanResultsModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+
+    return m_headings.size();
+}
+
+QVariant GBL_ScanResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_matches.size()) return QVariant();
+
+    const GBL_Scan_Match &match = m_matches.at(index.row());
+
+    if (role == Qt::DisplayRole)
+    {
+        switch (index.column())
+        {
+            case GBL_SCAN_RESULTS_COL_REPO:
+                return match.repo_name;
+            case GBL_SCAN_RESULTS_COL_FILE:
+                return match.file_path;
+            case GBL_SCAN_RESULTS_COL_LINE:
+                return match.line_no;
+            case GBL_SCAN_RESULTS_COL_TEXT:
+                return match.snippet;
+            case GBL_SCAN_RESULTS_COL_FIRST:
+                return match.first_oid.left(GBL_SCAN_RESULTS_SHORT_OID);
+            case GBL_SCAN_RESULTS_COL_LAST:
+                return match.last_oid.left(GBL_SCAN_RESULTS_SHORT_OID);
+        }
+    }
+    else if (role == Qt::ToolTipRole)
+    {
+        switch (index.column())
+        {
+            case GBL_SCAN_RESULTS_COL_TEXT:
+                return match.snippet;
+            case GBL_SCAN_RESULTS_COL_FIRST:
+                return match.first_oid;
+            case GBL_SCAN_RESULTS_COL_LAST:
+                return match.last_oid;
+        }
+    }
+    else if (role == Qt::TextAlignmentRole && index.column() == GBL_SCAN_RESULTS_COL_LINE)
+    {
+        return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    return QVariant();
+}
+
+QVariant GBL_ScanResultsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal)
+        return m_headings.at(section);
+
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
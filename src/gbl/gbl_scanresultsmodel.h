@@ -0,0 +1,44 @@
+#ifndef GBL_SCANRESULTSMODEL_H
+#define GBL_SCANRESULTSMODEL_H
+
+#include <QAbstractTableModel>
+#include "gbl_scan.h"
+
+#define GBL_SCAN_RESULTS_COL_REPO   0
+#define GBL_SCAN_RESULTS_COL_FILE   1
+#define GBL_SCAN_RESULTS_COL_LINE   2
+#define GBL_SCAN_RESULTS_COL_TEXT   3
+#define GBL_SCAN_RESULTS_COL_FIRST  4
+#define GBL_SCAN_RESULTS_COL_LAST   5
+
+// characters of a commit oid shown in the first and last columns
+#define GBL_SCAN_RESULTS_SHORT_OID  8
+
+/**
+ * @brief The GBL_ScanResultsModel class
+ * flat list of scan matches. Batches are appended as they arrive, so the
+ * cost of an update only depends on the size of the batch.
+ */
+class GBL_ScanResultsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    GBL_ScanResultsModel(QObject *parent = Q_NULLPTR);
+    ~GBL_ScanResultsModel();
+
+    Q_INVOKABLE virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    Q_INVOKABLE virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    Q_INVOKABLE virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    Q_INVOKABLE virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    void reset();
+    void addResults(const GBL_Scan_Match_Array &batch);
+    const GBL_Scan_Match* getMatchAt(int row) const;
+
+private:
+    GBL_Scan_Match_Array m_matches;
+    QVector<QString> m_headings;
+};
+
+#endif // GBL_SCANRESULTSMODEL_H
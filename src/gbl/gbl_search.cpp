@@ -0,0 +1,139 @@
+#include "gbl_search.h"
+
+#include <QtAlgorithms>
+
+#include <string.h>
+
+#ifdef GBL_SEARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+static inline char gbl_fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/**
+ * @brief GBL_SearchKernel::GBL_SearchKernel
+ */
+GBL_SearchKernel::GBL_SearchKernel()
+{
+    m_bCaseSensitive = true;
+    m_cFirstLower = 0;
+    m_cFirstUpper = 0;
+}
+
+/**
+ * @brief GBL_SearchKernel::setPattern
+ * @param pattern utf-8 bytes to look for
+ * @param bCaseSensitive
+ */
+void GBL_SearchKernel::setPattern(const QByteArray &pattern, bool bCaseSensitive)
+{
+    m_bCaseSensitive = bCaseSensitive;
+    m_pattern = pattern;
+
+    if (!m_bCaseSensitive)
+    {
+        for (int i = 0; i < m_pattern.size(); i++)
+        {
+            m_pattern[i] = gbl_fold(m_pattern.at(i));
+        }
+    }
+
+    m_cFirstLower = m_pattern.isEmpty() ? 0 : m_pattern.at(0);
+    m_cFirstUpper = m_cFirstLower;
+    if (!m_bCaseSensitive && m_cFirstLower >= 'a' && m_cFirstLower <= 'z')
+    {
+        m_cFirstUpper = m_cFirstLower - ('a' - 'A');
+    }
+}
+
+/**
+ * @brief GBL_SearchKernel::find
+ * @param pData
+ * @param pEnd
+ * @return the first match in [pData, pEnd) or Q_NULLPTR
+ */
+const char* GBL_SearchKernel::find(const char *pData, const char *pEnd) const
+{
+    int nLen = m_pattern.size();
+    if (nLen == 0 || pEnd - pData < nLen) return Q_NULLPTR;
+
+    // last position a match can start at
+    const char *pLast = pEnd - nLen;
+    const char *p = pData;
+
+    if (m_cFirstLower == m_cFirstUpper)
+    {
+        while (p <= pLast)
+        {
+            p = (const char*)memchr(p, m_cFirstLower, pLast - p + 1);
+            if (!p) return Q_NULLPTR;
+            if (matchesAt(p)) return p;
+            p++;
+        }
+
+        return Q_NULLPTR;
+    }
+
+#ifdef GBL_SEARCH_SSE2
+    const __m128i vLower = _mm_set1_epi8(m_cFirstLower);
+    const __m128i vUpper = _mm_set1_epi8(m_cFirstUpper);
+    while (pLast - p >= 15)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint mask = (uint)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, vLower), _mm_cmpeq_epi8(v, vUpper)));
+        while (mask)
+        {
+            const char *pCandidate = p + qCountTrailingZeroBits(mask);
+            if (matchesAt(pCandidate)) return pCandidate;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+#endif
+
+    for (; p <= pLast; p++)
+    {
+        if ((*p == m_cFirstLower || *p == m_cFirstUpper) && matchesAt(p)) return p;
+    }
+
+    return Q_NULLPTR;
+}
+
+/**
+ * @brief GBL_SearchKernel::isAscii
+ * @param pattern
+ * @return true if folding ASCII letters is all a case insensitive search of
+ * pattern needs, otherwise the text has to be decoded and compared as unicode
+ */
+bool GBL_SearchKernel::isAscii(const QByteArray &pattern)
+{
+    for (int i = 0; i < pattern.size(); i++)
+    {
+        if ((uchar)pattern.at(i) >= 0x80) return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief GBL_SearchKernel::matchesAt
+ * @param p a position whose first byte already matched
+ * @return true if the rest of the pattern follows
+ */
+bool GBL_SearchKernel::matchesAt(const char *p) const
+{
+    const char *pPattern = m_pattern.constData();
+    int nLen = m_pattern.size();
+
+    if (m_bCaseSensitive) return memcmp(p + 1, pPattern + 1, nLen - 1) == 0;
+
+    for (int i = 1; i < nLen; i++)
+    {
+        if (gbl_fold(p[i]) != pPattern[i]) return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef GBL_SEARCH_H
+#define GBL_SEARCH_H
+
+#include <QByteArray>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GBL_SEARCH_SSE2
+#endif
+
+/**
+ * @brief The GBL_SearchKernel class
+ * finds a literal in raw bytes without decoding them. Case insensitive
+ * search folds ASCII letters only, see isAscii(). Candidates for the first byte are found
+ * with memchr, or 16 bytes at a time with SSE2 when both cases of the first
+ * byte have to be looked for, and the rest of the pattern is compared in place.
+ * find() doesn't change the kernel, so one kernel can be used from many threads.
+ */
+class GBL_SearchKernel
+{
+public:
+    GBL_SearchKernel();
+
+    void setPattern(const QByteArray &pattern, bool bCaseSensitive);
+    int size() const { return m_pattern.size(); }
+    const char* find(const char *pData, const char *pEnd) const;
+
+    static bool isAscii(const QByteArray &pattern);
+
+private:
+    bool matchesAt(const char *p) const;
+
+    QByteArray m_pattern;
+    bool m_bCaseSensitive;
+    char m_cFirstLower;
+    char m_cFirstUpper;
+};
+
+#endif // GBL_SEARCH_H
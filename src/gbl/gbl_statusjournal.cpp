@@ -0,0 +1,180 @@
+#include "gbl_statusjournal.h"
+
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QGuiApplication>
+#include <QDir>
+
+/**
+ * @brief GBL_StatusJournal::GBL_StatusJournal
+ * @param sWorkDir root of the working tree
+ * @param sGitDir the repository's .git directory
+ * @param parent
+ */
+GBL_StatusJournal::GBL_StatusJournal(const QString &sWorkDir, const QString &sGitDir, QObject *parent) : QObject(parent)
+{
+    m_sWorkDir = QDir::cleanPath(sWorkDir);
+    m_sGitDir = QDir::cleanPath(sGitDir);
+    m_bFull = true;
+    m_bIndex = false;
+    m_bOverflow = false;
+
+    m_pWatcher = new QFileSystemWatcher(this);
+    m_pTimer = new QTimer(this);
+    m_pTimer->setSingleShot(true);
+    m_pTimer->setInterval(GBL_STATUS_JOURNAL_DELAY);
+
+    m_pTrackedTimer = new QTimer(this);
+    m_pTrackedTimer->setInterval(GBL_STATUS_JOURNAL_TRACKED_INTERVAL);
+    if (QGuiApplication::applicationState() == Qt::ApplicationActive) m_pTrackedTimer->start();
+
+    connect(m_pWatcher, SIGNAL(directoryChanged(QString)), this, SLOT(directoryChanged(QString)));
+    connect(m_pTimer, SIGNAL(timeout()), this, SIGNAL(changed()));
+    connect(m_pTrackedTimer, SIGNAL(timeout()), this, SLOT(checkTracked()));
+    connect(qApp, SIGNAL(applicationStateChanged(Qt::ApplicationState)), this, SLOT(applicationStateChanged(Qt::ApplicationState)));
+}
+
+/**
+ * @brief GBL_StatusJournal::watch
+ * @param dirs directories relative to the working tree, empty for its root
+ * @param bReplace drop the directories watched so far
+ */
+void GBL_StatusJournal::watch(const QStringList &dirs, bool bReplace)
+{
+    if (bReplace)
+    {
+        QStringList watched = m_pWatcher->directories();
+        if (!watched.isEmpty()) m_pWatcher->removePaths(watched);
+        m_bOverflow = false;
+    }
+
+    if (m_bOverflow) return;
+
+    QStringList paths;
+    if (bReplace)
+    {
+        // a commit only moves the branch HEAD points at
+        paths.append(m_sGitDir);
+        paths.append(m_sGitDir + "/refs/heads");
+    }
+    for (int i = 0; i < dirs.size(); i++)
+    {
+        paths.append(dirs.at(i).isEmpty() ? m_sWorkDir : m_sWorkDir + "/" + dirs.at(i));
+    }
+
+    if (m_pWatcher->directories().size() + paths.size() > GBL_STATUS_JOURNAL_MAX_WATCHES)
+    {
+        overflow();
+        return;
+    }
+
+    QStringList failed = paths.isEmpty() ? QStringList() : m_pWatcher->addPaths(paths);
+    if (!failed.isEmpty())
+    {
+        // most likely out of inotify watches, a partial journal would miss changes
+        overflow();
+    }
+}
+
+/**
+ * @brief GBL_StatusJournal::takeChanges
+ * @param dirs gets the changed directories relative to the working tree
+ * @param bIndex set if the index or HEAD moved
+ * @return true if a full status is needed, dirs is then empty
+ */
+bool GBL_StatusJournal::takeChanges(QStringList &dirs, bool &bIndex)
+{
+    bool bFull = m_bFull || m_bOverflow;
+
+    dirs.clear();
+    if (!bFull) dirs = m_dirs.toList();
+    bIndex = m_bIndex;
+
+    m_dirs.clear();
+    m_bFull = false;
+    m_bIndex = false;
+    m_pTimer->stop();
+
+    return bFull;
+}
+
+/**
+ * @brief GBL_StatusJournal::directoryChanged
+ * @param sPath
+ */
+void GBL_StatusJournal::directoryChanged(const QString &sPath)
+{
+    QString sDir = QDir::cleanPath(sPath);
+
+    if (sDir == m_sGitDir || sDir.startsWith(m_sGitDir + "/"))
+    {
+        // index, HEAD or refs moved
+        m_bIndex = true;
+    }
+    else if (!m_bFull)
+    {
+        if (sDir == m_sWorkDir)
+        {
+            m_dirs.insert(QString());
+        }
+        else if (sDir.startsWith(m_sWorkDir + "/"))
+        {
+            m_dirs.insert(sDir.mid(m_sWorkDir.size() + 1));
+        }
+
+        if (m_dirs.size() > GBL_STATUS_JOURNAL_MAX_DIRS)
+        {
+            m_dirs.clear();
+            m_bFull = true;
+        }
+    }
+
+    m_pTimer->start();
+}
+
+/**
+ * @brief GBL_StatusJournal::applicationStateChanged
+ * files may have been written in place while the application was in the
+ * background, nothing is checked while it stays there
+ * @param state
+ */
+void GBL_StatusJournal::applicationStateChanged(Qt::ApplicationState state)
+{
+    if (state == Qt::ApplicationActive)
+    {
+        m_pTrackedTimer->start();
+        checkTracked();
+    }
+    else
+    {
+        m_pTrackedTimer->stop();
+    }
+}
+
+/**
+ * @brief GBL_StatusJournal::checkTracked
+ * makes the next status a full one, which takes the status of every tracked
+ * file while untracked files still come from the untracked cache
+ */
+void GBL_StatusJournal::checkTracked()
+{
+    m_dirs.clear();
+    m_bFull = true;
+    m_pTimer->start();
+}
+
+/**
+ * @brief GBL_StatusJournal::overflow
+ * stops watching the working tree, every change is a full status from now on
+ */
+void GBL_StatusJournal::overflow()
+{
+    QStringList watched = m_pWatcher->directories();
+    watched.removeAll(m_sGitDir);
+    watched.removeAll(m_sGitDir + "/refs/heads");
+    if (!watched.isEmpty()) m_pWatcher->removePaths(watched);
+
+    m_bOverflow = true;
+    m_dirs.clear();
+    m_bFull = true;
+}
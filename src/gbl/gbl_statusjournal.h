@@ -0,0 +1,72 @@
+#ifndef GBL_STATUSJOURNAL_H
+#define GBL_STATUSJOURNAL_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QFileSystemWatcher;
+class QTimer;
+QT_END_NAMESPACE
+
+// msecs of quiet after a change before the journal reports it
+#define GBL_STATUS_JOURNAL_DELAY        250
+
+// changed directories kept before a full rescan is cheaper
+#define GBL_STATUS_JOURNAL_MAX_DIRS     1024
+
+// directories watched before giving up on watching and always rescanning
+#define GBL_STATUS_JOURNAL_MAX_WATCHES  8192
+
+// msecs between checks of the tracked files while the application is active
+#define GBL_STATUS_JOURNAL_TRACKED_INTERVAL 30000
+
+/**
+ * @brief The GBL_StatusJournal class
+ * watches the directories of a working tree and collects the ones that
+ * changed since the status was last taken, standing in for an fsmonitor
+ * daemon while the repository is open. A change under .git means the index
+ * or HEAD moved. Too many changed directories or a directory that can't be
+ * watched makes the next status a full one. Lives in the thread that owns the
+ * repository window.
+ * A directory watch only sees files created, deleted, renamed or changing
+ * attributes, not a file written in place. So the tracked files are checked
+ * with a full status when the application becomes active and every
+ * GBL_STATUS_JOURNAL_TRACKED_INTERVAL msecs while it is.
+ */
+class GBL_StatusJournal : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GBL_StatusJournal(const QString &sWorkDir, const QString &sGitDir, QObject *parent = Q_NULLPTR);
+
+    void watch(const QStringList &dirs, bool bReplace);
+    bool hasChanges() const { return m_bFull || m_bIndex || !m_dirs.isEmpty(); }
+    bool takeChanges(QStringList &dirs, bool &bIndex);
+    bool isOverflowed() const { return m_bOverflow; }
+
+signals:
+    void changed();
+
+private slots:
+    void directoryChanged(const QString &sPath);
+    void applicationStateChanged(Qt::ApplicationState state);
+    void checkTracked();
+
+private:
+    void overflow();
+
+    QFileSystemWatcher *m_pWatcher;
+    QTimer *m_pTimer;
+    QTimer *m_pTrackedTimer;
+    QString m_sWorkDir;
+    QString m_sGitDir;
+    QSet<QString> m_dirs;
+    bool m_bFull;
+    bool m_bIndex;
+    bool m_bOverflow;
+};
+
+#endif // GBL_STATUSJOURNAL_H
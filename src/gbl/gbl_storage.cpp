@@ -27,6 +27,110 @@ QString GBL_Storage::getCachePath()
     return sCachePath;
 }
 
+/**
+ * @brief GBL_Storage::getHistoryCacheFile
+ * one commit history cache file per repository and head reference
+ * @param sRepoPath
+ * @param sRefName
+ * @return
+ */
+QString GBL_Storage::getHistoryCacheFile(const QString &sRepoPath, const QString &sRefName)
+{
+    QString sHistPath;
+    QTextStream(&sHistPath) << getCachePath() << QDir::separator() << GBL_STORAGE_HISTORY_DIR;
+    QDir histDir(sHistPath);
+    if (!histDir.exists())
+    {
+        histDir.mkpath(sHistPath);
+    }
+
+    QByteArray baKey = sRepoPath.toUtf8();
+    baKey.append('\n');
+    baKey.append(sRefName.toUtf8());
+    QByteArray ba = QCryptographicHash::hash(baKey, QCryptographicHash::Md5);
+
+    QString sFile;
+    QTextStream(&sFile) << sHistPath << QDir::separator() << ba.toHex() << ".ghc";
+
+    return sFile;
+}
+
+/**
+ * @brief GBL_Storage::getScanCacheFile
+ * one file per search of the blobs already scanned for it
+ * @param sSearch
+ * @param nSearchType
+ * @return
+ */
+QString GBL_Storage::getScanCacheFile(const QString &sSearch, int nSearchType)
+{
+    QString sScanPath;
+    QTextStream(&sScanPath) << getCachePath() << QDir::separator() << GBL_STORAGE_SCAN_DIR;
+    QDir scanDir(sScanPath);
+    if (!scanDir.exists())
+    {
+        scanDir.mkpath(sScanPath);
+    }
+
+    QByteArray baKey = QByteArray::number(nSearchType);
+    baKey.append('\n');
+    baKey.append(sSearch.toUtf8());
+    QByteArray ba = QCryptographicHash::hash(baKey, QCryptographicHash::Md5);
+
+    QString sFile;
+    QTextStream(&sFile) << sScanPath << QDir::separator() << ba.toHex() << ".gsb";
+
+    return sFile;
+}
+
+/**
+ * @brief GBL_Storage::getTrigramIndexFile
+ * one trigram index file per repository
+ * @param sRepoPath
+ * @return
+ */
+QString GBL_Storage::getTrigramIndexFile(const QString &sRepoPath)
+{
+    QString sIndexPath;
+    QTextStream(&sIndexPath) << getCachePath() << QDir::separator() << GBL_STORAGE_TRIGRAM_DIR;
+    QDir indexDir(sIndexPath);
+    if (!indexDir.exists())
+    {
+        indexDir.mkpath(sIndexPath);
+    }
+
+    QByteArray ba = QCryptographicHash::hash(sRepoPath.toUtf8(), QCryptographicHash::Md5);
+
+    QString sFile;
+    QTextStream(&sFile) << sIndexPath << QDir::separator() << ba.toHex() << ".gti";
+
+    return sFile;
+}
+
+/**
+ * @brief GBL_Storage::getUntrackedCacheFile
+ * one untracked cache file per working tree
+ * @param sRepoPath
+ * @return
+ */
+QString GBL_Storage::getUntrackedCacheFile(const QString &sRepoPath)
+{
+    QString sCachePath;
+    QTextStream(&sCachePath) << getCachePath() << QDir::separator() << GBL_STORAGE_UNTRACKED_DIR;
+    QDir cacheDir(sCachePath);
+    if (!cacheDir.exists())
+    {
+        cacheDir.mkpath(sCachePath);
+    }
+
+    QByteArray ba = QCryptographicHash::hash(sRepoPath.toUtf8(), QCryptographicHash::Md5);
+
+    QString sFile;
+    QTextStream(&sFile) << sCachePath << QDir::separator() << ba.toHex() << ".guc";
+
+    return sFile;
+}
+
 QString GBL_Storage::getThemesPath()
 {
     QString sThemesPath;
@@ -3,6 +3,10 @@
 
 #define GBL_STORAGE_DIR ".gitbusylivin"
 #define GBL_STORAGE_CACHE_DIR "cache"
+#define GBL_STORAGE_HISTORY_DIR "history"
+#define GBL_STORAGE_SCAN_DIR "scan"
+#define GBL_STORAGE_TRIGRAM_DIR "trigram"
+#define GBL_STORAGE_UNTRACKED_DIR "untracked"
 #define GBL_STORAGE_THEMES_DIR "themes"
 #define GBL_STORAGE_BOOKMARKS_FILE "bookmarks.json"
 
@@ -16,6 +20,10 @@ public:
 
     static QString getStoragePath();
     static QString getCachePath();
+    static QString getHistoryCacheFile(const QString &sRepoPath, const QString &sRefName);
+    static QString getScanCacheFile(const QString &sSearch, int nSearchType);
+    static QString getTrigramIndexFile(const QString &sRepoPath);
+    static QString getUntrackedCacheFile(const QString &sRepoPath);
     static QString getGravatarUrl(QString sEmail);
     static QString getThemesPath();
     QStringList getThemes();
@@ -1,12 +1,19 @@
 #include "gbl_threads.h"
 
 #include "gbl_string.h"
+#include "gbl_storage.h"
+#include "gbl_diffcache.h"
 
 #include <QVector>
 #include <QDir>
+#include <QFileInfo>
 #include <QStringList>
 #include <QDebug>
 #include <QTextDocument>
+#include <QElapsedTimer>
+#include <QDateTime>
+
+#include <limits.h>
 
 /**
  * @brief GBL_Thread::GBL_Thread
@@ -257,43 +264,282 @@ void GBL_CheckoutThread::run()
  */
 GBL_HistoryThread::GBL_HistoryThread(GBL_String sRepoPath, QObject *parent) : GBL_Thread(sRepoPath, parent)
 {
-    m_pHistArr = new GBL_History_Array;
+    m_pPage = new GBL_CommitStore;
+    m_pWalker = Q_NULLPTR;
+    m_bFetchMore = false;
+    m_bRefresh = false;
+    m_bSaveCache = false;
+    m_nCachedRows = 0;
 }
 
 GBL_HistoryThread::~GBL_HistoryThread()
 {
+    wait();
+
     cleanup();
+    cleanup_walker();
+    delete m_pPage;
 }
 
 void GBL_HistoryThread::cleanup()
 {
-    if (m_pHistArr)
+    if (m_pPage)
     {
-        for (int i = 0; i < m_pHistArr->size(); i++)
-        {
-            GBL_History_Item *pHI = m_pHistArr->at(i);
-            delete pHI;
-        }
+        m_pPage->clear();
+    }
+}
 
-        m_pHistArr->clear();
+void GBL_HistoryThread::cleanup_walker()
+{
+    if (m_pWalker)
+    {
+        git_revwalk_free(m_pWalker);
+        m_pWalker = Q_NULLPTR;
     }
 }
 
+/**
+ * @brief GBL_HistoryThread::get_history
+ * starts a new walk from HEAD and reads the first page
+ */
 void GBL_HistoryThread::get_history()
 {
     stop_thread();
+    m_mutex.lock();
+    m_bFetchMore = false;
+    m_mutex.unlock();
+    start_thread();
+}
+
+/**
+ * @brief GBL_HistoryThread::fetch_more
+ * reads the next page from the walk left open by the previous run
+ */
+void GBL_HistoryThread::fetch_more()
+{
+    stop_thread();
+    m_mutex.lock();
+    m_bFetchMore = true;
+    m_mutex.unlock();
     start_thread();
 }
 
+/**
+ * @brief GBL_HistoryThread::save_cache
+ * writes the history loaded so far to the on-disk cache, if it grew
+ * @param store
+ */
+void GBL_HistoryThread::save_cache(const GBL_CommitStore &store)
+{
+    stop_thread();
+    m_mutex.lock();
+    bool bSave = !m_sCacheFile.isEmpty() && store.size() > m_nCachedRows;
+    if (bSave)
+    {
+        m_saveStore = store;
+        m_bSaveCache = true;
+    }
+    m_mutex.unlock();
+    if (bSave) start_thread();
+}
+
+/**
+ * @brief GBL_HistoryThread::refresh_history
+ * reads only the commits HEAD gained on top of the loaded history, falling
+ * back to a full reload when HEAD no longer contains its tip
+ * @param loaded the history the view shows now
+ */
+void GBL_HistoryThread::refresh_history(const GBL_CommitStore &loaded)
+{
+    stop_thread();
+    m_mutex.lock();
+    m_bRefresh = true;
+    m_loadedStore = loaded;
+    m_mutex.unlock();
+    start_thread();
+}
+
+/**
+ * @brief GBL_HistoryThread::walk_new_commits
+ * reads every commit reachable from HEAD but not from tipOid into the page
+ * @param tipOid
+ * @return
+ */
+bool GBL_HistoryThread::walk_new_commits(const git_oid &tipOid)
+{
+    git_revwalk *pWalker = Q_NULLPTR;
+    bool bWalkMore = false;
+    QVector<git_oid> hideOids;
+    hideOids.append(tipOid);
+
+    bool bRet = m_pRepo->history_walk_begin(&pWalker, hideOids);
+    if (bRet) bRet = m_pRepo->get_history(pWalker, m_pPage, INT_MAX, bWalkMore);
+    if (pWalker) git_revwalk_free(pWalker);
+
+    if (!bRet) m_pPage->clear();
+
+    return bRet;
+}
+
+/**
+ * @brief GBL_HistoryThread::load_new_commits
+ * @param tipOid
+ * @return false if HEAD does not contain tipOid any more
+ */
+bool GBL_HistoryThread::load_new_commits(const git_oid &tipOid)
+{
+    git_oid headOid;
+    QString sRefName;
+
+    if (!m_pRepo->get_head_oid(headOid, sRefName)) return false;
+    if (!(headOid == tipOid) && !m_pRepo->is_descendant_of(headOid, tipOid)) return false;
+
+    // a new branch made at the same commit keeps the history but gets its own cache
+    QString sCacheFile = GBL_Storage::getHistoryCacheFile(m_sRepoPath, sRefName);
+    if (sCacheFile != m_sCacheFile)
+    {
+        m_sCacheFile = sCacheFile;
+        m_nCachedRows = 0;
+    }
+
+    if (headOid == tipOid) return true;
+
+    return walk_new_commits(tipOid);
+}
+
+/**
+ * @brief GBL_HistoryThread::load_cache
+ * reads the cached history for HEAD's reference and, if HEAD still contains
+ * the cached tip, puts only the commits made since in front of it. The walk
+ * is then left to carry on below the cached commits.
+ * @param bMore
+ * @return false if there is no usable cache
+ */
+bool GBL_HistoryThread::load_cache(bool &bMore)
+{
+    git_oid headOid;
+    QString sRefName;
+
+    m_sCacheFile.clear();
+    m_nCachedRows = 0;
+
+    if (!m_pRepo->get_head_oid(headOid, sRefName)) return false;
+
+    m_sCacheFile = GBL_Storage::getHistoryCacheFile(m_sRepoPath, sRefName);
+
+    GBL_CommitStore cached;
+    if (!cached.loadCache(m_sCacheFile) || cached.isEmpty()) return false;
+
+    // cached row 0 is the HEAD the cache was written from
+    git_oid tipOid = *cached.oid(0);
+    bool bNewCommits = !(tipOid == headOid);
+    if (bNewCommits && !m_pRepo->is_descendant_of(headOid, tipOid)) return false;
+
+    if (bNewCommits && !walk_new_commits(tipOid)) return false;
+
+    int nNewRows = cached.prepend(*m_pPage);
+    m_nCachedRows = cached.size() - nNewRows;
+    *m_pPage = cached;
+
+    m_graph.reset();
+    m_graph.layout(m_pPage);
+
+    QVector<git_oid> frontier = m_pPage->frontier();
+    bMore = !frontier.isEmpty() && m_pRepo->history_walk_from(&m_pWalker, frontier);
+
+    if (bNewCommits && m_pPage->saveCache(m_sCacheFile))
+    {
+        m_nCachedRows = m_pPage->size();
+    }
+
+    return true;
+}
+
 void GBL_HistoryThread::run()
 {
     m_mutex.lock();
     cleanup();
+    bool bFetchMore = m_bFetchMore;
+    bool bRefresh = m_bRefresh;
+    GBL_CommitStore loadedStore = m_loadedStore;
+    bool bSaveCache = m_bSaveCache;
+    GBL_CommitStore saveStore = m_saveStore;
+    m_bRefresh = false;
+    m_loadedStore.clear();
+    m_bSaveCache = false;
+    m_saveStore.clear();
     m_mutex.unlock();
 
-    bool bRet = m_pRepo->get_history(m_pHistArr);
+    if (bSaveCache)
+    {
+        if (saveStore.saveCache(m_sCacheFile))
+        {
+            m_nCachedRows = saveStore.size();
+        }
+
+        quit();
+        return;
+    }
+
+    if (bRefresh && !loadedStore.isEmpty())
+    {
+        git_oid tipOid = *loadedStore.oid(0);
+        if (load_new_commits(tipOid))
+        {
+            m_sError = "";
+
+            GBL_GraphLayout newGraph;
+            newGraph.layout(m_pPage);
+            if (m_pPage->isEmpty() || newGraph.isSettledOn(tipOid))
+            {
+                emit historyUpdated(&m_sError, m_pPage, GBL_HISTORY_UPDATE_PREPEND, m_pWalker != Q_NULLPTR);
+            }
+            else
+            {
+                // the new commits branch into the loaded history, lay the whole graph out again
+                loadedStore.prepend(*m_pPage);
+                *m_pPage = loadedStore;
+                m_pPage->clearGraph();
+                m_graph.reset();
+                m_graph.layout(m_pPage);
+                emit historyUpdated(&m_sError, m_pPage, GBL_HISTORY_UPDATE_RESET, m_pWalker != Q_NULLPTR);
+            }
+
+            quit();
+            return;
+        }
+
+        // HEAD moved off the loaded history, start over
+        bFetchMore = false;
+    }
+
+    bool bRet = true;
+    bool bMore = false;
+    bool bCached = false;
+    if (!bFetchMore || !m_pWalker)
+    {
+        bFetchMore = false;
+        cleanup_walker();
+        bCached = load_cache(bMore);
+        if (!bCached)
+        {
+            m_graph.reset();
+            bRet = m_pRepo->history_walk_begin(&m_pWalker);
+        }
+    }
+
+    if (bRet && !bCached)
+    {
+        bRet = m_pRepo->get_history(m_pWalker, m_pPage, GBL_HISTORY_PAGE_SIZE, bMore);
+        m_graph.layout(m_pPage);
+    }
+
+    // nothing left to read, release the walk
+    if (!bMore) cleanup_walker();
+
     m_sError = !bRet ? m_pRepo->get_error_msg() : "";
-    emit historyUpdated(&m_sError, m_pHistArr);
+    int nUpdate = bFetchMore ? GBL_HISTORY_UPDATE_APPEND : GBL_HISTORY_UPDATE_RESET;
+    emit historyUpdated(&m_sError, m_pPage, nUpdate, bMore);
 
     quit();
 }
@@ -355,8 +601,10 @@ void GBL_ReferencesThread::run()
  */
 GBL_StatusThread::GBL_StatusThread(QObject *parent) : GBL_Thread(GBL_String(""),parent)
 {
-    m_pStagedArr = new GBL_File_Array();
-    m_pUnstagedArr = new GBL_File_Array();
+    m_nMode = GBL_STATUS_FULL;
+    m_bQuiet = false;
+    m_pStagedArr = new GBL_FileList();
+    m_pUnstagedArr = new GBL_FileList();
 }
 
 /**
@@ -372,65 +620,434 @@ GBL_StatusThread::~GBL_StatusThread()
  */
 void GBL_StatusThread::cleanup()
 {
-    GBL_File_Item *pFI;
-    if (m_pStagedArr)
+    if (m_pStagedArr) m_pStagedArr->clear();
+    if (m_pUnstagedArr) m_pUnstagedArr->clear();
+}
+
+/**
+ * @brief GBL_StatusThread::status
+ * @param sRepoPath
+ */
+void GBL_StatusThread::status(GBL_String sRepoPath)
+{
+    status(sRepoPath, GBL_STATUS_FULL, QStringList(), false);
+}
+
+/**
+ * @brief GBL_StatusThread::status
+ * @param sRepoPath
+ * @param nMode GBL_STATUS_FULL, GBL_STATUS_INDEX after the index or HEAD
+ * moved, or GBL_STATUS_DIRS to only look at dirs
+ * @param dirs changed directories relative to the working tree
+ * @param bQuiet only report the status if it changed
+ */
+void GBL_StatusThread::status(GBL_String sRepoPath, int nMode, const QStringList &dirs, bool bQuiet)
+{
+    stop_thread();
+
+    m_mutex.lock();
+    if (!sRepoPath.isEmpty() && sRepoPath != m_sRepoPath)
     {
-        for (int i = 0; i < m_pStagedArr->size(); i++)
+        if (!m_pRepo->open_repo(sRepoPath))
         {
-            pFI = m_pStagedArr->at(i);
-            delete pFI;
+            m_mutex.unlock();
+            return;
         }
 
-        m_pStagedArr->clear();
+        m_sRepoPath = sRepoPath;
+        m_entries.clear();
+        m_knownDirs.clear();
+        m_untrackedCache = GBL_UntrackedCache();
+    }
+
+    // there is nothing to update until the first full status
+    m_nMode = m_knownDirs.isEmpty() ? GBL_STATUS_FULL : nMode;
+    m_dirs = dirs;
+    m_bQuiet = bQuiet;
+    m_mutex.unlock();
+
+    start_thread();
+}
+
+/**
+ * @brief GBL_StatusThread::run
+ */
+void GBL_StatusThread::run()
+{
+    m_mutex.lock();
+    int nMode = m_nMode;
+    QStringList dirs = m_dirs;
+    bool bQuiet = m_bQuiet;
+    m_mutex.unlock();
+
+    GBL_Status_Map entries = m_entries;
+    bool bRet;
+    switch (nMode)
+    {
+        case GBL_STATUS_DIRS:
+            bRet = runDirs(dirs);
+            break;
+        case GBL_STATUS_INDEX:
+            bRet = runIndex(dirs);
+            break;
+        default:
+            bRet = runFull();
+            break;
+    }
+    m_sError = !bRet ? m_pRepo->get_error_msg() : "";
+
+    bool bChanged = entries.size() != m_entries.size();
+    GBL_Status_Map::const_iterator it = entries.constBegin(), it2 = m_entries.constBegin();
+    for (; !bChanged && it != entries.constEnd(); ++it, ++it2)
+    {
+        bChanged = it.key() != it2.key() || it.value().staged != it2.value().staged || it.value().unstaged != it2.value().unstaged;
+    }
+
+    if (!bQuiet || bChanged || !bRet)
+    {
+        m_mutex.lock();
+        cleanup();
+        buildArrays();
+        m_mutex.unlock();
+
+        emit statusUpdated(&m_sError, m_pStagedArr, m_pUnstagedArr);
+    }
+
+    quit();
+}
+
+/**
+ * @brief GBL_StatusThread::runFull
+ * takes the status of the tracked files of the whole working tree. Untracked
+ * files come from the untracked cache, only the directories that changed
+ * since they were last listed are read again.
+ * @return
+ */
+bool GBL_StatusThread::runFull()
+{
+    GBL_Status_Map entries;
+    if (!m_pRepo->get_status_entries(entries, GIT_STATUS_SHOW_INDEX_AND_WORKDIR, Q_NULLPTR, false, false)) return false;
+
+    QFileInfo fiExclude(m_pRepo->get_git_dir() + "/info/exclude");
+    qint64 nExcludeMtime = fiExclude.exists() ? fiExclude.lastModified().toMSecsSinceEpoch() : 0;
+    if (m_untrackedCache.isEmpty())
+    {
+        m_sCacheFile = GBL_Storage::getUntrackedCacheFile(m_sRepoPath);
+        m_untrackedCache.load(m_sCacheFile, nExcludeMtime);
+    }
+    m_untrackedCache.setExcludeMtime(nExcludeMtime);
+
+    QStringList dirs;
+    qint64 nScanTime = QDateTime::currentMSecsSinceEpoch();
+    if (!walkUntracked(QString(), false, nScanTime, entries, dirs)) return false;
+
+    m_entries.swap(entries);
+
+    bool bReplace = m_knownDirs.isEmpty();
+    QStringList newDirs;
+    QSet<QString> knownDirs;
+    for (int i = 0; i < dirs.size(); i++)
+    {
+        knownDirs.insert(dirs.at(i));
+        if (bReplace || !m_knownDirs.contains(dirs.at(i))) newDirs.append(dirs.at(i));
     }
+    m_knownDirs.swap(knownDirs);
 
-    if (m_pUnstagedArr)
+    m_untrackedCache.prune(m_knownDirs);
+    // a cache that fails to save only costs a full walk the next time the repository opens
+    if (m_untrackedCache.isModified()) m_untrackedCache.save(m_sCacheFile);
+
+    if (bReplace || !newDirs.isEmpty()) emit statusWatch(newDirs, bReplace);
+
+    return true;
+}
+
+/**
+ * @brief GBL_StatusThread::walkUntracked
+ * adds the untracked files of a directory and the directories under it. A
+ * directory is only listed if it, its .gitignore or its index entries changed
+ * since the cached listing, or a .gitignore above it changed.
+ * @param sDir relative to the working tree, empty for its root
+ * @param bIgnoreChanged a .gitignore above sDir changed
+ * @param nScanTime
+ * @param entries gets the untracked files
+ * @param dirs gets sDir and the directories walked under it
+ * @return
+ */
+bool GBL_StatusThread::walkUntracked(const QString &sDir, bool bIgnoreChanged, qint64 nScanTime, GBL_Status_Map &entries, QStringList &dirs)
+{
+    dirs.append(sDir);
+
+    QString sPrefix = sDir.isEmpty() ? QString() : sDir + "/";
+    QDir dir(sDir.isEmpty() ? m_sRepoPath : m_sRepoPath + "/" + sDir);
+    QFileInfo fiDir(dir.path());
+    QFileInfo fiIgnore(dir.filePath(".gitignore"));
+    qint64 nMtime = fiDir.lastModified().toMSecsSinceEpoch();
+    qint64 nIgnoreMtime = fiIgnore.exists() ? fiIgnore.lastModified().toMSecsSinceEpoch() : 0;
+
+    QStringList indexFiles, indexDirs;
+    if (!m_pRepo->get_index_dir_entries(sDir, indexFiles, indexDirs)) return false;
+    uint nIndexHash = qHash(indexFiles);
+
+    const GBL_Untracked_Dir *pCached = m_untrackedCache.find(sDir);
+    GBL_Untracked_Dir listing;
+    if (pCached && !bIgnoreChanged && pCached->mtime == nMtime && pCached->ignore_mtime == nIgnoreMtime && pCached->index_hash == nIndexHash)
     {
-        for (int i = 0; i < m_pUnstagedArr->size(); i++)
+        listing = *pCached;
+    }
+    else
+    {
+        // the rules below a new or changed .gitignore may have changed too
+        bIgnoreChanged = bIgnoreChanged || !pCached || pCached->ignore_mtime != nIgnoreMtime;
+
+        listing.mtime = nMtime >= nScanTime - GBL_UNTRACKED_CACHE_RACY_MSECS ? -1 : nMtime;
+        listing.ignore_mtime = nIgnoreMtime;
+        listing.index_hash = nIndexHash;
+
+        QSet<QString> tracked = indexFiles.toSet();
+        QStringList files = dir.entryList(QDir::Files | QDir::Hidden | QDir::System);
+        for (int i = 0; i < files.size(); i++)
+        {
+            QString sPath = sPrefix + files.at(i);
+            if (!tracked.contains(sPath) && !m_pRepo->is_path_ignored(sPath)) listing.untracked.append(files.at(i));
+        }
+
+        QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks);
+        for (int i = 0; i < subdirs.size(); i++)
         {
-            pFI = m_pUnstagedArr->at(i);
-            delete pFI;
+            QString sSub = sPrefix + subdirs.at(i);
+            if (subdirs.at(i) == ".git" || m_pRepo->is_path_ignored(sSub + "/")) continue;
+
+            if (QFileInfo(dir.filePath(subdirs.at(i) + "/.git")).exists())
+            {
+                // a nested repository shows as one untracked directory, a submodule is tracked
+                if (!tracked.contains(sSub)) listing.untracked.append(subdirs.at(i) + "/");
+                continue;
+            }
+
+            listing.subdirs.append(subdirs.at(i));
         }
 
-        m_pUnstagedArr->clear();
+        m_untrackedCache.insert(sDir, listing);
+    }
+
+    for (int i = 0; i < listing.untracked.size(); i++)
+    {
+        entries[sPrefix + listing.untracked.at(i)].unstaged = GBL_Repository::workdir_status(GIT_STATUS_WT_NEW);
+    }
+
+    for (int i = 0; i < listing.subdirs.size(); i++)
+    {
+        if (!walkUntracked(sPrefix + listing.subdirs.at(i), bIgnoreChanged, nScanTime, entries, dirs)) return false;
     }
 
+    return true;
 }
 
 /**
- * @brief GBL_StatusThread::status
- * @param sRepoPath
+ * @brief GBL_StatusThread::runIndex
+ * the index or HEAD moved. Takes the status of the index again, which doesn't
+ * touch the working tree, and the full status only of the paths whose staged
+ * status changed, the paths with unstaged changes and the changed
+ * directories.
+ * @param dirs
+ * @return
  */
-void GBL_StatusThread::status(GBL_String sRepoPath)
+bool GBL_StatusThread::runIndex(const QStringList &dirs)
 {
-    stop_thread();
-    if (!sRepoPath.isEmpty())
+    GBL_Status_Map staged;
+    if (!m_pRepo->get_status_entries(staged, GIT_STATUS_SHOW_INDEX_ONLY, Q_NULLPTR, false, false)) return false;
+
+    QSet<QString> paths;
+    if (!collectDirPaths(dirs, paths)) return false;
+
+    GBL_Status_Map::const_iterator it = m_entries.constBegin();
+    for (; it != m_entries.constEnd(); ++it)
     {
-        if (m_pRepo->open_repo(sRepoPath))
+        GBL_Status_Map::const_iterator itStaged = staged.constFind(it.key());
+        char cStaged = itStaged == staged.constEnd() ? 0 : itStaged.value().staged;
+        if (it.value().unstaged || cStaged != it.value().staged) paths.insert(it.key());
+    }
+
+    for (it = staged.constBegin(); it != staged.constEnd(); ++it)
+    {
+        if (!m_entries.contains(it.key())) paths.insert(it.key());
+    }
+
+    return updatePaths(paths);
+}
+
+/**
+ * @brief GBL_StatusThread::runDirs
+ * @param dirs
+ * @return
+ */
+bool GBL_StatusThread::runDirs(const QStringList &dirs)
+{
+    QSet<QString> paths;
+    if (!collectDirPaths(dirs, paths)) return false;
+
+    return updatePaths(paths);
+}
+
+/**
+ * @brief GBL_StatusThread::collectDirPaths
+ * lists the paths the changed directories hold now or held before: the files
+ * on disk, the files in the index and the changed files known so far. New and
+ * removed subdirectories are listed as a whole.
+ * @param dirs
+ * @param paths
+ * @return
+ */
+bool GBL_StatusThread::collectDirPaths(const QStringList &dirs, QSet<QString> &paths)
+{
+    QString sWorkDir = m_sRepoPath;
+    QStringList newDirs;
+
+    for (int i = 0; i < dirs.size(); i++)
+    {
+        QString sDir = dirs.at(i);
+        QString sPrefix = sDir.isEmpty() ? QString() : sDir + "/";
+        QDir dir(sDir.isEmpty() ? sWorkDir : sWorkDir + "/" + sDir);
+
+        if (!sDir.isEmpty() && !dir.exists())
         {
-            start_thread();
+            paths.insert(sDir);
+            QMutableSetIterator<QString> itDir(m_knownDirs);
+            while (itDir.hasNext())
+            {
+                const QString &sKnown = itDir.next();
+                if (sKnown == sDir || sKnown.startsWith(sPrefix)) itDir.remove();
+            }
+            continue;
+        }
+
+        QStringList files = dir.entryList(QDir::Files | QDir::Hidden | QDir::System);
+        for (int j = 0; j < files.size(); j++)
+        {
+            paths.insert(sPrefix + files.at(j));
+        }
+
+        QStringList indexFiles, indexDirs;
+        if (!m_pRepo->get_index_dir_entries(sDir, indexFiles, indexDirs)) return false;
+        for (int j = 0; j < indexFiles.size(); j++)
+        {
+            paths.insert(indexFiles.at(j));
+        }
+        for (int j = 0; j < indexDirs.size(); j++)
+        {
+            if (!QFileInfo(sWorkDir + "/" + indexDirs.at(j)).isDir()) paths.insert(indexDirs.at(j));
+        }
+
+        GBL_Status_Map::const_iterator it = m_entries.lowerBound(sPrefix);
+        for (; it != m_entries.constEnd() && it.key().startsWith(sPrefix); ++it)
+        {
+            int nSlash = it.key().indexOf('/', sPrefix.size());
+            if (nSlash < 0)
+            {
+                paths.insert(it.key());
+            }
+            else if (!QFileInfo(sWorkDir + "/" + it.key().left(nSlash)).isDir())
+            {
+                paths.insert(it.key().left(nSlash));
+            }
+        }
+
+        QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks);
+        for (int j = 0; j < subdirs.size(); j++)
+        {
+            QString sSub = sPrefix + subdirs.at(j);
+            if (m_knownDirs.contains(sSub) || subdirs.at(j) == ".git" || m_pRepo->is_path_ignored(sSub + "/")) continue;
+
+            paths.insert(sSub);
+            if (QFileInfo(dir.filePath(subdirs.at(j) + "/.git")).exists()) continue;
+
+            QStringList added;
+            listDirs(sSub, added);
+            for (int k = 0; k < added.size(); k++)
+            {
+                m_knownDirs.insert(added.at(k));
+            }
+            newDirs.append(added);
         }
     }
-    else
+
+    if (!newDirs.isEmpty()) emit statusWatch(newDirs, false);
+
+    return true;
+}
+
+/**
+ * @brief GBL_StatusThread::updatePaths
+ * takes the status of the paths, replacing what was known of them
+ * @param paths files, or directories standing for everything under them
+ * @return
+ */
+bool GBL_StatusThread::updatePaths(const QSet<QString> &paths)
+{
+    if (paths.isEmpty()) return true;
+
+    QStringList pathList = paths.toList();
+    GBL_Status_Map entries;
+    if (!m_pRepo->get_status_entries(entries, GIT_STATUS_SHOW_INDEX_AND_WORKDIR, &pathList, true)) return false;
+
+    // drop what was known of the paths, a path may stand for a whole directory
+    for (int i = 0; i < pathList.size(); i++)
     {
-        start_thread();
+        m_entries.remove(pathList.at(i));
+
+        QString sPrefix = pathList.at(i) + "/";
+        GBL_Status_Map::iterator it = m_entries.lowerBound(sPrefix);
+        while (it != m_entries.end() && it.key().startsWith(sPrefix))
+        {
+            it = m_entries.erase(it);
+        }
+    }
+
+    GBL_Status_Map::const_iterator it = entries.constBegin();
+    for (; it != entries.constEnd(); ++it)
+    {
+        m_entries.insert(it.key(), it.value());
     }
+
+    return true;
 }
 
 /**
- * @brief GBL_StatusThread::run
+ * @brief GBL_StatusThread::listDirs
+ * @param sDir relative to the working tree, empty for its root
+ * @param dirs gets sDir and the directories under it, leaving out ignored
+ * directories, linked directories and nested repositories
  */
-void GBL_StatusThread::run()
+void GBL_StatusThread::listDirs(const QString &sDir, QStringList &dirs)
 {
-    m_mutex.lock();
-    cleanup();
-    m_mutex.unlock();
+    dirs.append(sDir);
 
-    bool bRet = m_pRepo->get_repo_status(m_pStagedArr, m_pUnstagedArr);
-    m_sError = !bRet ? m_pRepo->get_error_msg() : "";
+    QString sPrefix = sDir.isEmpty() ? QString() : sDir + "/";
+    QDir dir(sDir.isEmpty() ? m_sRepoPath : m_sRepoPath + "/" + sDir);
+    QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks);
+    for (int i = 0; i < subdirs.size(); i++)
+    {
+        QString sSub = sPrefix + subdirs.at(i);
+        if (subdirs.at(i) == ".git" || m_pRepo->is_path_ignored(sSub + "/")) continue;
+        if (QFileInfo(dir.filePath(subdirs.at(i) + "/.git")).exists()) continue;
 
-    emit statusUpdated(&m_sError, m_pStagedArr, m_pUnstagedArr);
-    quit();
+        listDirs(sSub, dirs);
+    }
+}
+
+/**
+ * @brief GBL_StatusThread::buildArrays
+ * fills the staged and unstaged arrays from the entries, in path order
+ */
+void GBL_StatusThread::buildArrays()
+{
+    GBL_Status_Map::const_iterator it = m_entries.constBegin();
+    for (; it != m_entries.constEnd(); ++it)
+    {
+        if (it.value().staged) m_pStagedArr->appendPath(it.key(), it.value().staged);
+        if (it.value().unstaged) m_pUnstagedArr->appendPath(it.key(), it.value().unstaged);
+    }
 }
 
 /**
@@ -439,6 +1056,8 @@ void GBL_StatusThread::run()
  */
 GBL_ScanThread::GBL_ScanThread(QObject *parent) : GBL_Thread(GBL_String(""),parent)
 {
+    m_nSearchType = SCAN_THREAD_SEARCH_TYPE_INSENSITIVE;
+    m_nOptions = 0;
 
 }
 
@@ -447,99 +1066,415 @@ GBL_ScanThread::GBL_ScanThread(QObject *parent) : GBL_Thread(GBL_String(""),pare
  */
 GBL_ScanThread::~GBL_ScanThread()
 {
-
+    // let the scan pool wind down before the base class waits on run()
+    requestInterruption();
 }
 
-void GBL_ScanThread::scan(GBL_String sRootPath, GBL_String sSearch, int nSearchType)
+void GBL_ScanThread::scan(GBL_String sRootPath, GBL_String sSearch, int nSearchType, int nOptions, GBL_String sRange)
 {
     stop_thread();
     m_mutex.lock();
     m_sRootPath = sRootPath;
     m_sSearch = sSearch;
     m_nSearchType = nSearchType;
+    m_nOptions = nOptions;
+    m_sRange = sRange;
     m_mutex.unlock();
     start_thread();
 
 }
 
+/**
+ * @brief GBL_ScanThread::takeResults
+ * hands the matches collected since the last call over to the caller
+ * @param batch
+ */
+void GBL_ScanThread::takeResults(GBL_Scan_Match_Array &batch)
+{
+    batch.clear();
+    m_mutex.lock();
+    batch.swap(m_results);
+    m_mutex.unlock();
+}
+
+/**
+ * @brief GBL_ScanThread::run
+ * scans the repositories under the root path on a pool of threads and
+ * queues their matches in directory order. scanResultsReady is emitted once
+ * per update when there are new matches to take.
+ */
 void GBL_ScanThread::run()
 {
     QDir dir(m_sRootPath);
     QStringList dirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    GBL_String sRepoPath;
+    QStringList repoPaths;
+    for (int i = 0; i < dirs.size(); i++)
+    {
+        repoPaths.append(m_sRootPath + "/" + dirs.at(i));
+    }
+
     int dirSize = dirs.size();
-    QString sOutput;
-    bool bFound = false;
-    sOutput = "<h1>Search: "+m_sSearch.toHtmlEscaped()+"</h1>";
-    for (int i = 0; i < dirSize; i++)
+
+    m_mutex.lock();
+    m_results.clear();
+    m_mutex.unlock();
+
+    GBL_ScanJob job(repoPaths, m_sSearch, m_nSearchType, m_nOptions, m_sRange, this);
+    QElapsedTimer timer;
+    timer.start();
+    job.start();
+
+    int nNextRepo = 0;
+    bool bDone = false;
+    GBL_Scan_Match_Array batch;
+    while (!bDone)
     {
-        bFound = false;
-        if (isInterruptionRequested()) break;
+        bDone = job.wait(GBL_SCAN_UPDATE_MSECS);
 
-        sRepoPath = m_sRootPath;
-        sRepoPath += "/" + dirs[i];
+        if (isInterruptionRequested())
+        {
+            job.cancel();
+            job.wait();
+            break;
+        }
 
-        m_mutex.lock();
-        m_mutex.unlock();
-        emit scanUpdated(i,dirSize, &m_sOutput);
-        if (m_pRepo->open_repo(sRepoPath))
+        // repositories finish in any order, their matches go in directory order
+        for (; nNextRepo < dirSize && job.isRepoDone(nNextRepo); nNextRepo++)
         {
-            GBL_File_Array fa;
-            m_pRepo->get_tree_from_commit_oid("", &fa);
-            for (int j = 0; j < fa.size(); j++)
+            const GBL_Scan_Repo *pScanRepo = job.repo(nNextRepo);
+            for (int nChunk = 0; nChunk < pScanRepo->chunk_matches.size(); nChunk++)
             {
-                if (isInterruptionRequested()) break;
-
-                GBL_File_Item *pFI = fa[j];
-                QString content, filePath, blurb;
-                if (m_pRepo->get_blob_content(GBL_String(pFI->file_oid), content))
+                const GBL_Scan_Match_Array &matches = pScanRepo->chunk_matches.at(nChunk);
+                for (int j = 0; j < matches.size(); j++)
                 {
-                    int pos = -1;
-                    switch (m_nSearchType)
-                    {
-                        case SCAN_THREAD_SEARCH_TYPE_INSENSITIVE:
-                            pos = content.indexOf(m_sSearch, Qt::CaseInsensitive);
-                            break;
-                        case SCAN_THREAD_SEARCH_TYPE_SENSITIVE:
-                            pos = content.indexOf(m_sSearch, Qt::CaseInsensitive);
-                            break;
-                        case SCAN_THREAD_SEARCH_TYPE_REGEX:
-                            {
-                                QRegExp re(m_sSearch);
-                                pos = content.indexOf(re);
-                            }
-                            break;
-                    }
-
-                    if (pos > -1 )
-                    {
-                        if (!bFound)
-                        {
-                            bFound = true;
-                            sOutput += "<h2>"+sRepoPath+"</h2><table cellspacing='2'>";
-                        }
-                        filePath = pFI->sub_dir;
-                        filePath += pFI->file_name;
-                        int start = pos >= 50 ? pos - 50 : 0;
-                        int blurbSize = m_sSearch.size() + 100;
-                        if ((pos + blurbSize) > content.size()) blurbSize = content.size() - start;
-                        blurb = content.mid(start, blurbSize);
-                        blurb.remove(QRegExp("<[^>]*>"));
-
-                        sOutput += "<tr><td><b>";
-                        sOutput += filePath + "</b></td><td>";
-                        sOutput += "<td>" + blurb.toHtmlEscaped();
-                        sOutput += "</td></tr>";
-                    }
+                    batch.append(matches.at(j));
+                    batch.last().repo_name = dirs.at(nNextRepo);
                 }
             }
-            if (bFound) sOutput += "</table>";
-            emit scanUpdated(i,dirSize, &m_sOutput);
         }
+
+        if (!batch.isEmpty())
+        {
+            m_mutex.lock();
+            m_results += batch;
+            m_mutex.unlock();
+            batch.clear();
+            emit scanResultsReady();
+        }
+
+        qint64 nMsecs = qMax(timer.elapsed(), (qint64)1);
+        // blobs already searched in another repository or ruled out by the trigram index
+        qint64 nSkipped = job.sharedBlobCount() + job.prunedBlobCount();
+        emit scanThroughput(job.blobCount() * 1000.0 / nMsecs, job.byteCount() * 1000.0 / nMsecs / (1024 * 1024), nSkipped);
+        emit scanUpdated(job.finishedCount(), dirSize);
     }
+
+    if (bDone && !isInterruptionRequested() && (m_nOptions & SCAN_THREAD_OPTION_BLOB_CACHE))
+    {
+        job.saveBlobCache();
+    }
+
+    emit scanUpdated(dirSize,dirSize);
+    emit scanFinished();
+}
+
+/**
+ * @brief GBL_DiffThread::GBL_DiffThread
+ * @param sRepoPath
+ * @param parent
+ */
+GBL_DiffThread::GBL_DiffThread(GBL_String sRepoPath, QObject *parent) : GBL_Thread(sRepoPath, parent)
+{
+    m_bBusy = false;
+    m_bDiffPending = false;
+    m_nType = GBL_DIFF_TYPE_COMMIT;
+    m_bLimited = false;
+    m_bFilesPending = false;
+    m_nFilesGeneration = 0;
+    m_pCommitDiff = new GBL_CommitDiff(m_pRepo);
+    m_nRunGeneration = 0;
+    m_nNextPublish = 0;
+    m_nResultGeneration = 0;
+    m_nFilesResultGeneration = 0;
+}
+
+/**
+ * @brief GBL_DiffThread::~GBL_DiffThread
+ */
+GBL_DiffThread::~GBL_DiffThread()
+{
+    // stop the diff at its next check, run() uses members gone by the base destructor
+    requestInterruption();
+    wait();
+
+    delete m_pCommitDiff;
+}
+
+/**
+ * @brief GBL_DiffThread::diff
+ * queues a diff, replacing the one being computed
+ * @param nType GBL_DIFF_TYPE_ value
+ * @param sOid commit for GBL_DIFF_TYPE_COMMIT
+ * @param paths
+ * @param pLimits Q_NULLPTR for the full diff
+ * @return the generation diffReady reports for this request
+ */
+int GBL_DiffThread::diff(int nType, GBL_String sOid, QStringList paths, const GBL_Diff_Limits *pLimits)
+{
+    QMutexLocker locker(&m_mutex);
+    int nGeneration = m_nGeneration.fetchAndAddOrdered(1) + 1;
+    m_bDiffPending = true;
+    m_nDiffGeneration.store(nGeneration);
+    m_nType = nType;
+    m_sOid = sOid;
+    m_paths = paths;
+    m_bLimited = pLimits != Q_NULLPTR;
+    if (pLimits) m_limits = *pLimits;
+    locker.unlock();
+
+    kick();
+
+    return nGeneration;
+}
+
+/**
+ * @brief GBL_DiffThread::takeDiff
+ * @param nGeneration
+ * @param buffer gets the lines computed so far, shared not copied
+ * @return false if the result is for another request
+ */
+bool GBL_DiffThread::takeDiff(int nGeneration, GBL_DiffBuffer &buffer)
+{
+    QMutexLocker locker(&m_mutex);
+    if (nGeneration != m_nResultGeneration) return false;
+
+    buffer = m_result;
+
+    return true;
+}
+
+/**
+ * @brief GBL_DiffThread::commitFiles
+ * queues listing the files a commit changed. A diff request doesn't replace
+ * it, the list is made first when both are pending.
+ * @param sOid
+ * @return the generation commitFilesReady reports for this request
+ */
+int GBL_DiffThread::commitFiles(GBL_String sOid)
+{
+    QMutexLocker locker(&m_mutex);
+    int nGeneration = m_nGeneration.fetchAndAddOrdered(1) + 1;
+    m_bFilesPending = true;
+    m_nFilesGeneration = nGeneration;
+    m_sFilesOid = sOid;
+    locker.unlock();
+
+    kick();
+
+    return nGeneration;
+}
+
+/**
+ * @brief GBL_DiffThread::takeCommitFiles
+ * @param nGeneration
+ * @param files gets the files
+ * @return false if the result is for another request
+ */
+bool GBL_DiffThread::takeCommitFiles(int nGeneration, GBL_FileList &files)
+{
+    QMutexLocker locker(&m_mutex);
+    if (nGeneration != m_nFilesResultGeneration) return false;
+
+    files.swap(m_files);
+    m_nFilesResultGeneration = 0;
+
+    return true;
+}
+
+void GBL_DiffThread::kick()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_bBusy)
+    {
+        m_bRestart = true;
+        return;
+    }
+
+    m_bBusy = true;
+    locker.unlock();
+
+    // the last run may still be on its way out
+    wait();
+    start(LowPriority);
+}
+
+bool GBL_DiffThread::isStale(int nGeneration) const
+{
+    return nGeneration != m_nDiffGeneration.load() || isInterruptionRequested();
+}
+
+/**
+ * @brief GBL_DiffThread::diffProgress
+ * called from the diff every GBL_DIFF_CHECK_LINES lines, sends the first
+ * screen and then ever bigger chunks ahead, and stops the diff once a newer
+ * one is queued. Each send makes the next line copy the buffer, doubling the
+ * chunks keeps the copying in proportion to the diff.
+ * @param buffer
+ * @return
+ */
+bool GBL_DiffThread::diffProgress(const GBL_DiffBuffer &buffer)
+{
+    if (isStale(m_nRunGeneration)) return false;
+
+    if (buffer.lineCount() >= m_nNextPublish)
+    {
+        m_nNextPublish = buffer.lineCount() * 2;
+        publish(m_nRunGeneration, buffer, false);
+    }
+
+    return true;
+}
+
+void GBL_DiffThread::publish(int nGeneration, const GBL_DiffBuffer &buffer, bool bComplete)
+{
     m_mutex.lock();
-    m_sOutput = sOutput;
+    m_result = buffer;
+    m_result.setObserver(Q_NULLPTR, 0);
+    m_nResultGeneration = nGeneration;
     m_mutex.unlock();
-    emit scanUpdated(dirSize,dirSize, &m_sOutput);
-    emit scanFinished();
+
+    emit diffReady(nGeneration, bComplete);
+}
+
+/**
+ * @brief GBL_DiffThread::openCommit
+ * @param sOid
+ * @return false if the commit's diffs couldn't be made
+ */
+bool GBL_DiffThread::openCommit(const QString &sOid)
+{
+    if (m_pCommitDiff->isOpen(sOid)) return true;
+
+    bool bRet = m_pCommitDiff->open(sOid);
+    m_sError = !bRet ? m_pRepo->get_error_msg() : "";
+
+    return bRet;
+}
+
+/**
+ * @brief GBL_DiffThread::runFiles
+ * @param nGeneration
+ * @param sOid
+ */
+void GBL_DiffThread::runFiles(int nGeneration, const QString &sOid)
+{
+    GBL_FileList files;
+    if (openCommit(sOid)) m_pCommitDiff->getFiles(&files);
+
+    m_mutex.lock();
+    if (nGeneration != m_nFilesGeneration || isInterruptionRequested())
+    {
+        m_mutex.unlock();
+        return;
+    }
+
+    m_files.swap(files);
+    m_nFilesResultGeneration = nGeneration;
+    m_mutex.unlock();
+
+    emit commitFilesReady(nGeneration);
+}
+
+/**
+ * @brief GBL_DiffThread::runDiff
+ * @param nType
+ * @param sOid
+ * @param paths
+ * @param pLimits Q_NULLPTR for the full diff
+ */
+void GBL_DiffThread::runDiff(int nType, const QString &sOid, const QStringList &paths, const GBL_Diff_Limits *pLimits)
+{
+    m_nNextPublish = GBL_DIFF_FIRST_SCREEN_LINES;
+    GBL_DiffBuffer buffer;
+    QString sCacheKey;
+
+    // commit diffs never change, working tree and index ones do
+    if (nType == GBL_DIFF_TYPE_COMMIT)
+    {
+        quint32 nOptions = GIT_DIFF_NORMAL | (pLimits ? 0 : GBL_DIFF_CACHE_FULL);
+        sCacheKey = GBL_DiffCache::key(sOid, GBL_DIFF_ALL_PARENTS, paths.isEmpty() ? QString() : paths.first(), nOptions);
+        if (GBL_DiffCache::getInstance()->find(sCacheKey, buffer))
+        {
+            publish(m_nRunGeneration, buffer, true);
+            return;
+        }
+    }
+
+    buffer.setObserver(this, GBL_DIFF_CHECK_LINES);
+
+    bool bRet = false;
+    switch (nType)
+    {
+        case GBL_DIFF_TYPE_COMMIT:
+            if (openCommit(sOid))
+            {
+                bRet = m_pCommitDiff->getPatch(paths.isEmpty() ? QString() : paths.first(), &buffer, pLimits);
+            }
+            break;
+        case GBL_DIFF_TYPE_WORKDIR:
+            {
+                QStringList workPaths = paths;
+                bRet = m_pRepo->get_index_to_work_diff(&buffer, &workPaths, pLimits);
+            }
+            break;
+        case GBL_DIFF_TYPE_STAGED:
+            {
+                QStringList stagedPaths = paths;
+                bRet = m_pRepo->get_index_to_head_diff(&buffer, &stagedPaths, pLimits);
+            }
+            break;
+    }
+
+    if (isStale(m_nRunGeneration)) return;
+
+    m_sError = !bRet ? m_pRepo->get_error_msg() : "";
+    buffer.setObserver(Q_NULLPTR, 0);
+    if (bRet && !sCacheKey.isEmpty()) GBL_DiffCache::getInstance()->insert(sCacheKey, buffer);
+    publish(m_nRunGeneration, buffer, true);
+}
+
+/**
+ * @brief GBL_DiffThread::run
+ * handles the newest requests, and again while newer ones come in
+ */
+void GBL_DiffThread::run()
+{
+    forever
+    {
+        m_mutex.lock();
+        bool bFiles = m_bFilesPending;
+        int nFilesGeneration = m_nFilesGeneration;
+        QString sFilesOid = m_sFilesOid;
+        bool bDiff = m_bDiffPending;
+        int nType = m_nType;
+        QString sOid = m_sOid;
+        QStringList paths = m_paths;
+        bool bLimited = m_bLimited;
+        GBL_Diff_Limits limits = m_limits;
+        m_nRunGeneration = m_nDiffGeneration.load();
+        m_bFilesPending = false;
+        m_bDiffPending = false;
+        m_bRestart = false;
+        m_mutex.unlock();
+
+        if (bFiles) runFiles(nFilesGeneration, sFilesOid);
+        if (bDiff) runDiff(nType, sOid, paths, bLimited ? &limits : Q_NULLPTR);
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_bRestart || isInterruptionRequested())
+        {
+            m_bBusy = false;
+            break;
+        }
+    }
 }
@@ -3,15 +3,45 @@
 
 #include "gbl_string.h"
 #include "gbl_repository.h"
+#include "gbl_commitdiff.h"
+#include "gbl_graphlayout.h"
+#include "gbl_scan.h"
+#include "gbl_untrackedcache.h"
 
 #include <QThread>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QSet>
 
 #define SCAN_THREAD_SEARCH_TYPE_INSENSITIVE 1
 #define SCAN_THREAD_SEARCH_TYPE_SENSITIVE   2
 #define SCAN_THREAD_SEARCH_TYPE_REGEX       3
 
+#define SCAN_THREAD_OPTION_BLOB_CACHE       0x1
+#define SCAN_THREAD_OPTION_USE_INDEX        0x2
+#define SCAN_THREAD_OPTION_HISTORY          0x4
+
+#define GBL_HISTORY_UPDATE_RESET    0
+#define GBL_HISTORY_UPDATE_APPEND   1
+#define GBL_HISTORY_UPDATE_PREPEND  2
+
+#define GBL_DIFF_TYPE_COMMIT        0
+#define GBL_DIFF_TYPE_WORKDIR       1
+#define GBL_DIFF_TYPE_STAGED        2
+
+// GBL_StatusThread::status modes, a full status, the index and the changed
+// directories, or only the changed directories
+#define GBL_STATUS_FULL             0
+#define GBL_STATUS_DIRS             1
+#define GBL_STATUS_INDEX            2
+
+// lines between checks for a newer request, and the lines sent ahead of the rest.
+// After the first screen the lines are sent in chunks twice the size of the last.
+#define GBL_DIFF_CHECK_LINES        64
+#define GBL_DIFF_FIRST_SCREEN_LINES 200
+
 QT_BEGIN_NAMESPACE
 QT_END_NAMESPACE
 
@@ -140,16 +170,32 @@ public:
     ~GBL_HistoryThread();
 
     void get_history();
+    void fetch_more();
+    void refresh_history(const GBL_CommitStore &loaded);
+    void save_cache(const GBL_CommitStore &store);
 
 signals:
-    void historyUpdated(GBL_String*, GBL_History_Array *pHistArr);
+    void historyUpdated(GBL_String*, GBL_CommitStore *pPage, int nUpdate, bool bMore);
 
 
 protected:
     void run() override;
     void cleanup();
-
-    GBL_History_Array *m_pHistArr;
+    void cleanup_walker();
+    bool load_cache(bool &bMore);
+    bool load_new_commits(const git_oid &tipOid);
+    bool walk_new_commits(const git_oid &tipOid);
+
+    GBL_CommitStore *m_pPage;
+    git_revwalk *m_pWalker;
+    bool m_bFetchMore;
+    bool m_bRefresh;
+    GBL_CommitStore m_loadedStore;
+    GBL_GraphLayout m_graph;
+    bool m_bSaveCache;
+    GBL_CommitStore m_saveStore;
+    QString m_sCacheFile;
+    int m_nCachedRows;
 };
 
 /**
@@ -184,14 +230,33 @@ public:
     ~GBL_StatusThread();
 
     void status(GBL_String sRepoPath);
+    void status(GBL_String sRepoPath, int nMode, const QStringList &dirs, bool bQuiet);
 
 signals:
-    void statusUpdated(GBL_String*, GBL_File_Array*,GBL_File_Array*);
+    void statusUpdated(GBL_String*, GBL_FileList*,GBL_FileList*);
+    void statusWatch(const QStringList&, bool);
 protected:
     void run() override;
     void cleanup();
 
-    GBL_File_Array *m_pStagedArr, *m_pUnstagedArr;
+private:
+    bool runFull();
+    bool runIndex(const QStringList &dirs);
+    bool runDirs(const QStringList &dirs);
+    bool walkUntracked(const QString &sDir, bool bIgnoreChanged, qint64 nScanTime, GBL_Status_Map &entries, QStringList &dirs);
+    bool collectDirPaths(const QStringList &dirs, QSet<QString> &paths);
+    bool updatePaths(const QSet<QString> &paths);
+    void listDirs(const QString &sDir, QStringList &dirs);
+    void buildArrays();
+
+    GBL_FileList *m_pStagedArr, *m_pUnstagedArr;
+    GBL_Status_Map m_entries;
+    QSet<QString> m_knownDirs;
+    GBL_UntrackedCache m_untrackedCache;
+    QString m_sCacheFile;
+    int m_nMode;
+    QStringList m_dirs;
+    bool m_bQuiet;
 };
 
 /**
@@ -204,10 +269,13 @@ public:
     GBL_ScanThread(QObject *parent = Q_NULLPTR);
     ~GBL_ScanThread();
 
-    void scan(GBL_String sRootPath, GBL_String sSearch, int nSearchType);
+    void scan(GBL_String sRootPath, GBL_String sSearch, int nSearchType, int nOptions = 0, GBL_String sRange = GBL_String());
+    void takeResults(GBL_Scan_Match_Array &batch);
 
 signals:
-    void scanUpdated(int prog_value, int prog_max, GBL_String *psOutput);
+    void scanUpdated(int prog_value, int prog_max);
+    void scanResultsReady();
+    void scanThroughput(double dBlobsPerSec, double dMBPerSec, qint64 nSkippedBlobs);
     void scanFinished();
 
 protected:
@@ -215,8 +283,72 @@ protected:
 
     GBL_String m_sRootPath;
     GBL_String m_sSearch;
-    GBL_String m_sOutput;
+    GBL_String m_sRange;
+    GBL_Scan_Match_Array m_results;
     int m_nSearchType;
+    int m_nOptions;
+};
+
+/**
+ * @brief The GBL_DiffThread class
+ * computes diffs in the background. Each request gets a generation, a newer
+ * diff request stops the diff being computed and only the newest result can
+ * be taken. The diffs of the last commit asked for are kept, so its file
+ * list and the patches of its files don't compare the trees again.
+ */
+class GBL_DiffThread : public GBL_Thread, public GBL_DiffObserver
+{
+    Q_OBJECT
+public:
+    GBL_DiffThread(GBL_String sRepoPath, QObject *parent = Q_NULLPTR);
+    ~GBL_DiffThread();
+
+    int diff(int nType, GBL_String sOid, QStringList paths, const GBL_Diff_Limits *pLimits = Q_NULLPTR);
+    bool takeDiff(int nGeneration, GBL_DiffBuffer &buffer);
+    int commitFiles(GBL_String sOid);
+    bool takeCommitFiles(int nGeneration, GBL_FileList &files);
+
+    bool diffProgress(const GBL_DiffBuffer &buffer) override;
+
+signals:
+    void diffReady(int nGeneration, bool bComplete);
+    void commitFilesReady(int nGeneration);
+
+protected:
+    void run() override;
+    void kick();
+    bool isStale(int nGeneration) const;
+    bool openCommit(const QString &sOid);
+    void runFiles(int nGeneration, const QString &sOid);
+    void runDiff(int nType, const QString &sOid, const QStringList &paths, const GBL_Diff_Limits *pLimits);
+    void publish(int nGeneration, const GBL_DiffBuffer &buffer, bool bComplete);
+
+    QAtomicInt m_nGeneration;
+    bool m_bBusy;
+
+    // the pending diff request
+    bool m_bDiffPending;
+    QAtomicInt m_nDiffGeneration;
+    int m_nType;
+    GBL_String m_sOid;
+    QStringList m_paths;
+    bool m_bLimited;
+    GBL_Diff_Limits m_limits;
+
+    // the pending file list request
+    bool m_bFilesPending;
+    int m_nFilesGeneration;
+    GBL_String m_sFilesOid;
+
+    // only touched by run()
+    GBL_CommitDiff *m_pCommitDiff;
+    int m_nRunGeneration;
+    int m_nNextPublish;
+
+    GBL_DiffBuffer m_result;
+    int m_nResultGeneration;
+    GBL_FileList m_files;
+    int m_nFilesResultGeneration;
 };
 
 #endif // GBL_THREADS_H
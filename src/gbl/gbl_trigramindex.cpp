@@ -0,0 +1,504 @@
+#include "gbl_trigramindex.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+#include <algorithm>
+#include <iterator>
+#include <ctype.h>
+#include <string.h>
+
+static inline uchar gbl_trigram_fold(uchar c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static inline quint32 gbl_trigram(const uchar *p)
+{
+    return ((quint32)gbl_trigram_fold(p[0]) << 16) | ((quint32)gbl_trigram_fold(p[1]) << 8) | gbl_trigram_fold(p[2]);
+}
+
+static void gbl_varint_append(QByteArray &ba, quint32 n)
+{
+    while (n >= 0x80)
+    {
+        ba.append((char)((n & 0x7F) | 0x80));
+        n >>= 7;
+    }
+    ba.append((char)n);
+}
+
+static int gbl_skip_to(const QByteArray &ba, int i, char cEnd)
+{
+    while (i < ba.size() && ba.at(i) != cEnd) i++;
+    return i;
+}
+
+/**
+ * @brief gbl_escape_end
+ * @param ba regular expression
+ * @param i index of the letter or digit after a backslash
+ * @return index of the last character of the escape, so the operands of
+ * \x41 \x{41} \p{Lu} \N{U+41} \012 \cX \g{1} \k<name> etc aren't taken as text
+ */
+static int gbl_escape_end(const QByteArray &ba, int i)
+{
+    char c = ba.at(i);
+    char cNext = i + 1 < ba.size() ? ba.at(i + 1) : 0;
+
+    if (cNext == '{' && strchr("xopPNgk", c)) return gbl_skip_to(ba, i + 1, '}');
+    if (c == 'k' && (cNext == '<' || cNext == '\'')) return gbl_skip_to(ba, i + 2, cNext == '<' ? '>' : '\'');
+    if ((c == 'p' || c == 'P' || c == 'c') && cNext) return i + 1;
+
+    // quoted text, left out rather than taken apart
+    if (c == 'Q')
+    {
+        int nEnd = ba.indexOf("\\E", i + 1);
+        return nEnd < 0 ? ba.size() : nEnd + 1;
+    }
+
+    if (c == 'x')
+    {
+        for (int n = 0; n < 2 && i + 1 < ba.size() && isxdigit((uchar)ba.at(i + 1)); n++) i++;
+    }
+    else if (c == '0')
+    {
+        for (int n = 0; n < 2 && i + 1 < ba.size() && ba.at(i + 1) >= '0' && ba.at(i + 1) <= '7'; n++) i++;
+    }
+    else if (isdigit((uchar)c) || (c == 'g' && (cNext == '-' || isdigit((uchar)cNext))))
+    {
+        // a back reference or octal escape, all of its digits
+        if (c == 'g' && cNext == '-') i++;
+        while (i + 1 < ba.size() && isdigit((uchar)ba.at(i + 1))) i++;
+    }
+
+    return i;
+}
+
+/**
+ * @brief GBL_TrigramIndex::GBL_TrigramIndex
+ */
+GBL_TrigramIndex::GBL_TrigramIndex()
+{
+    m_nCheckedBlobs = 0;
+    m_bModified = false;
+}
+
+void GBL_TrigramIndex::clear()
+{
+    m_oids.clear();
+    m_oidIndex.clear();
+    m_postings.clear();
+    m_nCheckedBlobs = 0;
+    m_bModified = true;
+}
+
+/**
+ * @brief GBL_TrigramIndex::load
+ * @param sFile
+ * @return false if there is no usable index, the index is left empty
+ */
+bool GBL_TrigramIndex::load(const QString &sFile)
+{
+    QFile file(sFile);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray baMagic;
+    quint32 nVersion = 0, nBlobs = 0, nChecked = 0, nTrigrams = 0;
+    in >> baMagic >> nVersion >> nBlobs >> nChecked;
+    if (baMagic != GBL_TRIGRAM_INDEX_MAGIC || nVersion != GBL_TRIGRAM_INDEX_VERSION) return false;
+    if ((qint64)nBlobs * GIT_OID_RAWSZ > file.size() || nChecked > nBlobs) return false;
+
+    QVector<git_oid> oids(nBlobs);
+    if (nBlobs && in.readRawData((char*)oids.data(), nBlobs * sizeof(git_oid)) != (int)(nBlobs * sizeof(git_oid))) return false;
+
+    QHash<quint32, GBL_Trigram_Posting> postings;
+    in >> nTrigrams;
+    postings.reserve(nTrigrams);
+    for (quint32 i = 0; i < nTrigrams && in.status() == QDataStream::Ok; i++)
+    {
+        quint32 trigram = 0;
+        GBL_Trigram_Posting posting;
+        in >> trigram >> posting.last >> posting.gaps;
+        if (posting.last >= nBlobs) return false;
+        postings.insert(trigram, posting);
+    }
+
+    if (in.status() != QDataStream::Ok) return false;
+
+    m_oids.swap(oids);
+    m_postings.swap(postings);
+    m_nCheckedBlobs = nChecked;
+    m_oidIndex.clear();
+    m_oidIndex.reserve(m_oids.size());
+    for (int i = 0; i < m_oids.size(); i++)
+    {
+        m_oidIndex.insert(m_oids.at(i), i);
+    }
+    m_bModified = false;
+
+    return true;
+}
+
+/**
+ * @brief GBL_TrigramIndex::save
+ * @param sFile
+ * @return
+ */
+bool GBL_TrigramIndex::save(const QString &sFile) const
+{
+    QSaveFile file(sFile);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << QByteArray(GBL_TRIGRAM_INDEX_MAGIC) << (quint32)GBL_TRIGRAM_INDEX_VERSION << (quint32)m_oids.size() << (quint32)m_nCheckedBlobs;
+    out.writeRawData((const char*)m_oids.constData(), m_oids.size() * sizeof(git_oid));
+
+    out << (quint32)m_postings.size();
+    QHash<quint32, GBL_Trigram_Posting>::const_iterator it;
+    for (it = m_postings.constBegin(); it != m_postings.constEnd(); ++it)
+    {
+        out << it.key() << it.value().last << it.value().gaps;
+    }
+
+    if (out.status() != QDataStream::Ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+/**
+ * @brief GBL_TrigramIndex::addBlob
+ * adds a blob's trigrams under the next blob number. Binary blobs are added
+ * with no content so they are known but never a candidate.
+ * @param oid
+ * @param pData
+ * @param nSize
+ */
+void GBL_TrigramIndex::addBlob(const git_oid &oid, const char *pData, int nSize)
+{
+    if (contains(oid)) return;
+
+    quint32 nBlob = m_oids.size();
+    m_oids.append(oid);
+    m_oidIndex.insert(oid, nBlob);
+    m_bModified = true;
+
+    m_trigrams.resize(0);
+    const uchar *p = (const uchar*)pData;
+    for (int i = 0; i + 2 < nSize; i++)
+    {
+        m_trigrams.append(gbl_trigram(p + i));
+    }
+
+    std::sort(m_trigrams.begin(), m_trigrams.end());
+    QVector<quint32>::iterator itEnd = std::unique(m_trigrams.begin(), m_trigrams.end());
+
+    for (QVector<quint32>::iterator it = m_trigrams.begin(); it != itEnd; ++it)
+    {
+        QHash<quint32, GBL_Trigram_Posting>::iterator itPosting = m_postings.find(*it);
+        if (itPosting == m_postings.end())
+        {
+            GBL_Trigram_Posting posting;
+            posting.last = nBlob;
+            gbl_varint_append(posting.gaps, nBlob);
+            m_postings.insert(*it, posting);
+        }
+        else
+        {
+            gbl_varint_append(itPosting.value().gaps, nBlob - itPosting.value().last);
+            itPosting.value().last = nBlob;
+        }
+    }
+}
+
+/**
+ * @brief GBL_TrigramIndex::removeBlobs
+ * drops blobs and renumbers the rest, every posting is coded again
+ * @param oids
+ */
+void GBL_TrigramIndex::removeBlobs(const QSet<git_oid> &oids)
+{
+    if (oids.isEmpty()) return;
+
+    QVector<qint32> blobMap(m_oids.size(), -1);
+    QVector<git_oid> kept;
+    kept.reserve(m_oids.size());
+    for (int i = 0; i < m_oids.size(); i++)
+    {
+        if (oids.contains(m_oids.at(i))) continue;
+
+        blobMap[i] = kept.size();
+        kept.append(m_oids.at(i));
+    }
+
+    if (kept.size() == m_oids.size()) return;
+
+    QHash<quint32, GBL_Trigram_Posting> postings;
+    postings.reserve(m_postings.size());
+    QHash<quint32, GBL_Trigram_Posting>::const_iterator it;
+    for (it = m_postings.constBegin(); it != m_postings.constEnd(); ++it)
+    {
+        // blob numbers only move down, in the same order
+        QVector<quint32> blobs = postingBlobs(it.key());
+        GBL_Trigram_Posting posting;
+        posting.last = 0;
+        bool bFirst = true;
+        for (int i = 0; i < blobs.size(); i++)
+        {
+            qint32 nBlob = blobMap.at(blobs.at(i));
+            if (nBlob < 0) continue;
+
+            gbl_varint_append(posting.gaps, bFirst ? nBlob : nBlob - posting.last);
+            posting.last = nBlob;
+            bFirst = false;
+        }
+
+        if (!bFirst) postings.insert(it.key(), posting);
+    }
+
+    m_oids.swap(kept);
+    m_postings.swap(postings);
+    m_oidIndex.clear();
+    m_oidIndex.reserve(m_oids.size());
+    for (int i = 0; i < m_oids.size(); i++)
+    {
+        m_oidIndex.insert(m_oids.at(i), i);
+    }
+    m_nCheckedBlobs = qMin(m_nCheckedBlobs, m_oids.size());
+    m_bModified = true;
+}
+
+/**
+ * @brief GBL_TrigramIndex::setChecked
+ * records that every blob in the index was found in the object database
+ */
+void GBL_TrigramIndex::setChecked()
+{
+    if (m_nCheckedBlobs == m_oids.size()) return;
+
+    m_nCheckedBlobs = m_oids.size();
+    m_bModified = true;
+}
+
+/**
+ * @brief GBL_TrigramIndex::postingBlobs
+ * @param trigram
+ * @return the ascending blob numbers holding trigram
+ */
+QVector<quint32> GBL_TrigramIndex::postingBlobs(quint32 trigram) const
+{
+    QVector<quint32> blobs;
+    QHash<quint32, GBL_Trigram_Posting>::const_iterator it = m_postings.constFind(trigram);
+    if (it == m_postings.constEnd()) return blobs;
+
+    const uchar *p = (const uchar*)it.value().gaps.constData();
+    const uchar *pEnd = p + it.value().gaps.size();
+    quint32 nBlob = 0;
+    while (p < pEnd)
+    {
+        quint32 nGap = 0;
+        int nShift = 0;
+        while (p < pEnd)
+        {
+            uchar c = *p++;
+            nGap |= (quint32)(c & 0x7F) << nShift;
+            nShift += 7;
+            if (!(c & 0x80)) break;
+        }
+        nBlob += nGap;
+        blobs.append(nBlob);
+    }
+
+    return blobs;
+}
+
+/**
+ * @brief GBL_TrigramIndex::candidates
+ * intersects the blobs holding every trigram of every literal
+ * @param literals byte strings the searched text must contain
+ * @param oids gets the blobs that may hold all the literals
+ * @return false if the literals are too short to rule any blob out
+ */
+bool GBL_TrigramIndex::candidates(const QList<QByteArray> &literals, QSet<git_oid> &oids) const
+{
+    QVector<quint32> trigrams;
+    for (int i = 0; i < literals.size(); i++)
+    {
+        const uchar *p = (const uchar*)literals.at(i).constData();
+        for (int j = 0; j + 2 < literals.at(i).size(); j++)
+        {
+            trigrams.append(gbl_trigram(p + j));
+        }
+    }
+
+    if (trigrams.isEmpty()) return false;
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    QVector<quint32> blobs = postingBlobs(trigrams.at(0));
+    for (int i = 1; i < trigrams.size() && !blobs.isEmpty(); i++)
+    {
+        QVector<quint32> next = postingBlobs(trigrams.at(i));
+        QVector<quint32> both;
+        std::set_intersection(blobs.constBegin(), blobs.constEnd(), next.constBegin(), next.constEnd(), std::back_inserter(both));
+        blobs.swap(both);
+    }
+
+    oids.clear();
+    oids.reserve(blobs.size());
+    for (int i = 0; i < blobs.size(); i++)
+    {
+        oids.insert(m_oids.at(blobs.at(i)));
+    }
+
+    return true;
+}
+
+/**
+ * @brief GBL_TrigramIndex::searchLiterals
+ * @param sSearch
+ * @param bRegex
+ * @return byte strings any match of the search has to contain. For a regular
+ * expression these are the runs of plain characters outside groups and
+ * classes, an alternation gives none since no single run is required.
+ * Escapes other than escaped punctuation end a run along with their operands.
+ */
+QList<QByteArray> GBL_TrigramIndex::searchLiterals(const QString &sSearch, bool bRegex)
+{
+    QList<QByteArray> literals;
+    QByteArray baSearch = sSearch.toUtf8();
+
+    if (!bRegex)
+    {
+        literals.append(baSearch);
+        return literals;
+    }
+
+    QByteArray run;
+    int nDepth = 0;
+    for (int i = 0; i < baSearch.size(); i++)
+    {
+        char c = baSearch.at(i);
+        char cNext = i + 1 < baSearch.size() ? baSearch.at(i + 1) : 0;
+
+        if (c == '|') return QList<QByteArray>();
+
+        if (c == '\\')
+        {
+            i++;
+            // an escaped punctuation character stands for itself, \d \w etc don't
+            if (cNext && !isalnum((uchar)cNext) && nDepth == 0)
+            {
+                run.append(cNext);
+                continue;
+            }
+            if (cNext && isalnum((uchar)cNext)) i = gbl_escape_end(baSearch, i);
+        }
+        else if (c == '[')
+        {
+            // skip the class, a ] right after [ or [^ is part of it
+            i++;
+            if (i < baSearch.size() && baSearch.at(i) == '^') i++;
+            if (i < baSearch.size() && baSearch.at(i) == ']') i++;
+            while (i < baSearch.size() && baSearch.at(i) != ']')
+            {
+                if (baSearch.at(i) == '\\') i++;
+                i++;
+            }
+        }
+        else if (c == '(')
+        {
+            nDepth++;
+        }
+        else if (c == ')')
+        {
+            if (nDepth > 0) nDepth--;
+        }
+        else if (c == '*' || c == '?' || c == '{')
+        {
+            // the character before may not be there at all
+            if (!run.isEmpty()) run.chop(1);
+            if (c == '{')
+            {
+                while (i < baSearch.size() && baSearch.at(i) != '}') i++;
+            }
+        }
+        else if (c != '+' && c != '.' && c != '^' && c != '$' && nDepth == 0)
+        {
+            run.append(c);
+            continue;
+        }
+
+        if (run.size() >= 3) literals.append(run);
+        run.clear();
+    }
+
+    if (run.size() >= 3) literals.append(run);
+
+    return literals;
+}
+
+#ifdef QT_DEBUG
+/**
+ * @brief GBL_TrigramIndex::literalsCheck
+ * @return the regular expressions whose literals aren't the expected ones
+ */
+QString GBL_TrigramIndex::literalsCheck()
+{
+    // pattern, then the literals it should give separated by spaces
+    static const char *checks[][2] = {
+        { "foo.*bar", "foo bar" },
+        { "foo|bar", "" },
+        { "(abc)def", "def" },
+        { "ab[cde]fgh", "fgh" },
+        { "abcd?efg", "abc efg" },
+        { "foo\\.bar", "foo.bar" },
+        { "\\d+abc", "abc" },
+        { "\\x414243", "4243" },
+        { "\\x{41}bcd", "bcd" },
+        { "\\p{Lu}abc", "abc" },
+        { "\\pLabc", "abc" },
+        { "\\P{Nd}abc", "abc" },
+        { "\\N{U+41}bcd", "bcd" },
+        { "\\0123abc", "3abc" },
+        { "\\cXabc", "abc" },
+        { "(a)\\1234", "" },
+        { "(a)\\g{1}bcd", "bcd" },
+        { "(?<n>a)\\k<n>bcd", "bcd" },
+        { "\\Qa.b\\Ecde", "cde" },
+    };
+
+    int nChecks = sizeof(checks) / sizeof(checks[0]);
+    QString sResult;
+    for (int i = 0; i < nChecks; i++)
+    {
+        QList<QByteArray> literals = searchLiterals(QString::fromUtf8(checks[i][0]), true);
+        QByteArray baLiterals;
+        for (int j = 0; j < literals.size(); j++)
+        {
+            if (j) baLiterals.append(' ');
+            baLiterals.append(literals.at(j));
+        }
+
+        if (baLiterals != checks[i][1])
+        {
+            sResult += QString("%1: got \"%2\", expected \"%3\"\n")
+                    .arg(checks[i][0]).arg(QString::fromUtf8(baLiterals)).arg(checks[i][1]);
+        }
+    }
+
+    if (sResult.isEmpty()) sResult = QString("%1 patterns ok").arg(nChecks);
+
+    return sResult;
+}
+#endif
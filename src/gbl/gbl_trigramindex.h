@@ -0,0 +1,72 @@
+#ifndef GBL_TRIGRAMINDEX_H
+#define GBL_TRIGRAMINDEX_H
+
+#include "gbl_commitstore.h"
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#define GBL_TRIGRAM_INDEX_MAGIC "GBLT"
+#define GBL_TRIGRAM_INDEX_VERSION 2
+
+/**
+ * @brief The GBL_Trigram_Posting struct
+ * blobs holding one trigram, as varint coded gaps between ascending blob
+ * numbers. last is the highest blob number so new blobs can be appended.
+ */
+typedef struct GBL_Trigram_Posting {
+    quint32 last;
+    QByteArray gaps;
+} GBL_Trigram_Posting;
+
+/**
+ * @brief The GBL_TrigramIndex class
+ * index of the trigrams in the blobs of one repository, keyed by blob oid so
+ * it only grows by the blobs that are new when HEAD moves, whatever commits
+ * a scan looks at. Blobs gone from the object database are removed once
+ * the index has doubled since it was last checked. Letters are folded
+ * to lower case, so one index serves case sensitive and insensitive searches.
+ * A blob can only hold a literal if it holds every trigram of the literal.
+ */
+class GBL_TrigramIndex
+{
+public:
+    GBL_TrigramIndex();
+
+    void clear();
+    bool load(const QString &sFile);
+    bool save(const QString &sFile) const;
+
+    int blobCount() const { return m_oids.size(); }
+    int checkedCount() const { return m_nCheckedBlobs; }
+    const QVector<git_oid>& blobOids() const { return m_oids; }
+    bool isModified() const { return m_bModified; }
+    bool contains(const git_oid &oid) const { return m_oidIndex.contains(oid); }
+    void addBlob(const git_oid &oid, const char *pData, int nSize);
+    void removeBlobs(const QSet<git_oid> &oids);
+    void setChecked();
+
+    bool candidates(const QList<QByteArray> &literals, QSet<git_oid> &oids) const;
+
+    static QList<QByteArray> searchLiterals(const QString &sSearch, bool bRegex);
+
+#ifdef QT_DEBUG
+    static QString literalsCheck();
+#endif
+
+private:
+    QVector<quint32> postingBlobs(quint32 trigram) const;
+
+    QVector<git_oid> m_oids;
+    QHash<git_oid, int> m_oidIndex;
+    QHash<quint32, GBL_Trigram_Posting> m_postings;
+    QVector<quint32> m_trigrams;
+    int m_nCheckedBlobs;
+    bool m_bModified;
+};
+
+#endif // GBL_TRIGRAMINDEX_H
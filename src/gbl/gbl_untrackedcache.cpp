@@ -0,0 +1,140 @@
+#include "gbl_untrackedcache.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+/**
+ * @brief GBL_UntrackedCache::GBL_UntrackedCache
+ */
+GBL_UntrackedCache::GBL_UntrackedCache()
+{
+    m_nExcludeMtime = 0;
+    m_bModified = false;
+}
+
+void GBL_UntrackedCache::clear()
+{
+    m_dirs.clear();
+    m_bModified = true;
+}
+
+/**
+ * @brief GBL_UntrackedCache::load
+ * @param sFile
+ * @param nExcludeMtime last change of .git/info/exclude, 0 if there is none
+ * @return false if there is no usable cache, the cache is left empty
+ */
+bool GBL_UntrackedCache::load(const QString &sFile, qint64 nExcludeMtime)
+{
+    m_dirs.clear();
+    m_nExcludeMtime = nExcludeMtime;
+    m_bModified = false;
+
+    QFile file(sFile);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray baMagic;
+    quint32 nVersion = 0, nDirs = 0;
+    qint64 nCachedExcludeMtime = 0;
+    in >> baMagic >> nVersion >> nCachedExcludeMtime >> nDirs;
+    if (baMagic != GBL_UNTRACKED_CACHE_MAGIC || nVersion != GBL_UNTRACKED_CACHE_VERSION) return false;
+    if (nCachedExcludeMtime != nExcludeMtime) return false;
+
+    QHash<QString, GBL_Untracked_Dir> dirs;
+    for (quint32 i = 0; i < nDirs && in.status() == QDataStream::Ok; i++)
+    {
+        QString sDir;
+        GBL_Untracked_Dir dir;
+        in >> sDir >> dir.mtime >> dir.ignore_mtime >> dir.index_hash >> dir.subdirs >> dir.untracked;
+        dirs.insert(sDir, dir);
+    }
+
+    if (in.status() != QDataStream::Ok) return false;
+
+    m_dirs.swap(dirs);
+
+    return true;
+}
+
+/**
+ * @brief GBL_UntrackedCache::save
+ * @param sFile
+ * @return
+ */
+bool GBL_UntrackedCache::save(const QString &sFile) const
+{
+    QSaveFile file(sFile);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << QByteArray(GBL_UNTRACKED_CACHE_MAGIC) << (quint32)GBL_UNTRACKED_CACHE_VERSION << m_nExcludeMtime << (quint32)m_dirs.size();
+
+    QHash<QString, GBL_Untracked_Dir>::const_iterator it;
+    for (it = m_dirs.constBegin(); it != m_dirs.constEnd(); ++it)
+    {
+        const GBL_Untracked_Dir &dir = it.value();
+        out << it.key() << dir.mtime << dir.ignore_mtime << dir.index_hash << dir.subdirs << dir.untracked;
+    }
+
+    if (out.status() != QDataStream::Ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+/**
+ * @brief GBL_UntrackedCache::find
+ * @param sDir relative to the working tree, empty for its root
+ * @return Q_NULLPTR if the directory wasn't listed before
+ */
+const GBL_Untracked_Dir* GBL_UntrackedCache::find(const QString &sDir) const
+{
+    QHash<QString, GBL_Untracked_Dir>::const_iterator it = m_dirs.constFind(sDir);
+    return it == m_dirs.constEnd() ? Q_NULLPTR : &it.value();
+}
+
+void GBL_UntrackedCache::insert(const QString &sDir, const GBL_Untracked_Dir &dir)
+{
+    m_dirs.insert(sDir, dir);
+    m_bModified = true;
+}
+
+/**
+ * @brief GBL_UntrackedCache::prune
+ * drops the directories that are gone
+ * @param dirs the directories still in the working tree
+ */
+void GBL_UntrackedCache::prune(const QSet<QString> &dirs)
+{
+    QMutableHashIterator<QString, GBL_Untracked_Dir> it(m_dirs);
+    while (it.hasNext())
+    {
+        it.next();
+        if (!dirs.contains(it.key()))
+        {
+            it.remove();
+            m_bModified = true;
+        }
+    }
+}
+
+/**
+ * @brief GBL_UntrackedCache::setExcludeMtime
+ * @param nExcludeMtime last change of .git/info/exclude, every listing is
+ * dropped if it changed
+ */
+void GBL_UntrackedCache::setExcludeMtime(qint64 nExcludeMtime)
+{
+    if (nExcludeMtime == m_nExcludeMtime) return;
+
+    m_nExcludeMtime = nExcludeMtime;
+    clear();
+}
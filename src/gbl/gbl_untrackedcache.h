@@ -0,0 +1,58 @@
+#ifndef GBL_UNTRACKEDCACHE_H
+#define GBL_UNTRACKEDCACHE_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#define GBL_UNTRACKED_CACHE_MAGIC "GBLU"
+#define GBL_UNTRACKED_CACHE_VERSION 1
+
+// a directory changed this close to a scan may change again within the same
+// timestamp, so it is listed again next time
+#define GBL_UNTRACKED_CACHE_RACY_MSECS 2000
+
+/**
+ * @brief The GBL_Untracked_Dir struct
+ * what one directory held when it was last listed. The listing stands for as
+ * long as the directory, its .gitignore and its index entries don't change.
+ * mtime is -1 when the listing can't be trusted.
+ */
+typedef struct GBL_Untracked_Dir {
+    qint64 mtime;
+    qint64 ignore_mtime;
+    uint index_hash;
+    QStringList subdirs;
+    QStringList untracked;
+} GBL_Untracked_Dir;
+
+/**
+ * @brief The GBL_UntrackedCache class
+ * the untracked files and walked subdirectories of every directory of a
+ * working tree, so a status only lists the directories that changed. The
+ * whole cache is dropped when .git/info/exclude changes.
+ */
+class GBL_UntrackedCache
+{
+public:
+    GBL_UntrackedCache();
+
+    void clear();
+    bool load(const QString &sFile, qint64 nExcludeMtime);
+    bool save(const QString &sFile) const;
+
+    bool isEmpty() const { return m_dirs.isEmpty(); }
+    bool isModified() const { return m_bModified; }
+    const GBL_Untracked_Dir* find(const QString &sDir) const;
+    void insert(const QString &sDir, const GBL_Untracked_Dir &dir);
+    void prune(const QSet<QString> &dirs);
+    void setExcludeMtime(qint64 nExcludeMtime);
+
+private:
+    QHash<QString, GBL_Untracked_Dir> m_dirs;
+    qint64 m_nExcludeMtime;
+    bool m_bModified;
+};
+
+#endif // GBL_UNTRACKEDCACHE_H
@@ -48,7 +48,7 @@ void CommitDock::setDetails(GBL_History_Item *pHistItem, QPixmap *pAvatar)
     pMod->setHistoryItem(pHistItem);
 }
 
-void CommitDock::setFileArray(GBL_File_Array *pArr)
+void CommitDock::setFileArray(GBL_FileList *pArr)
 {
     CommitFileView  *pView = m_pFilesSA->getFileView();
     GBL_FileModel *pMod = (GBL_FileModel*)pView->model();
@@ -59,7 +59,6 @@ CommitDetail::CommitDetail(QWidget *parent) : QFrame(parent)
 {
     //resize(400,200)
     setFrameStyle(QFrame::StyledPanel);
-    m_pHistItem = NULL;
     QGridLayout *mainLayout = new QGridLayout(this);
     m_pAvatar = new QLabel(this);
     m_pDetails = new QTextEdit(this);
@@ -86,28 +85,26 @@ void CommitDetail::reset()
 
 void CommitDetail::setDetails(GBL_History_Item *pHistItem, QPixmap *pAvatar)
 {
-    m_pHistItem = pHistItem;
-
-    QString sEmail = m_pHistItem->hist_author_email;
+    QString sEmail = pHistItem->hist_author_email;
     //QString sUrl = GBL_Storage::getGravatarUrl(sEmail);
     QString sHtml("<table cellpadding=\'2\'><tr><td><i>Commit:</i></td><td>");
-    sHtml += m_pHistItem->hist_oid;
+    sHtml += pHistItem->hist_oid;
     sHtml += "</td></tr><tr><td><i>Parents:</i></td><td>";
-    int nParentCount = m_pHistItem->hist_parents.size();
+    int nParentCount = pHistItem->hist_parents.size();
     for (int i = 0; i < nParentCount; i++)
     {
-        sHtml += m_pHistItem->hist_parents.at(i).left(7);
+        sHtml += pHistItem->hist_parents.at(i).left(7);
         if (i < (nParentCount-1)) sHtml += ", ";
     }
 
     sHtml += "</td></tr><tr><td><i>Author:</i></td><td>";
-    sHtml += m_pHistItem->hist_author;
+    sHtml += pHistItem->hist_author;
     sHtml += "</td></tr><tr><td><i>Email:</i></td><td>";
-    sHtml += m_pHistItem->hist_author_email;
+    sHtml += pHistItem->hist_author_email;
     sHtml += "</td></tr><tr><td><i>Date:</i></td><td>";
     sHtml += pHistItem->hist_datetime.toString("MM/dd/yyyy hh:mm:ss ap");
     sHtml += "</td></tr><tr><td><i>Message:</i></td><td>";
-    sHtml += m_pHistItem->hist_message;
+    sHtml += pHistItem->hist_message;
     sHtml += "</td></tr>";
     sHtml += "</table>";
     //qDebug() << sHtml;
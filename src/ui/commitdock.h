@@ -35,7 +35,6 @@ signals:
 public slots:
 
 private:
-    GBL_History_Item *m_pHistItem;
     QLabel *m_pAvatar;
     QTextEdit *m_pDetails;
 };
@@ -115,7 +114,7 @@ public:
     void reset();
     CommitFileView* getFileView();
     void setDetails(GBL_History_Item*, QPixmap*);
-    void setFileArray(GBL_File_Array* pArr);
+    void setFileArray(GBL_FileList* pArr);
 
 signals:
 
@@ -2,6 +2,7 @@
 #include "mainwindow.h"
 #include "mdichild.h"
 #include "optionsmenubutton.h"
+#include "diffview.h"
 
 #include <QDebug>
 #include <QTextEdit>
@@ -11,6 +12,7 @@
 #include <QToolButton>
 #include <QToolBar>
 #include <QMenu>
+#include <QPushButton>
 
 ContentView::ContentView(QWidget *parent) : QScrollArea(parent)
 {
@@ -19,6 +21,7 @@ ContentView::ContentView(QWidget *parent) : QScrollArea(parent)
     mainLayout->setMargin(0);
     mainLayout->setSpacing(0);
     m_pContent = new ContentEdit(this);
+    m_pDiffView = new DiffView(this);
 
     int fntSize = 12;
 
@@ -28,9 +31,17 @@ ContentView::ContentView(QWidget *parent) : QScrollArea(parent)
     QFont fnt("Monospace",fntSize);
     fnt.setFixedPitch(true);
     m_pContent->setFont(fnt);
+    m_pDiffView->setFont(fnt);
+    m_pDiffView->hide();
     m_pInfo = new ContentInfoWidget(this);
     mainLayout->addWidget(m_pInfo,0,0);
     mainLayout->addWidget(m_pContent,1,0);
+    mainLayout->addWidget(m_pDiffView,1,0);
+    m_pLoadFullBtn = new QPushButton(tr("Load Full Diff"), this);
+    m_pLoadFullBtn->setToolTip(tr("Large and long lined files are only summarized"));
+    m_pLoadFullBtn->hide();
+    connect(m_pLoadFullBtn, &QPushButton::clicked, this, &ContentView::loadFullDiff);
+    mainLayout->addWidget(m_pLoadFullBtn,2,0);
     mainLayout->setSpacing(0);
     //setFrameStyle(QFrame::StyledPanel);
     mainLayout->setMargin(0);
@@ -42,31 +53,19 @@ ContentView::ContentView(QWidget *parent) : QScrollArea(parent)
 
 ContentView::~ContentView()
 {
-    cleanupContentArray();
 }
 
 void ContentView::reset()
 {
     m_pContent->clear();
+    m_pDiffView->reset();
+    m_pLoadFullBtn->hide();
     m_pInfo->reset();
-    cleanupContentArray();
+    m_diffBuffer.clear();
     //setHtml("<table cellpadding=\'5\' cellspacing=\'0\'><tr><td></td><td></td><td></td><td></td></tr></table>");
     //qDebug() << "reset" << toHtml();
 }
 
-void ContentView::cleanupContentArray()
-{
-    if (!m_Content_arr.isEmpty())
-    {
-        for (int i = 0; i < m_Content_arr.size(); i++)
-        {
-            GBL_Line_Item *pLI = (GBL_Line_Item*)m_Content_arr.at(i);
-            delete pLI;
-        }
-        m_Content_arr.clear();
-    }
-}
-
 void ContentView::setMargins(int marg)
 {
     /*QMargins m(marg,marg,marg,marg);
@@ -76,96 +75,35 @@ void ContentView::setMargins(int marg)
     m_pContent->setStyleSheet(sStyle);
 }
 
-void ContentView::addLine(GBL_Line_Item *pLI)
-{
-    GBL_Line_Item *pLineItem = new GBL_Line_Item;
-    pLineItem->content = pLI->content;
-    pLineItem->line_change_type = pLI->line_change_type;
-    pLineItem->new_line_num = pLI->new_line_num;
-    pLineItem->old_line_num = pLI->old_line_num;
-    m_Content_arr.append(pLineItem);
-}
-
-void ContentView::setDiffFromLines(GBL_File_Item *pFileItem)
+/**
+ * @brief ContentView::setDiff
+ * shows a diff, only the visible lines are painted
+ * @param diffBuffer shared with the caller, its text isn't copied
+ * @param bContinued true if diffBuffer carries on the diff already shown,
+ * which then keeps its scroll position
+ */
+void ContentView::setDiff(const GBL_DiffBuffer &diffBuffer, bool bContinued)
 {
-    m_pInfo->setFileItem(pFileItem);
-    QString num;
-    QString htmlContent;
-
-    QColor txtClr = palette().color(QPalette::Text);
-    QColor bckClr = palette().color(QPalette::Window);
-    QString lineNumBgClr = bckClr.darker(115).name(QColor::HexArgb);
-    //qDebug() << "text color lightness:" << txtClr.lightness();
-    //qDebug() << "back color lightness:" << bckClr.lightness();
-    int nBCLight = bckClr.lightness();
-
-    QString lineStyle("border-right:1px solid ");
-    lineStyle += txtClr.name(QColor::HexRgb);
-    //qDebug() << lineStyle;
-    QString darkAddStyle("color:#ccc;background-color:#353");
-    QString darkDelStyle("color:#ccc;background-color:#533");
-    QString lightAddStyle("color:#333;background-color:#D4EACD");
-    QString lightDelStyle("color:#333;background-color:#F0D6D6");
-    QString addStyle = nBCLight > 150 ? lightAddStyle : darkAddStyle;
-    QString delStyle = nBCLight > 150 ? lightDelStyle : darkDelStyle;
-    QString sBackClrAttr;
-    QTextStream(&sBackClrAttr) << "bgcolor=\'" << lineNumBgClr << "\'";
-
-    QString sHtml("<html><body style=\'margin:0;padding:0;\'><table cellpadding=\'2\' cellspacing=\'0\' >");
-    for (int i = 0; i < m_Content_arr.size(); i++)
+    m_diffBuffer = diffBuffer;
+    m_pContent->hide();
+    m_pLoadFullBtn->setVisible(m_diffBuffer.isLimited());
+    if (bContinued)
     {
-        GBL_Line_Item *pLI = dynamic_cast<GBL_Line_Item*>(m_Content_arr.at(i));
-        htmlContent = pLI->content.toHtmlEscaped();
-        sHtml += "<tr>";
-        sHtml += "<td ";
-        sHtml += sBackClrAttr;
-        sHtml +=" align=\'right\'>";
-        if (pLI->old_line_num > 0) sHtml += num.setNum(pLI->old_line_num);
-        sHtml += "</td>";
-        sHtml += "<td ";
-        sHtml += sBackClrAttr;
-        sHtml +=" align=\'right\'>";
-        if (pLI->new_line_num > 0) sHtml += num.setNum(pLI->new_line_num);
-        sHtml += "</td>";
-        if (pLI->line_change_type == GIT_DIFF_LINE_ADDITION || pLI->line_change_type == GIT_DIFF_LINE_DELETION)
-        {
-            QString style = pLI->line_change_type == GIT_DIFF_LINE_ADDITION ? addStyle : delStyle;
-            sHtml += "<td style=\'";
-            sHtml += style;
-            sHtml += ";width:50px;";
-            sHtml += "\'>";
-            sHtml += pLI->line_change_type;
-            sHtml += "</td>";
-            sHtml += "<td style=\'";
-            sHtml += style;
-            sHtml += "\'><pre>";
-            sHtml += htmlContent;
-            sHtml += "</pre></td>";
-        }
-        else {
-            bool bHeader = pLI->line_change_type == GIT_DIFF_LINE_FILE_HDR || pLI->line_change_type == GIT_DIFF_LINE_HUNK_HDR;
-            QString sAttr = bHeader ? sBackClrAttr : "";
-            sHtml += "<td ";
-            sHtml += sAttr;
-            sHtml += "></td><td ";
-            sHtml += sAttr;
-            sHtml += ">";
-            sHtml += bHeader ? "<i>" : "";
-            sHtml += htmlContent;
-            sHtml += bHeader ? "</i>" : "";
-            sHtml += "</td>";
-        }
-
-        sHtml += "</tr>";
+        m_pDiffView->diffBufferChanged();
+    }
+    else
+    {
+        m_pDiffView->setDiffBuffer(&m_diffBuffer);
     }
-    sHtml += "</table></body></html>";
-    m_pContent->setHtml(sHtml);
-    setMargins(0);
+    m_pDiffView->show();
 }
 
 void ContentView::setContent(QString content)
 {
+    m_pDiffView->hide();
+    m_pLoadFullBtn->hide();
     m_pContent->setPlainText(content);
+    m_pContent->show();
     //setMargins(10);
 }
 
@@ -178,12 +116,14 @@ void ContentView::setContentInfo(GBL_File_Item *pFileItem)
 void ContentView::zoomIn()
 {
     m_pContent->zoomIn();
+    m_pDiffView->zoomIn();
 
 }
 
 void ContentView::zoomOut()
 {
     m_pContent->zoomOut();
+    m_pDiffView->zoomOut();
 }
 
 /**
@@ -6,14 +6,16 @@
 #include <QLabel>
 
 #include "src/gbl/gbl_repository.h"
+#include "src/gbl/gbl_diffbuffer.h"
 
 QT_BEGIN_NAMESPACE
-struct GBL_Line_Item;
 struct GBL_File_Item;
 class QLabel;
 class QTextEdit;
 class UrlPixmap;
 class OptionsMenuButton;
+class DiffView;
+class QPushButton;
 QT_END_NAMESPACE
 
 class ContentInfoTypeLabel : public QLabel
@@ -58,25 +60,25 @@ public:
     ~ContentView();
 
     void reset();
-    void addLine(GBL_Line_Item *pLI);
-    void setDiffFromLines(GBL_File_Item *pFileItem);
+    void setDiff(const GBL_DiffBuffer &diffBuffer, bool bContinued = false);
     void setContent(QString content);
     void setContentInfo(GBL_File_Item *pFileItem);
     void setMargins(int marg);
 
 
 signals:
+    void loadFullDiff();
 
 public slots:
     void zoomIn();
     void zoomOut();
 
 private:
-    void cleanupContentArray();
-
-    GBL_Line_Array m_Content_arr;
+    GBL_DiffBuffer m_diffBuffer;
     ContentInfoWidget *m_pInfo;
     ContentEdit *m_pContent;
+    DiffView *m_pDiffView;
+    QPushButton *m_pLoadFullBtn;
 };
 
 #endif // CONTENTVIEW_H
@@ -0,0 +1,334 @@
+#include "diffview.h"
+#include "src/gbl/gbl_diffbuffer.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QApplication>
+#include <QClipboard>
+#include <git2.h>
+
+DiffView::DiffView(QWidget *parent) : QAbstractScrollArea(parent)
+{
+    m_pBuffer = Q_NULLPTR;
+    m_nNumWidth = 0;
+    m_nGutterWidth = 0;
+    m_nSelAnchor = -1;
+    m_nSelEnd = -1;
+
+    setFrameStyle(QFrame::NoFrame);
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+}
+
+DiffView::~DiffView()
+{
+
+}
+
+/**
+ * @brief DiffView::setDiffBuffer
+ * @param pBuffer lines to show, not owned and has to outlive the view or
+ * the next call
+ */
+void DiffView::setDiffBuffer(const GBL_DiffBuffer *pBuffer)
+{
+    m_pBuffer = pBuffer;
+    m_nSelAnchor = -1;
+    m_nSelEnd = -1;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateScrollBars();
+    viewport()->update();
+}
+
+/**
+ * @brief DiffView::diffBufferChanged
+ * the buffer got more lines, the scroll position and selection are kept
+ */
+void DiffView::diffBufferChanged()
+{
+    updateScrollBars();
+    viewport()->update();
+}
+
+void DiffView::reset()
+{
+    setDiffBuffer(Q_NULLPTR);
+}
+
+void DiffView::zoomIn()
+{
+    QFont fnt = font();
+    fnt.setPointSize(fnt.pointSize() + 1);
+    setFont(fnt);
+}
+
+void DiffView::zoomOut()
+{
+    QFont fnt = font();
+    if (fnt.pointSize() <= 1) return;
+
+    fnt.setPointSize(fnt.pointSize() - 1);
+    setFont(fnt);
+}
+
+/**
+ * @brief DiffView::copy
+ * puts the text of the selected lines on the clipboard
+ */
+void DiffView::copy()
+{
+    if (!m_pBuffer || m_nSelAnchor < 0) return;
+
+    int nFirst = qMin(m_nSelAnchor, m_nSelEnd);
+    int nLast = qMax(m_nSelAnchor, m_nSelEnd);
+    QString sText;
+    for (int i = nFirst; i <= nLast; i++)
+    {
+        sText += m_pBuffer->lineText(i);
+        sText += '\n';
+    }
+
+    QApplication::clipboard()->setText(sText);
+}
+
+void DiffView::selectAll()
+{
+    if (!m_pBuffer || m_pBuffer->isEmpty()) return;
+
+    m_nSelAnchor = 0;
+    m_nSelEnd = m_pBuffer->lineCount() - 1;
+    viewport()->update();
+}
+
+/**
+ * @brief DiffView::updateScrollBars
+ * sizes the gutter for the largest line number and the scroll ranges for
+ * the line count and the longest line
+ */
+void DiffView::updateScrollBars()
+{
+    QFontMetrics fm = fontMetrics();
+    int nLineHeight = fm.height();
+    int nCharWidth = fm.width(QLatin1Char('9'));
+    int nLines = m_pBuffer ? m_pBuffer->lineCount() : 0;
+    int nMaxLength = m_pBuffer ? m_pBuffer->maxLineLength() : 0;
+
+    int nDigits = 1;
+    for (int n = m_pBuffer ? m_pBuffer->maxLineNumber() : 0; n >= 10; n /= 10) nDigits++;
+    m_nNumWidth = nDigits * nCharWidth + 2 * DIFFVIEW_PADDING;
+    m_nGutterWidth = 2 * m_nNumWidth + 1;
+
+    int nVisible = qMax(1, viewport()->height() / nLineHeight);
+    verticalScrollBar()->setRange(0, qMax(0, nLines - nVisible));
+    verticalScrollBar()->setPageStep(nVisible);
+    verticalScrollBar()->setSingleStep(1);
+
+    // the origin column plus the longest line, tabs counted as one character
+    int nTextWidth = (nMaxLength + 2) * nCharWidth + 2 * DIFFVIEW_PADDING;
+    int nTextView = viewport()->width() - m_nGutterWidth;
+    horizontalScrollBar()->setRange(0, qMax(0, nTextWidth - nTextView));
+    horizontalScrollBar()->setPageStep(qMax(1, nTextView));
+    horizontalScrollBar()->setSingleStep(nCharWidth);
+}
+
+/**
+ * @brief DiffView::lineAt
+ * @param y viewport position
+ * @return the line at y, clamped to the lines there are
+ */
+int DiffView::lineAt(int y) const
+{
+    if (!m_pBuffer || m_pBuffer->isEmpty()) return -1;
+
+    int nLine = verticalScrollBar()->value() + qMax(0, y) / fontMetrics().height();
+
+    return qMin(nLine, m_pBuffer->lineCount() - 1);
+}
+
+/**
+ * @brief DiffView::displayText
+ * @param nLine
+ * @return the text of a line with its tabs expanded
+ */
+QString DiffView::displayText(int nLine) const
+{
+    QString sText = m_pBuffer->lineText(nLine);
+    if (!sText.contains('\t')) return sText;
+
+    QString sExpanded;
+    sExpanded.reserve(sText.size() + DIFFVIEW_TAB_WIDTH * 4);
+    for (int i = 0; i < sText.size(); i++)
+    {
+        if (sText.at(i) == '\t')
+        {
+            sExpanded += QString(DIFFVIEW_TAB_WIDTH - sExpanded.size() % DIFFVIEW_TAB_WIDTH, ' ');
+        }
+        else
+        {
+            sExpanded += sText.at(i);
+        }
+    }
+
+    return sExpanded;
+}
+
+/**
+ * @brief DiffView::paintEvent
+ * draws only the lines that intersect the exposed rectangle
+ * @param event
+ */
+void DiffView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    QRect rcExposed = event->rect();
+    painter.fillRect(rcExposed, palette().color(QPalette::Base));
+
+    if (!m_pBuffer || m_pBuffer->isEmpty()) return;
+
+    QFontMetrics fm = fontMetrics();
+    int nLineHeight = fm.height();
+    int nCharWidth = fm.width(QLatin1Char('9'));
+    int nWidth = viewport()->width();
+
+    QColor txtClr = palette().color(QPalette::Text);
+    QColor bckClr = palette().color(QPalette::Window);
+    QColor lineNumBgClr = bckClr.darker(115);
+    bool bLight = bckClr.lightness() > 150;
+    QColor addBgClr = bLight ? QColor("#D4EACD") : QColor("#335533");
+    QColor delBgClr = bLight ? QColor("#F0D6D6") : QColor("#553333");
+    QColor changeTxtClr = bLight ? QColor("#333333") : QColor("#cccccc");
+
+    QFont fnt = font();
+    QFont hdrFnt = fnt;
+    hdrFnt.setItalic(true);
+
+    int nFirst = verticalScrollBar()->value() + rcExposed.top() / nLineHeight;
+    int nLast = qMin(verticalScrollBar()->value() + rcExposed.bottom() / nLineHeight, m_pBuffer->lineCount() - 1);
+    int nSelFirst = qMin(m_nSelAnchor, m_nSelEnd);
+    int nSelLast = qMax(m_nSelAnchor, m_nSelEnd);
+    int nTextX = m_nGutterWidth + DIFFVIEW_PADDING - horizontalScrollBar()->value();
+    QRect rcText(m_nGutterWidth, 0, qMax(0, nWidth - m_nGutterWidth), viewport()->height());
+
+    for (int i = nFirst; i <= nLast; i++)
+    {
+        const GBL_Diff_Line &line = m_pBuffer->lineAt(i);
+        int y = (i - verticalScrollBar()->value()) * nLineHeight;
+        bool bChange = line.origin == GIT_DIFF_LINE_ADDITION || line.origin == GIT_DIFF_LINE_DELETION;
+        bool bHeader = line.origin == GIT_DIFF_LINE_FILE_HDR || line.origin == GIT_DIFF_LINE_HUNK_HDR;
+        bool bSelected = m_nSelAnchor >= 0 && i >= nSelFirst && i <= nSelLast;
+
+        painter.fillRect(0, y, m_nGutterWidth, nLineHeight, lineNumBgClr);
+        if (bSelected)
+        {
+            painter.fillRect(m_nGutterWidth, y, nWidth - m_nGutterWidth, nLineHeight, palette().color(QPalette::Highlight));
+        }
+        else if (bChange)
+        {
+            painter.fillRect(m_nGutterWidth, y, nWidth - m_nGutterWidth, nLineHeight, line.origin == GIT_DIFF_LINE_ADDITION ? addBgClr : delBgClr);
+        }
+        else if (bHeader)
+        {
+            painter.fillRect(m_nGutterWidth, y, nWidth - m_nGutterWidth, nLineHeight, lineNumBgClr);
+        }
+
+        painter.setFont(fnt);
+        painter.setPen(txtClr);
+        if (line.old_line_num > 0)
+        {
+            painter.drawText(QRect(0, y, m_nNumWidth - DIFFVIEW_PADDING, nLineHeight), Qt::AlignRight | Qt::AlignVCenter, QString::number(line.old_line_num));
+        }
+        if (line.new_line_num > 0)
+        {
+            painter.drawText(QRect(m_nNumWidth, y, m_nNumWidth - DIFFVIEW_PADDING, nLineHeight), Qt::AlignRight | Qt::AlignVCenter, QString::number(line.new_line_num));
+        }
+
+        painter.save();
+        painter.setClipRect(rcText);
+        if (bSelected) painter.setPen(palette().color(QPalette::HighlightedText));
+        else if (bChange) painter.setPen(changeTxtClr);
+        if (bHeader) painter.setFont(hdrFnt);
+
+        int x = nTextX;
+        if (bChange)
+        {
+            painter.drawText(QRect(x, y, nCharWidth, nLineHeight), Qt::AlignLeft | Qt::AlignVCenter, QString(QLatin1Char(line.origin)));
+        }
+        x += 2 * nCharWidth;
+        painter.drawText(QRect(x, y, nWidth - x, nLineHeight), Qt::AlignLeft | Qt::AlignVCenter | Qt::TextSingleLine, displayText(i));
+        painter.restore();
+    }
+
+    painter.setPen(txtClr);
+    painter.drawLine(m_nGutterWidth - 1, rcExposed.top(), m_nGutterWidth - 1, rcExposed.bottom());
+}
+
+void DiffView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void DiffView::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+
+    if (event->type() == QEvent::FontChange)
+    {
+        updateScrollBars();
+        viewport()->update();
+    }
+}
+
+void DiffView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Copy))
+    {
+        copy();
+    }
+    else if (event->matches(QKeySequence::SelectAll))
+    {
+        selectAll();
+    }
+    else
+    {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void DiffView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) return;
+
+    int nLine = lineAt(event->pos().y());
+    if (event->modifiers() & Qt::ShiftModifier && m_nSelAnchor >= 0)
+    {
+        m_nSelEnd = nLine;
+    }
+    else
+    {
+        m_nSelAnchor = nLine;
+        m_nSelEnd = nLine;
+    }
+
+    viewport()->update();
+}
+
+void DiffView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || m_nSelAnchor < 0) return;
+
+    int y = event->pos().y();
+    if (y < 0) verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    else if (y > viewport()->height()) verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+
+    int nLine = lineAt(qMin(y, viewport()->height() - 1));
+    if (nLine != m_nSelEnd)
+    {
+        m_nSelEnd = nLine;
+        viewport()->update();
+    }
+}
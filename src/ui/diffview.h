@@ -0,0 +1,54 @@
+#ifndef DIFFVIEW_H
+#define DIFFVIEW_H
+
+#include <QAbstractScrollArea>
+
+#define DIFFVIEW_TAB_WIDTH      4
+#define DIFFVIEW_PADDING        4
+
+class GBL_DiffBuffer;
+
+/**
+ * @brief The DiffView class
+ * paints the visible lines of a diff straight from a GBL_DiffBuffer. The
+ * vertical scroll bar counts lines, so scrolling and painting only depend
+ * on the height of the view, not the size of the diff.
+ */
+class DiffView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit DiffView(QWidget *parent = Q_NULLPTR);
+    ~DiffView();
+
+    void setDiffBuffer(const GBL_DiffBuffer *pBuffer);
+    void diffBufferChanged();
+    void reset();
+
+public slots:
+    void zoomIn();
+    void zoomOut();
+    void copy();
+    void selectAll();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    void updateScrollBars();
+    int lineAt(int y) const;
+    QString displayText(int nLine) const;
+
+    const GBL_DiffBuffer *m_pBuffer;
+    int m_nNumWidth;
+    int m_nGutterWidth;
+    int m_nSelAnchor;
+    int m_nSelEnd;
+};
+
+#endif // DIFFVIEW_H
@@ -1,5 +1,6 @@
 #include "historyview.h"
 #include "src/gbl/gbl_historymodel.h"
+#include "src/gbl/gbl_graphlayout.h"
 #include "mainwindow.h"
 
 #include <QDebug>
@@ -10,6 +11,8 @@
 #include <QPalette>
 #include <QtMath>
 #include <QHeaderView>
+#include <QApplication>
+#include <QPixmapCache>
 
 HistoryView::HistoryView(QWidget *parent) : QTableView(parent)
 {
@@ -26,6 +29,7 @@ HistoryView::HistoryView(QWidget *parent) : QTableView(parent)
     setWordWrap(false);
 
     connect(horizontalHeader(), &QHeaderView::sectionResized,this, &HistoryView::headerResized);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &HistoryView::prefetchVisibleRows);
 
 }
 
@@ -34,14 +38,6 @@ HistoryView::~HistoryView()
 
 }
 
-void HistoryView::reset()
-{
-    QTableView::reset();
-    GBL_HistoryModel *pModel = dynamic_cast<GBL_HistoryModel*>(model());
-    pModel->reset();
-
-}
-
 void HistoryView::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
@@ -65,6 +61,8 @@ void HistoryView::resizeEvent(QResizeEvent *event)
         m_bPreAutoSizeHdr = false;
 
     }
+
+    prefetchVisibleRows();
 }
 
 void HistoryView::mousePressEvent(QMouseEvent *event)
@@ -109,6 +107,32 @@ void HistoryView::contextMenuEvent(QContextMenuEvent *event)
     }
 }*/
 
+void HistoryView::rowsInserted(const QModelIndex &parent, int start, int end)
+{
+    QTableView::rowsInserted(parent, start, end);
+
+    prefetchVisibleRows();
+}
+
+/**
+ * @brief HistoryView::prefetchVisibleRows
+ * has the model format the rows on screen and a screen above and below,
+ * so scrolling a page either way paints from its caches
+ */
+void HistoryView::prefetchVisibleRows()
+{
+    GBL_HistoryModel *pModel = dynamic_cast<GBL_HistoryModel*>(model());
+    if (!pModel || !pModel->rowCount()) return;
+
+    int nFirst = rowAt(0);
+    if (nFirst < 0) nFirst = 0;
+    int nLast = rowAt(viewport()->height() - 1);
+    if (nLast < 0) nLast = pModel->rowCount() - 1;
+
+    int nPage = nLast - nFirst + 1;
+    pModel->prefetchRows(nFirst - nPage, nLast + nPage);
+}
+
 void HistoryView::headerResized()
 {
     if (!m_bPreAutoSizeHdr)
@@ -125,105 +149,124 @@ HistorySelectionModel::HistorySelectionModel(QAbstractItemModel *model, QObject
 
 HistoryDelegate::HistoryDelegate(QObject *parent) : QStyledItemDelegate(parent)
 {
-    m_graphColors << QColor(50,50,200/*, 225*/) << QColor(50,200,50/*,200*/) << QColor(200,50,50/*,200*/);
+    m_graphColors << QColor(50,50,200) << QColor(50,200,50) << QColor(200,50,50) << QColor(200,150,30)
+                  << QColor(150,50,200) << QColor(30,170,190) << QColor(200,70,150) << QColor(120,120,120);
 }
 
+/**
+ * @brief HistoryDelegate::paint
+ * draws one row of the commit graph from the lanes laid out on the history thread.
+ * rows with the same lanes look the same, so each lane signature is rendered once
+ * and kept in the pixmap cache.
+ * @param painter
+ * @param option
+ * @param index
+ */
 void HistoryDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
-    //QStyledItemDelegate::paint(painter, option, index);
-    painter->setRenderHint(QPainter::Antialiasing, true);
-    if (index.column() == 0)
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+    const QWidget *pWidget = opt.widget;
+    QStyle *pStyle = pWidget ? pWidget->style() : QApplication::style();
+    pStyle->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, pWidget);
+
+    const GBL_HistoryModel *pModel = qobject_cast<const GBL_HistoryModel*>(index.model());
+    if (!pModel) return;
+
+    const GBL_CommitStore *pStore = pModel->getCommitStore();
+    int nRow = index.row();
+    if (nRow >= pStore->graphRowCount()) return;
+
+    QRect rct = opt.rect;
+    qreal dpr = painter->device()->devicePixelRatioF();
+
+    QString sKey = QString("gbl_graph:%1:%2:%3:%4").arg(rct.width()).arg(rct.height()).arg(dpr).arg(pStore->graphNode(nRow));
+    const quint32 *pSegs = pStore->graphSegments(nRow);
+    int nSegs = pStore->graphSegmentCount(nRow);
+    for (int i = 0; i < nSegs; i++)
     {
-        HistoryView *pView = dynamic_cast<HistoryView*>(parent());
-        //int nRow = index.row();
-        QStyle *pStyle = pView->style();
-        QSize szCir(7,7);
-        int nLineIndent = 14, nLineSpacing = 10;
-        QRect rct = option.rect;
-        QPalette pal = option.palette;
-
-        //painter->fillRect(rct,pal.base());
-        QItemSelectionModel *pSelMod = pView->selectionModel();
-
-        int nRowCnt = pView->model()->rowCount();
-        QRect rowRct = rct;
-
-        QPolygon line;
-        for (int i = 0; i < nRowCnt; i++)
-        {
-            int nRowHt = pView->rowHeight(i);
-            //qDebug() << "rowHt:" << nRowHt;
-            rowRct.setHeight(nRowHt);
-            /*pal.setCurrentColorGroup(QPalette::Normal);
-            QBrush rowBr = i % 2 ? pal.alternateBase() : pal.window();
-
-            if (pSelMod->isRowSelected(i, QModelIndex()))
-            {
-                //painter->fillRect(rowRct, pal.highlight());
-                rowBr = pal.highlight();
-            }
-            painter->fillRect(rowRct, rowBr);*/
-            QStyleOptionViewItem newOpt = option;
-            newOpt.index = pView->model()->index(i,1);
-            if (i % 2)
-                newOpt.features |= QStyleOptionViewItem::Alternate;
-            else
-                newOpt.features &= ~QStyleOptionViewItem::Alternate;
-            //newOpt.state = QStyle::State_Enabled;
-            if (pSelMod->isRowSelected(i, QModelIndex()))
-                newOpt.state |= QStyle::State_Selected;
-            else
-                newOpt.state &= ~QStyle::State_Selected;
-
-            QPalette::ColorGroup cg = QPalette::Normal;
-            newOpt.rect = rowRct;
-            newOpt.palette.setCurrentColorGroup(cg);
-            pView->style()->drawPrimitive(QStyle::PE_PanelItemViewRow,&newOpt, painter, pView);
-            pView->style()->drawPrimitive(QStyle::PE_PanelItemViewItem,&newOpt, painter, pView);
-
-            //qDebug() << "rowRct" << rowRct;
-
-            painter->setBrush(m_graphColors[0]);
-            painter->setPen(m_graphColors[0]);
-            QRect cirRct(rowRct.left()+nLineIndent - szCir.width()/2,rowRct.top()+rowRct.height()/2-szCir.height()/2, szCir.width(),szCir.height());
-            line << QPoint(rowRct.left()+nLineIndent,rowRct.top()+rowRct.height()/2);
-            painter->drawEllipse(cirRct);
-
-            rowRct.setTop(rowRct.top()+nRowHt);
-        }
-        painter->drawPolyline(line);
-        //painter->drawEllipse(rct);
+        sKey += QLatin1Char(':');
+        sKey += QString::number(pSegs[i], 16);
+    }
+
+    QPixmap pix;
+    if (!QPixmapCache::find(sKey, &pix))
+    {
+        pix = renderGraphRow(pStore, nRow, rct.size(), dpr);
+        QPixmapCache::insert(sKey, pix);
+    }
 
-            /*QPen pen(m_graphColors[0]);
-            pen.setWidth(3);
-            painter->setPen(pen);
-            painter->drawLine(rct.left() + nLineIndent, rct.top()+rct.height()/2,rct.left()+nLineIndent,rct.bottom());
+    painter->drawPixmap(rct.topLeft(), pix);
+}
 
-            QRect cirRct(rct.left()+nLineIndent-szCir.width()/2,rct.top()+rct.height()/2-szCir.height()/2,szCir.width(),szCir.height());
-            painter->setBrush(QBrush(m_graphColors[0]));
-            painter->drawEllipse(cirRct);
-            */
+/**
+ * @brief HistoryDelegate::renderGraphRow
+ * @param pStore
+ * @param row
+ * @param szCell
+ * @param dpr device pixel ratio of the view
+ * @return the lines and node of row drawn on a transparent pixmap the size of the cell
+ */
+QPixmap HistoryDelegate::renderGraphRow(const GBL_CommitStore *pStore, int row, const QSize &szCell, qreal dpr) const
+{
+    QPixmap pix(szCell * dpr);
+    pix.setDevicePixelRatio(dpr);
+    pix.fill(Qt::transparent);
+
+    QSize szCir(7,7);
+    int nLineIndent = 14, nLineSpacing = 10;
+    int nLeft = nLineIndent;
+    int nTop = 0;
+    int nBottom = szCell.height();
+    int nMid = szCell.height()/2;
+
+    QPainter painter(&pix);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    QPen pen;
+    pen.setWidth(2);
+
+    const quint32 *pSegs = pStore->graphSegments(row);
+    int nSegs = pStore->graphSegmentCount(row);
+    for (int i = 0; i < nSegs; i++)
+    {
+        quint32 seg = pSegs[i];
+        int nFrom = gbl_graph_segment_from(seg);
+        int nTo = gbl_graph_segment_to(seg);
 
-        //painter->drawLine(rct.left() + nLineIndent,rct.top(),rct.left() + nLineIndent,rct.bottom());
-        /*if (index.row() % 2 == 0)
+        switch (gbl_graph_segment_type(seg))
         {
-            QRect cirRct(rct.left()+nLineIndent-szCir.width()/2,rct.top()+rct.height()/2-szCir.height()/2,szCir.width(),szCir.height());
-            painter->setBrush(QBrush(QColor(active_color)));
-            //painter->setPen(Qt::NoPen);
-            painter->drawEllipse(cirRct);
+            case GBL_GRAPH_SEG_PASS:
+                for (int nLane = nFrom; nLane <= nTo; nLane++)
+                {
+                    int x = nLeft + nLane * nLineSpacing;
+                    if (x > szCell.width()) break;
+                    pen.setColor(m_graphColors.at(nLane % m_graphColors.size()));
+                    painter.setPen(pen);
+                    painter.drawLine(x, nTop, x, nBottom);
+                }
+                break;
+
+            case GBL_GRAPH_SEG_IN:
+                pen.setColor(m_graphColors.at(nFrom % m_graphColors.size()));
+                painter.setPen(pen);
+                painter.drawLine(nLeft + nFrom * nLineSpacing, nTop, nLeft + nTo * nLineSpacing, nMid);
+                break;
+
+            case GBL_GRAPH_SEG_OUT:
+                pen.setColor(m_graphColors.at(nTo % m_graphColors.size()));
+                painter.setPen(pen);
+                painter.drawLine(nLeft + nFrom * nLineSpacing, nMid, nLeft + nTo * nLineSpacing, nBottom);
+                break;
         }
+    }
 
-        QPen pen2(second_color);
-        pen.setWidth(2);
-        painter->setPen(pen2);
-        //painter->drawLine(rct.left() + nLineIndent+nLineSpacing,rct.top(),rct.left() + nLineIndent+nLineSpacing,rct.bottom());
+    int nNode = pStore->graphNode(row);
+    const QColor &nodeClr = m_graphColors.at(nNode % m_graphColors.size());
+    painter.setBrush(nodeClr);
+    painter.setPen(nodeClr);
+    QRect cirRct(nLeft + nNode * nLineSpacing - szCir.width()/2, nMid - szCir.height()/2, szCir.width(), szCir.height());
+    painter.drawEllipse(cirRct);
 
-        if (index.row() % 2 != 0)
-        {
-            QRect cirRct2(rct.left()+nLineIndent+nLineSpacing-szCir.width()/2,rct.top()+rct.height()/2-szCir.height()/2,szCir.width(),szCir.height());
-            painter->setBrush(QBrush(QColor(second_color)));
-            //painter->setPen(Qt::NoPen);
-            painter->drawEllipse(cirRct2);
-        }*/
-    }
+    return pix;
 }
@@ -5,6 +5,9 @@
 #include <QItemSelectionModel>
 #include <QStyledItemDelegate>
 #include <QColor>
+#include <QPixmap>
+
+class GBL_CommitStore;
 
 QT_BEGIN_NAMESPACE
 class QMenu;
@@ -18,8 +21,6 @@ public:
     explicit HistoryView(QWidget *parent = Q_NULLPTR);
     ~HistoryView();
 
-    void reset();
-
 
 private slots:
     virtual void resizeEvent(QResizeEvent *event);
@@ -29,6 +30,10 @@ private slots:
     virtual void contextMenuEvent(QContextMenuEvent *event);
     //virtual void selectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
     void headerResized();
+    void prefetchVisibleRows();
+
+protected slots:
+    virtual void rowsInserted(const QModelIndex &parent, int start, int end) override;
 
 private:
     QMenu* m_pContextMenu;
@@ -57,6 +62,8 @@ public:
                const QModelIndex &index) const override;
 
 private:
+    QPixmap renderGraphRow(const GBL_CommitStore *pStore, int row, const QSize &szCell, qreal dpr) const;
+
     QVector<QColor> m_graphColors;
 
 };
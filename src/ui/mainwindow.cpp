@@ -15,6 +15,8 @@
 #include "scandialog.h"
 #include "src/gbl/gbl_storage.h"
 #include "src/gbl/gbl_threads.h"
+#include "src/gbl/gbl_diffcache.h"
+#include "src/gbl/gbl_trigramindex.h"
 #include "commitdock.h"
 #include "bookmarksdock.h"
 #include "prefsdialog.h"
@@ -61,6 +63,15 @@ MainWindow::MainWindow()
     m_nAutoFetchInterval = 10;
     m_bAutoFetch = true;
     m_pCurrentChild = Q_NULLPTR;
+    m_pDiffChild = Q_NULLPTR;
+    m_nDiffGeneration = 0;
+    m_bDiffShown = false;
+    m_nDiffType = GBL_DIFF_TYPE_COMMIT;
+    m_diffLimits.max_bytes = GBL_DIFF_MAX_BYTES;
+    m_diffLimits.max_lines = GBL_DIFF_MAX_LINES;
+    m_diffLimits.max_line_length = GBL_DIFF_MAX_LINE_LENGTH;
+    m_pFilesChild = Q_NULLPTR;
+    m_nFilesGeneration = 0;
     m_pStorage = new GBL_Storage();
 
     m_nCommitTabID = COMMIT_DIFF_TAB_ID;
@@ -312,7 +323,7 @@ void MainWindow::setupRepoUI(QString repoDir)
 
 }
 
-void MainWindow::statusUpdated(GBL_String *psError, GBL_File_Array *pStagedArr, GBL_File_Array *pUnstagedArr)
+void MainWindow::statusUpdated(GBL_String *psError, GBL_FileList *pStagedArr, GBL_FileList *pUnstagedArr)
 {
     if (psError->isEmpty())
     {
@@ -320,12 +331,11 @@ void MainWindow::statusUpdated(GBL_String *psError, GBL_File_Array *pStagedArr,
         StagedDockView *pView = dynamic_cast<StagedDockView*>(pDock->widget());
         pDock = m_docks["unstaged"];
         UnstagedDockView *pUSView = dynamic_cast<UnstagedDockView*>(pDock->widget());
-        pView->reset();
-        pUSView->reset();
+        // only the rows that changed are touched, selections stay
         pView->setFileArray(pStagedArr);
         pUSView->setFileArray(pUnstagedArr);
 
-        if (!pUnstagedArr->empty())
+        if (!pUnstagedArr->isEmpty())
         {
             m_actionMap["stash"]->setDisabled(false);
         }
@@ -347,7 +357,7 @@ void MainWindow::updateStatus()
     {
         pChild->updateStatus();
     }
-    /*GBL_File_Array stagedArr, unstagedArr;
+    /*GBL_FileList stagedArr, unstagedArr;
     QDockWidget *pDock = m_docks["staged"];
     StagedDockView *pView = (StagedDockView*)pDock->widget();
     pDock = m_docks["unstaged"];
@@ -580,9 +590,10 @@ void MainWindow::historyFileSelectionChanged(const QItemSelection &selected, con
         CommitDock *pDock = (CommitDock*)m_docks["history_details"];
         FileView *pView = pDock->getFileView();
         GBL_FileModel *pFileMod = dynamic_cast<GBL_FileModel*>(pView->model());
-        GBL_File_Item *pFileItem = pFileMod->getFileItemFromModelIndex(mi);
-        if (pFileItem)
+        GBL_File_Item fileItem;
+        if (pFileMod->getFileItemFromModelIndex(mi, &fileItem))
         {
+            GBL_File_Item *pFileItem = &fileItem;
             QString path;
             QString sub;
             if (pFileItem->sub_dir != '.')
@@ -591,21 +602,18 @@ void MainWindow::historyFileSelectionChanged(const QItemSelection &selected, con
                 sub += '/';
             }
             QTextStream(&path) << sub << pFileItem->file_name;
-            QByteArray baPath = path.toUtf8();
             GBL_History_Item *pHistItem = pFileMod->getHistoryItem();
             QDockWidget *pDock = m_docks["file_content"];
             ContentView *pCV = (ContentView*)pDock->widget();
             pCV->reset();
+            m_pDiffChild = Q_NULLPTR;
 
             GBL_Repository *pRepo = getCurrentRepository();
             if (pRepo)
             {
                 if (m_nCommitTabID == COMMIT_DIFF_TAB_ID)
                 {
-                    if (pRepo->get_commit_to_parent_diff_lines(pHistItem->hist_oid, this, baPath.data()))
-                    {
-                        pCV->setDiffFromLines(pFileItem);
-                    }
+                    requestDiff(GBL_DIFF_TYPE_COMMIT, pHistItem->hist_oid, QStringList(path), pFileItem);
                 }
                 else if (m_nCommitTabID == COMMiT_ALL_TAB_ID)
                 {
@@ -630,6 +638,7 @@ void MainWindow::workingFileSelectionChanged(const QItemSelection &selected, con
     QDockWidget *pDock = m_docks["file_content"];
     ContentView *pCV = dynamic_cast<ContentView*>(pDock->widget());
     pCV->reset();
+    m_pDiffChild = Q_NULLPTR;
 
     FileView *pFView = m_fileviews["unstaged"];
     QModelIndexList mil = pFView->selectionModel()->selectedRows();
@@ -653,7 +662,8 @@ void MainWindow::workingFileSelectionChanged(const QItemSelection &selected, con
         QString sPath;
         pDock = m_docks["unstaged"];
         UnstagedDockView *pUSView = dynamic_cast<UnstagedDockView*>(pDock->widget());
-        GBL_File_Array *pFileArr = pUSView->getFileArray();
+        GBL_FileList *pFileArr = pUSView->getFileArray();
+        GBL_File_Item fileItem;
         GBL_File_Item *pFileItem = Q_NULLPTR;
 
         QMap<int,int> rowMap;
@@ -664,7 +674,8 @@ void MainWindow::workingFileSelectionChanged(const QItemSelection &selected, con
             if (rowMap.contains(row)) continue;
 
             rowMap[row] = 1;
-            pFileItem = pFileArr->at(row);
+            fileItem = pFileArr->item(row);
+            pFileItem = &fileItem;
             if (pFileItem->sub_dir != ".")
             {
                 sPath += pFileItem->sub_dir;
@@ -682,12 +693,8 @@ void MainWindow::workingFileSelectionChanged(const QItemSelection &selected, con
         if(pDock->isVisible())
         {
 
-            GBL_Repository *pRepo = getCurrentRepository();
-            if (pRepo && pRepo->get_index_to_work_diff(this,&files))
-            {
-                if (mil.size() > 1) { pFileItem = Q_NULLPTR; }
-                pCV->setDiffFromLines(pFileItem);
-            }
+            if (mil.size() > 1) { pFileItem = Q_NULLPTR; }
+            requestDiff(GBL_DIFF_TYPE_WORKDIR, QString(), files, pFileItem);
         }
     }
 }
@@ -700,6 +707,7 @@ void MainWindow::stagedFileSelectionChanged(const QItemSelection &selected, cons
     QDockWidget *pDock = m_docks["file_content"];
     ContentView *pCV = dynamic_cast<ContentView*>(pDock->widget());
     pCV->reset();
+    m_pDiffChild = Q_NULLPTR;
 
     FileView *pFView = m_fileviews["staged"];
     QModelIndexList mil = pFView->selectionModel()->selectedRows();
@@ -717,7 +725,8 @@ void MainWindow::stagedFileSelectionChanged(const QItemSelection &selected, cons
         QString sPath;
         pDock = m_docks["staged"];
         StagedDockView *pSView = dynamic_cast<StagedDockView*>(pDock->widget());
-        GBL_File_Array *pFileArr = pSView->getFileArray();
+        GBL_FileList *pFileArr = pSView->getFileArray();
+        GBL_File_Item fileItem;
         GBL_File_Item *pFileItem = Q_NULLPTR;
 
         QMap<int,int> rowMap;
@@ -728,7 +737,8 @@ void MainWindow::stagedFileSelectionChanged(const QItemSelection &selected, cons
             if (rowMap.contains(row)) continue;
 
             rowMap[row] = 1;
-            pFileItem = pFileArr->at(row);
+            fileItem = pFileArr->item(row);
+            pFileItem = &fileItem;
             if (pFileItem->sub_dir != ".")
             {
                 sPath += pFileItem->sub_dir;
@@ -741,18 +751,89 @@ void MainWindow::stagedFileSelectionChanged(const QItemSelection &selected, cons
             files.append(sPath);
         }
 
-        GBL_Repository *pRepo = getCurrentRepository();
-        if (pRepo)
-        {
-            if (pRepo->get_index_to_head_diff(this, &files))
-            {
-                if (mil.size() > 1) { pFileItem = Q_NULLPTR; }
-                pCV->setDiffFromLines(pFileItem);
-            }
-        }
+        if (mil.size() > 1) { pFileItem = Q_NULLPTR; }
+        requestDiff(GBL_DIFF_TYPE_STAGED, QString(), files, pFileItem);
     }
 }
 
+/**
+ * @brief MainWindow::requestDiff
+ * starts a diff on the current tab's diff thread, the content view gets it
+ * in diffReady
+ * @param nType GBL_DIFF_TYPE_ value
+ * @param sOid commit for GBL_DIFF_TYPE_COMMIT
+ * @param paths
+ * @param pFileItem shown in the content info, Q_NULLPTR for more than one file
+ */
+void MainWindow::requestDiff(int nType, const QString &sOid, const QStringList &paths, GBL_File_Item *pFileItem)
+{
+    MdiChild *pChild = currentMdiChild();
+    if (!pChild) return;
+
+    QDockWidget *pDock = m_docks["file_content"];
+    ContentView *pCV = dynamic_cast<ContentView*>(pDock->widget());
+    pCV->setContentInfo(pFileItem);
+
+    m_pDiffChild = pChild;
+    m_bDiffShown = false;
+    m_nDiffType = nType;
+    m_sDiffOid = sOid;
+    m_diffPaths = paths;
+    m_nDiffGeneration = pChild->diff(nType, sOid, paths, &m_diffLimits);
+}
+
+/**
+ * @brief MainWindow::loadFullDiff
+ * asks for the diff shown again without limits, it comes in chunks
+ */
+void MainWindow::loadFullDiff()
+{
+    MdiChild *pChild = currentMdiChild();
+    if (!pChild || pChild != m_pDiffChild) return;
+
+    m_bDiffShown = false;
+    m_nDiffGeneration = pChild->diff(m_nDiffType, m_sDiffOid, m_diffPaths);
+}
+
+/**
+ * @brief MainWindow::commitFilesReady
+ * shows the files of the commit selected last
+ * @param pChild
+ * @param nGeneration
+ */
+void MainWindow::commitFilesReady(MdiChild *pChild, int nGeneration)
+{
+    if (pChild != m_pFilesChild || nGeneration != m_nFilesGeneration) return;
+
+    GBL_FileList histFileArr;
+    if (!pChild->takeCommitFiles(nGeneration, histFileArr)) return;
+
+    CommitDock *pCDock = (CommitDock*)m_docks["history_details"];
+    pCDock->setFileArray(&histFileArr);
+}
+
+/**
+ * @brief MainWindow::diffReady
+ * shows the diff asked for last, results of older requests are dropped
+ * @param pChild
+ * @param nGeneration
+ * @param bComplete false for the first screen of a diff still running
+ */
+void MainWindow::diffReady(MdiChild *pChild, int nGeneration, bool bComplete)
+{
+    Q_UNUSED(bComplete);
+
+    if (pChild != m_pDiffChild || nGeneration != m_nDiffGeneration) return;
+
+    GBL_DiffBuffer diffBuffer;
+    if (!pChild->takeDiff(nGeneration, diffBuffer)) return;
+
+    QDockWidget *pDock = m_docks["file_content"];
+    ContentView *pCV = dynamic_cast<ContentView*>(pDock->widget());
+    pCV->setDiff(diffBuffer, m_bDiffShown);
+    m_bDiffShown = true;
+}
+
 void MainWindow::openBookmarkDoubleClick(const QModelIndex &index)
 {
     BookmarkItem *pItem = static_cast<BookmarkItem*>(index.internalPointer());
@@ -770,9 +851,9 @@ void MainWindow::commitTabChanged(int tabID)
     updateCommitFiles();
 }
 
-GBL_History_Item* MainWindow::getSelectedHistoryItem()
+bool MainWindow::getSelectedHistoryItem(GBL_History_Item &histItem)
 {
-    GBL_History_Item *pRet = Q_NULLPTR;
+    bool bRet = false;
 
     MdiChild *pChild = currentMdiChild();
     if (pChild)
@@ -785,22 +866,23 @@ GBL_History_Item* MainWindow::getSelectedHistoryItem()
             int row = mi.row();
 
             GBL_HistoryModel *pHistModel = pChild->getHistoryModel();
-            GBL_History_Item *pHistItem = pHistModel->getHistoryItemAt(row);
-            if (pHistItem)
+            bRet = pHistModel->getHistoryItemAt(row, histItem);
+            if (bRet)
             {
-                pRet = pHistItem;
+                pChild->getRepository()->get_commit_message(GBL_String(histItem.hist_oid), histItem.hist_message);
             }
         }
     }
 
-    return pRet;
+    return bRet;
 }
 
 void MainWindow::updateCommitFiles()
 {
-    GBL_History_Item *pHistItem = getSelectedHistoryItem();
+    GBL_History_Item histItem;
+    GBL_History_Item *pHistItem = &histItem;
 
-    if (pHistItem)
+    if (getSelectedHistoryItem(histItem))
     {
         CommitDock *pCDock = (CommitDock*)m_docks["history_details"];
         pCDock->reset();
@@ -813,22 +895,23 @@ void MainWindow::updateCommitFiles()
         {
             ContentView *pCV = (ContentView*)pDock->widget();
             pCV->reset();
+            m_pDiffChild = Q_NULLPTR;
         }
         //m_qpRepo->get_tree_from_commit_oid(pHistItem->hist_oid, pMod);
-        GBL_File_Array histFileArr;
+        GBL_FileList histFileArr;
         GBL_Repository *pRepo = currentMdiChild()->getRepository();
         GBL_FileModel *pMod = dynamic_cast<GBL_FileModel*>(pView->model());
         pMod->setRepoPath(currentMdiChild()->currentPath());
+        m_pFilesChild = Q_NULLPTR;
 
         switch (m_nCommitTabID)
         {
             case COMMIT_DIFF_TAB_ID:
-                if (pRepo->get_commit_to_parent_diff_files(pHistItem->hist_oid, &histFileArr))
-                {
-                    pMod->setViewType(GBL_FILETREE_VIEW_TYPE_LIST);
-                    pCDock->setFileArray(&histFileArr);
-                    pView->setHeaderHidden(false);
-                }
+                // the list comes from the diffs the file patches are made from
+                pMod->setViewType(GBL_FILETREE_VIEW_TYPE_LIST);
+                pView->setHeaderHidden(false);
+                m_pFilesChild = currentMdiChild();
+                m_nFilesGeneration = m_pFilesChild->commitFiles(pHistItem->hist_oid);
                 break;
 
             case COMMiT_ALL_TAB_ID:
@@ -897,12 +980,13 @@ void MainWindow::stageAll()
     QStringList files;
     QDockWidget *pDock = m_docks["unstaged"];
     UnstagedDockView *pUSView = dynamic_cast<UnstagedDockView*>(pDock->widget());
-    GBL_File_Array *pFileArr = pUSView->getFileArray();
+    GBL_FileList *pFileArr = pUSView->getFileArray();
     QString sPath;
     for (int i=0; i < pFileArr->size(); i++)
     {
         sPath = "";
-        GBL_File_Item *pFileItem = pFileArr->at(i);
+        GBL_File_Item fileItem = pFileArr->item(i);
+        GBL_File_Item *pFileItem = &fileItem;
         if (pFileItem->sub_dir != ".")
         {
             sPath += pFileItem->sub_dir;
@@ -936,13 +1020,14 @@ void MainWindow::stageSelected()
     UnstagedDockView *pUSView = (UnstagedDockView*)pDock->widget();
     FileView *pFView = pUSView->getFileView();
     QModelIndexList mil = pFView->selectionModel()->selectedRows();
-    GBL_File_Array *pFileArr = pUSView->getFileArray();
+    GBL_FileList *pFileArr = pUSView->getFileArray();
     QString sPath;
     for (int i=0; i < mil.size(); i++)
     {
 
         sPath = "";
-        GBL_File_Item *pFileItem = pFileArr->at(mil.at(i).row());
+        GBL_File_Item fileItem = pFileArr->item(mil.at(i).row());
+        GBL_File_Item *pFileItem = &fileItem;
         if (pFileItem->sub_dir != ".")
         {
             sPath += pFileItem->sub_dir;
@@ -975,12 +1060,13 @@ void MainWindow::unstageAll()
     QStringList files;
     QDockWidget *pDock = m_docks["staged"];
     StagedDockView *pSView = dynamic_cast<StagedDockView*>(pDock->widget());
-    GBL_File_Array *pFileArr = pSView->getFileArray();
+    GBL_FileList *pFileArr = pSView->getFileArray();
     QString sPath;
     for (int i=0; i < pFileArr->size(); i++)
     {
         sPath = "";
-        GBL_File_Item *pFileItem = pFileArr->at(i);
+        GBL_File_Item fileItem = pFileArr->item(i);
+        GBL_File_Item *pFileItem = &fileItem;
         if (pFileItem->sub_dir != ".")
         {
             sPath += pFileItem->sub_dir;
@@ -1012,7 +1098,7 @@ void MainWindow::unstageSelected()
     QStringList files;
     QDockWidget *pDock = m_docks["staged"];
     StagedDockView *pSView = (StagedDockView*)pDock->widget();
-    GBL_File_Array *pFileArr = pSView->getFileArray();
+    GBL_FileList *pFileArr = pSView->getFileArray();
     FileView *pFView = pSView->getFileView();
     QModelIndexList mil = pFView->selectionModel()->selectedRows();
 
@@ -1020,7 +1106,8 @@ void MainWindow::unstageSelected()
     for (int i=0; i < mil.size(); i++)
     {
         sPath = "";
-        GBL_File_Item *pFileItem = pFileArr->at(mil.at(i).row());
+        GBL_File_Item fileItem = pFileArr->item(mil.at(i).row());
+        GBL_File_Item *pFileItem = &fileItem;
         if (pFileItem->sub_dir != ".")
         {
             sPath += pFileItem->sub_dir;
@@ -1058,6 +1145,7 @@ void MainWindow::commit()
     {
         if (pRepo->commit_index(msg))
         {
+            pSView->clearCommitMessage();
             currentMdiChild()->updateHistory();
             updateStatus();
             updatePushPull();
@@ -1075,14 +1163,6 @@ void MainWindow::commit_push()
     pushAction();
 }
 
-void MainWindow::addToDiffView(GBL_Line_Item *pLineItem)
-{
-    QDockWidget *pDock = m_docks["file_content"];
-    ContentView *pCV = dynamic_cast<ContentView*>(pDock->widget());
-
-    pCV->addLine(pLineItem);
-}
-
 void MainWindow::preferences()
 {
     QString currentTheme = m_sTheme;
@@ -1096,6 +1176,7 @@ void MainWindow::preferences()
     PrefsDialog prefsDlg(this);
     prefsDlg.setConfigMap(pConfigMap);
     prefsDlg.setAutoFetch(m_bAutoFetch, m_nAutoFetchInterval);
+    prefsDlg.setDiffLimits(m_diffLimits);
     if (prefsDlg.exec() == QDialog::Accepted)
     {
         QSettings settings(QCoreApplication::organizationName(), QCoreApplication::applicationName());
@@ -1130,6 +1211,18 @@ void MainWindow::preferences()
         prefsDlg.getAutoFetch(m_bAutoFetch, m_nAutoFetchInterval);
         settings.setValue("Repo/Autotfetch", m_bAutoFetch);
         settings.setValue("Repo/AutofetchInterval",m_nAutoFetchInterval);
+
+        GBL_Diff_Limits limits;
+        prefsDlg.getDiffLimits(limits);
+        if (limits.max_bytes != m_diffLimits.max_bytes || limits.max_lines != m_diffLimits.max_lines || limits.max_line_length != m_diffLimits.max_line_length)
+        {
+            m_diffLimits = limits;
+            // cached summaries were made with the old limits
+            GBL_DiffCache::getInstance()->clear();
+        }
+        settings.setValue("Diff/MaxBytes", m_diffLimits.max_bytes);
+        settings.setValue("Diff/MaxLines", m_diffLimits.max_lines);
+        settings.setValue("Diff/MaxLineLength", m_diffLimits.max_line_length);
     }
     else
     {
@@ -1271,10 +1364,10 @@ void MainWindow::onCreateBranch()
                 GBL_String sBranchName;
                 sBranchName = brDlg.getBranchName();
                 GBL_String sOid;
-                GBL_History_Item *pHistItem = getSelectedHistoryItem();
-                if (pHistItem)
+                GBL_History_Item histItem;
+                if (getSelectedHistoryItem(histItem))
                 {
-                    sOid = pHistItem->hist_oid;
+                    sOid = histItem.hist_oid;
                 }
 
                 if (pRepo->create_branch(sBranchName, sOid))
@@ -1538,6 +1631,11 @@ void MainWindow::createActions()
     dbgMenu->addAction(tr("&ssl version..."), this, &MainWindow::sslVersion);
     dbgMenu->addAction(tr("&libgit2 version..."), this, &MainWindow::libgit2Version);
     dbgMenu->addAction(tr("Progress Test..."),this, &MainWindow::progressTest);
+    dbgMenu->addAction(tr("History Model Benchmark..."),this, &MainWindow::historyBenchmark);
+    dbgMenu->addAction(tr("History Read Benchmark..."),this, &MainWindow::historyReadBenchmark);
+    dbgMenu->addAction(tr("Diff Capture Benchmark..."),this, &MainWindow::diffBenchmark);
+    dbgMenu->addAction(tr("Diff Cache Stats..."),this, &MainWindow::diffCacheStats);
+    dbgMenu->addAction(tr("Scan Literals Check..."),this, &MainWindow::scanLiteralsCheck);
 #endif
 
     QMenu *toolsMenu = menuBar()->addMenu(tr("&Tools"));
@@ -1566,6 +1664,68 @@ void MainWindow::libgit2Version()
     QMessageBox::information(this,tr("libgit2 version"), m_qpRepo->get_libgit2_version());
 }
 
+void MainWindow::historyBenchmark()
+{
+#ifdef QT_DEBUG
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QString sResult = GBL_HistoryModel::benchmark(1000000);
+    QApplication::restoreOverrideCursor();
+
+    QMessageBox::information(this,tr("History Model Benchmark"), sResult);
+#endif
+}
+
+void MainWindow::historyReadBenchmark()
+{
+#ifdef QT_DEBUG
+    MdiChild *pChild = currentMdiChild();
+    if (!pChild) return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QString sResult = pChild->getRepository()->history_benchmark(100000);
+    QApplication::restoreOverrideCursor();
+
+    QMessageBox::information(this,tr("History Read Benchmark"), sResult);
+#endif
+}
+
+void MainWindow::diffBenchmark()
+{
+#ifdef QT_DEBUG
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QString sResult = GBL_DiffBuffer::benchmark(5000);
+    QApplication::restoreOverrideCursor();
+
+    QMessageBox::information(this,tr("Diff Capture Benchmark"), sResult);
+#endif
+}
+
+void MainWindow::diffCacheStats()
+{
+#ifdef QT_DEBUG
+    GBL_DiffCache *pCache = GBL_DiffCache::getInstance();
+    int nHits = pCache->hitCount();
+    int nMisses = pCache->missCount();
+    int nLookups = nHits + nMisses;
+
+    QString sResult;
+    QTextStream(&sResult) << "hits: " << nHits << "\n"
+                          << "misses: " << nMisses << "\n"
+                          << "hit rate: " << (nLookups ? nHits * 100 / nLookups : 0) << "%\n"
+                          << "diffs cached: " << pCache->entryCount() << "\n"
+                          << "bytes: " << pCache->totalCost() << " of " << pCache->maxCost();
+
+    QMessageBox::information(this,tr("Diff Cache Stats"), sResult);
+#endif
+}
+
+void MainWindow::scanLiteralsCheck()
+{
+#ifdef QT_DEBUG
+    QMessageBox::information(this,tr("Scan Literals Check"), GBL_TrigramIndex::literalsCheck());
+#endif
+}
+
 void MainWindow::progressTest()
 {
     QProgressDialog dlg(tr("Cloning..."),tr("Cancel"),0,100,this);
@@ -1609,7 +1769,7 @@ void MainWindow::scanAction()
         sRoot = sdlg.getRootPath();
         GBL_String sSearch;
         sSearch = sdlg.getSearch();
-        pChild->init(sRoot, sSearch, sdlg.getSearchType());
+        pChild->init(sRoot, sSearch, sdlg.getSearchType(), sdlg.getOptions(), sdlg.getRange());
     }
 }
 
@@ -1636,6 +1796,7 @@ void MainWindow::createDocks()
     //setup file content dock
     QDockWidget *pDock = new QDockWidget(tr("Content"), this);
     ContentView *pCV = new ContentView(pDock);
+    connect(pCV, &ContentView::loadFullDiff, this, &MainWindow::loadFullDiff);
     pDock->setWidget(pCV);
     m_docks["file_content"] = pDock;
     pDock->setObjectName("MainWindow/Content/Dock");
@@ -1708,6 +1869,7 @@ void MainWindow:: resetDocks(bool bRepaint)
         QDockWidget *pDock = m_docks["file_content"];
         ContentView *pCV = dynamic_cast<ContentView*>(pDock->widget());
         pCV->reset();
+        m_pDiffChild = Q_NULLPTR;
 
         pDock = m_docks["staged"];
         StagedDockView *pSView = dynamic_cast<StagedDockView*>(pDock->widget());
@@ -1837,6 +1999,9 @@ void MainWindow::readSettings()
 
     m_bAutoFetch = settings.value("Repo/Autofetch",true).toBool();
     m_nAutoFetchInterval = settings.value("Repo/AutofetchInterval", 10).toInt();
+    m_diffLimits.max_bytes = settings.value("Diff/MaxBytes", GBL_DIFF_MAX_BYTES).toLongLong();
+    m_diffLimits.max_lines = settings.value("Diff/MaxLines", GBL_DIFF_MAX_LINES).toInt();
+    m_diffLimits.max_line_length = settings.value("Diff/MaxLineLength", GBL_DIFF_MAX_LINE_LENGTH).toInt();
    /**/
     UrlPixmap svgpix(Q_NULLPTR);
 
@@ -2033,11 +2198,31 @@ void MainWindow::avatarDownloaded(QNetworkReply* pReply)
 }
 
 QPixmap* MainWindow::getAvatar(QString sEmail, bool bSmall)
+{
+    return getAvatar(getAvatarHandle(sEmail), bSmall);
+}
+
+/**
+ * @brief MainWindow::getAvatarHandle
+ * @param sEmail
+ * @return the avatar kept for sEmail, callers showing many rows keep the
+ * handle rather than looking the email up on every paint
+ */
+UrlPixmap* MainWindow::getAvatarHandle(const QString &sEmail)
+{
+    return m_avatarMap.value(sEmail.toLower(), Q_NULLPTR);
+}
+
+/**
+ * @brief MainWindow::getAvatar
+ * @param pAvatar handle from getAvatarHandle
+ * @param bSmall
+ * @return the avatar pixmap, or the unknown avatar if it isn't downloaded
+ */
+QPixmap* MainWindow::getAvatar(UrlPixmap *pAvatar, bool bSmall)
 {
     QPixmap *pPixMap = Q_NULLPTR;
 
-    QString slcEmail = sEmail.toLower();
-    UrlPixmap *pAvatar = (UrlPixmap*)m_avatarMap[slcEmail];
     if (pAvatar)
     {
         if (bSmall)
@@ -2051,9 +2236,11 @@ QPixmap* MainWindow::getAvatar(QString sEmail, bool bSmall)
 
     }
 
-    if (pPixMap->isNull())
+    if (!pPixMap || pPixMap->isNull())
     {
-        pAvatar = (UrlPixmap*)m_avatarMap["unknown"];
+        pAvatar = (UrlPixmap*)m_avatarMap.value("unknown", Q_NULLPTR);
+        if (!pAvatar) return Q_NULLPTR;
+
         if (bSmall)
         {
             pPixMap = pAvatar->getSmallCirclePixmap(20);
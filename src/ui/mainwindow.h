@@ -23,7 +23,6 @@ class QNetworkDiskCache;
 class QNetworkReply;
 class UrlPixmap;
 class QAction;
-struct GBL_Line_Item;
 class FileView;
 class ToolbarCombo;
 class BadgeToolButton;
@@ -45,7 +44,6 @@ public:
     QNetworkAccessManager* getNetworkAccessManager() { return m_pNetAM; }
     QNetworkDiskCache* getNetworkCache() { return m_pNetCache; }
 
-    void addToDiffView(GBL_Line_Item *pLineItem);
     void setTheme(const QString &theme);
     QString getTheme() { return m_sTheme; }
     QString getSelectedCode() { return m_sSelectedCode; }
@@ -61,6 +59,8 @@ public:
     void startAvatarDownload();
     void getAvatarFromUrl(QString sUrl, QString sEmail);
     QPixmap* getAvatar(QString sEmail, bool bSmall=false);
+    QPixmap* getAvatar(UrlPixmap *pAvatar, bool bSmall=false);
+    UrlPixmap* getAvatarHandle(const QString &sEmail);
 
     MdiChild* currentMdiChild();
     GBL_Repository* getCurrentRepository();
@@ -77,12 +77,14 @@ public slots:
     void historySelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
     void commitTabChanged(int tabID);
     void applicationStateChanged(Qt::ApplicationState state);
-    void statusUpdated(GBL_String *psError, GBL_File_Array *pStagedArr, GBL_File_Array *pUnstagedArr);
+    void statusUpdated(GBL_String *psError, GBL_FileList *pStagedArr, GBL_FileList *pUnstagedArr);
     void refsUpdated(GBL_String *psError, GBL_RefItem *pRefItem);
     void fetchFinished(GBL_String *psError);
     void pullFinished(GBL_String *psError);
     void pushFinished(GBL_String *psError);
     void checkoutFinished(GBL_String *psError);
+    void diffReady(MdiChild *pChild, int nGeneration, bool bComplete);
+    void commitFilesReady(MdiChild *pChild, int nGeneration);
     void cloneFinished(GBL_String* psError, GBL_String* psDst);
     void openBookmarkDoubleClick(const QModelIndex &index);
     void addBookmark();
@@ -106,6 +108,11 @@ private slots:
     void sslVersion();
     void libgit2Version();
     void progressTest();
+    void historyBenchmark();
+    void historyReadBenchmark();
+    void diffBenchmark();
+    void diffCacheStats();
+    void scanLiteralsCheck();
     void historyFileSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
     void workingFileSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
     void stagedFileSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
@@ -120,6 +127,7 @@ private slots:
     void refresh();
     void updateCommitFiles();
     void scanAction();
+    void loadFullDiff();
 
 private:
     enum { MaxRecentRepos = 10 };
@@ -142,7 +150,8 @@ private:
     bool openRepoTab(QString &path);
     void updateBranchCombo();
     void updateReferences();
-    GBL_History_Item* getSelectedHistoryItem();
+    bool getSelectedHistoryItem(GBL_History_Item &histItem);
+    void requestDiff(int nType, const QString &sOid, const QStringList &paths, GBL_File_Item *pFileItem);
 
     GBL_Repository *m_qpRepo;
     QMap<QString, QDockWidget*> m_docks;
@@ -177,6 +186,19 @@ private:
 
     int m_nCommitTabID;
     MdiChild *m_pCurrentChild;
+
+    // the tab and generation of the diff the content view is waiting on
+    MdiChild *m_pDiffChild;
+    int m_nDiffGeneration;
+    bool m_bDiffShown;
+    int m_nDiffType;
+    QString m_sDiffOid;
+    QStringList m_diffPaths;
+    GBL_Diff_Limits m_diffLimits;
+
+    // the tab and generation of the commit file list being made
+    MdiChild *m_pFilesChild;
+    int m_nFilesGeneration;
     QString m_sCurrentBranch;
 };
 
@@ -6,6 +6,7 @@
 #include "src/gbl/gbl_historymodel.h"
 #include "urlpixmap.h"
 #include "src/gbl/gbl_threads.h"
+#include "src/gbl/gbl_statusjournal.h"
 
 #include <QHeaderView>
 #include <QFileInfo>
@@ -27,6 +28,11 @@ MdiChild::MdiChild(QWidget *parent) : QFrame(parent)
     createHistoryTable();
 
     m_qpRepo = NULL;
+    m_pStatusJournal = Q_NULLPTR;
+    m_bHistoryRunning = false;
+    m_bHistoryPending = false;
+    m_bHistoryFetchPending = false;
+    m_bStatusPending = false;
     m_pRefRoot = new GBL_RefItem("","");
     m_pMainWnd = MainWindow::getInstance();
 }
@@ -36,6 +42,13 @@ MdiChild::~MdiChild()
     delete m_qpRepo;
     delete m_pRefRoot;
 
+    // keep what was paged in for the next time the repository is opened
+    GBL_HistoryThread *pHistThread = (GBL_HistoryThread*)m_threads.value("history");
+    if (pHistThread)
+    {
+        pHistThread->save_cache(*m_pHistModel->getCommitStore());
+    }
+
     QMapIterator<QString, GBL_Thread*> j(m_threads);
     while (j.hasNext())
     {
@@ -79,14 +92,28 @@ bool MdiChild::init(QString sRepoPath)
         m_threads.insert("push", pPushThread);
         GBL_CheckoutThread *pCheckoutThread = new GBL_CheckoutThread(this);
         m_threads.insert("checkout", pCheckoutThread);
+        GBL_DiffThread *pDiffThread = new GBL_DiffThread(sPath, this);
+        m_threads.insert("diff", pDiffThread);
 
-        connect(pHistThread, SIGNAL(historyUpdated(GBL_String*, GBL_History_Array*)), this, SLOT(historyUpdated(GBL_String*, GBL_History_Array*)));
+        connect(pHistThread, SIGNAL(historyUpdated(GBL_String*, GBL_CommitStore*, int, bool)), this, SLOT(historyUpdated(GBL_String*, GBL_CommitStore*, int, bool)));
+        connect(m_pHistModel, &GBL_HistoryModel::historyFetchMore, this, &MdiChild::historyFetchMore);
+        connect(pHistThread, SIGNAL(finished()), this, SLOT(historyFinished()));
         connect(pRefThread, SIGNAL(refsUpdated(GBL_String*, GBL_RefItem*)), this, SLOT(refsUpdated(GBL_String*, GBL_RefItem*)));
-        connect(pStatusThread, SIGNAL(statusUpdated(GBL_String*, GBL_File_Array*,GBL_File_Array*)), this, SLOT(statusUpdated(GBL_String*, GBL_File_Array*,GBL_File_Array*)));
+        connect(pStatusThread, SIGNAL(statusUpdated(GBL_String*, GBL_FileList*,GBL_FileList*)), this, SLOT(statusUpdated(GBL_String*, GBL_FileList*,GBL_FileList*)));
+        connect(pStatusThread, SIGNAL(statusWatch(QStringList, bool)), this, SLOT(statusWatch(QStringList, bool)));
+        connect(pStatusThread, SIGNAL(finished()), this, SLOT(statusFinished()));
         connect(pFetchThread, SIGNAL(fetchFinished(GBL_String*)), this, SLOT(fetchFinished(GBL_String*)));
         connect(pPullThread, SIGNAL(pullFinished(GBL_String*)), this, SLOT(pullFinished(GBL_String*)));
         connect(pPushThread, SIGNAL(pushFinished(GBL_String*)), this, SLOT(pushFinished(GBL_String*)));
         connect(pCheckoutThread, SIGNAL(checkoutFinished(GBL_String*)), this, SLOT(checkoutFinished(GBL_String*)));
+        connect(pDiffThread, SIGNAL(diffReady(int, bool)), this, SLOT(diffReady(int, bool)));
+        connect(pDiffThread, SIGNAL(commitFilesReady(int)), this, SLOT(commitFilesReady(int)));
+
+        if (!m_qpRepo->is_bare())
+        {
+            m_pStatusJournal = new GBL_StatusJournal(m_sRepoPath, m_qpRepo->get_git_dir(), this);
+            connect(m_pStatusJournal, SIGNAL(changed()), this, SLOT(workTreeChanged()));
+        }
 
         updateHistory();
         updateReferences();
@@ -118,20 +145,39 @@ void MdiChild::createHistoryTable()
 
 }
 
+/**
+ * @brief MdiChild::updateHistory
+ * reads the history again once the page in progress has been shown, the
+ * thread reuses its page and a refresh starts from the history the view has
+ */
 void MdiChild::updateHistory()
 {
-    m_pHistView->reset();
-
-    /*
-    m_qpRepo->get_history(m_pHistModel->getHistoryArray());
-    m_pHistModel->historyUpdated();
+    if (m_bHistoryRunning)
+    {
+        m_bHistoryPending = true;
+        return;
+    }
 
-    m_pHistView->setSpan(0,0,m_pHistModel->rowCount(),1);
-    */
     GBL_HistoryThread *pThread = (GBL_HistoryThread*)m_threads["history"];
-    pThread->get_history();
+    const GBL_CommitStore *pStore = m_pHistModel->getCommitStore();
+    m_bHistoryRunning = true;
+
+    // only walk what is new on top of the history already shown
+    if (pStore->isEmpty())
+    {
+        pThread->get_history();
+    }
+    else
+    {
+        pThread->refresh_history(*pStore);
+    }
 }
 
+/**
+ * @brief MdiChild::updateStatus
+ * takes the status of the tracked files of the whole working tree, once the
+ * one in progress is done. Untracked files come from the untracked cache.
+ */
 void MdiChild::updateStatus()
 {
     if (m_qpRepo && !m_qpRepo->is_bare())
@@ -140,9 +186,62 @@ void MdiChild::updateStatus()
         QString dir = currentPath();
         if (!pThread->isRunning())
         {
+            // whatever the journal held is covered by the full status
+            QStringList dirs;
+            bool bIndex;
+            m_pStatusJournal->takeChanges(dirs, bIndex);
             pThread->status(GBL_String(dir));
         }
+        else
+        {
+            m_bStatusPending = true;
+        }
+    }
+}
+
+/**
+ * @brief MdiChild::startStatus
+ * takes the status of what the journal saw change, reporting it only if it
+ * differs from the last status. A window in the background keeps the changes
+ * for the full status it takes when it is activated.
+ */
+void MdiChild::startStatus()
+{
+    GBL_StatusThread *pThread = (GBL_StatusThread*)m_threads["status"];
+    if (pThread->isRunning() || !m_pStatusJournal->hasChanges()) return;
+    if (m_pMainWnd->currentMdiChild() != this) return;
+
+    QStringList dirs;
+    bool bIndex;
+    int nMode = GBL_STATUS_FULL;
+    if (!m_pStatusJournal->takeChanges(dirs, bIndex))
+    {
+        nMode = bIndex ? GBL_STATUS_INDEX : GBL_STATUS_DIRS;
+    }
+    pThread->status(GBL_String(currentPath()), nMode, dirs, true);
+}
+
+void MdiChild::workTreeChanged()
+{
+    startStatus();
+}
+
+void MdiChild::statusFinished()
+{
+    if (m_bStatusPending)
+    {
+        m_bStatusPending = false;
+        updateStatus();
     }
+    else
+    {
+        startStatus();
+    }
+}
+
+void MdiChild::statusWatch(const QStringList &dirs, bool bReplace)
+{
+    if (m_pStatusJournal) m_pStatusJournal->watch(dirs, bReplace);
 }
 
 void MdiChild::updateReferences()
@@ -187,20 +286,98 @@ void MdiChild::checkout(GBL_String sBranch)
     pCheckoutThread->checkout(GBL_String(dir), sBranch);
 }
 
-void MdiChild::historyUpdated(GBL_String *psError, GBL_History_Array *pHistArr)
+/**
+ * @brief MdiChild::diff
+ * starts a diff in the background, dropping the one in progress
+ * @param nType GBL_DIFF_TYPE_ value
+ * @param sOid
+ * @param paths
+ * @param pLimits Q_NULLPTR for the full diff
+ * @return the generation of the request
+ */
+int MdiChild::diff(int nType, GBL_String sOid, QStringList paths, const GBL_Diff_Limits *pLimits)
 {
-    if (psError->isEmpty())
+    GBL_DiffThread *pDiffThread = (GBL_DiffThread*)m_threads["diff"];
+    return pDiffThread->diff(nType, sOid, paths, pLimits);
+}
+
+bool MdiChild::takeDiff(int nGeneration, GBL_DiffBuffer &buffer)
+{
+    GBL_DiffThread *pDiffThread = (GBL_DiffThread*)m_threads["diff"];
+    return pDiffThread->takeDiff(nGeneration, buffer);
+}
+
+/**
+ * @brief MdiChild::commitFiles
+ * lists the files a commit changed in the background
+ * @param sOid
+ * @return the generation of the request
+ */
+int MdiChild::commitFiles(GBL_String sOid)
+{
+    GBL_DiffThread *pDiffThread = (GBL_DiffThread*)m_threads["diff"];
+    return pDiffThread->commitFiles(sOid);
+}
+
+bool MdiChild::takeCommitFiles(int nGeneration, GBL_FileList &files)
+{
+    GBL_DiffThread *pDiffThread = (GBL_DiffThread*)m_threads["diff"];
+    return pDiffThread->takeCommitFiles(nGeneration, files);
+}
+
+void MdiChild::historyUpdated(GBL_String *psError, GBL_CommitStore *pPage, int nUpdate, bool bMore)
+{
+    switch (nUpdate)
     {
-        for (int i=0; i < pHistArr->size(); i++)
-        {
-            m_pHistModel->addHistoryItem(pHistArr->at(i));
-        }
-        m_pHistModel->historyUpdated();
-        m_pHistView->setSpan(0,0,m_pHistModel->rowCount(),1);
+        case GBL_HISTORY_UPDATE_PREPEND:
+            m_pHistModel->prependHistoryPage(pPage);
+            break;
+
+        case GBL_HISTORY_UPDATE_RESET:
+            m_pHistModel->reset();
+            // fall through
+        default:
+            // stop paging once the walk reports an error
+            m_pHistModel->addHistoryPage(pPage, psError->isEmpty() && bMore);
+            break;
+    }
+}
+
+void MdiChild::historyFetchMore()
+{
+    if (m_bHistoryRunning)
+    {
+        m_bHistoryFetchPending = true;
+        return;
+    }
+
+    GBL_HistoryThread *pThread = (GBL_HistoryThread*)m_threads["history"];
+    m_bHistoryRunning = true;
+    pThread->fetch_more();
+}
+
+/**
+ * @brief MdiChild::historyFinished
+ * the page of the run is in the model by now, a refresh asked for meanwhile
+ * goes before a page fetch
+ */
+void MdiChild::historyFinished()
+{
+    m_bHistoryRunning = false;
+
+    if (m_bHistoryPending)
+    {
+        m_bHistoryPending = false;
+        updateHistory();
+    }
+    else if (m_bHistoryFetchPending)
+    {
+        m_bHistoryFetchPending = false;
+        historyFetchMore();
     }
 }
 
-void MdiChild::statusUpdated(GBL_String *psError, GBL_File_Array *pStagedArr, GBL_File_Array *pUnstagedArr)
+void MdiChild::statusUpdated(GBL_String *psError, GBL_FileList *pStagedArr, GBL_FileList *pUnstagedArr)
 {
     if (m_pMainWnd->currentMdiChild() == this)
     {
@@ -258,3 +435,19 @@ void MdiChild::resizeEvent(QResizeEvent *event)
     QSize sz(width(),height());
     m_pHistView->resize(sz);
 }
+
+void MdiChild::diffReady(int nGeneration, bool bComplete)
+{
+    if (m_pMainWnd->currentMdiChild() == this)
+    {
+        m_pMainWnd->diffReady(this, nGeneration, bComplete);
+    }
+}
+
+void MdiChild::commitFilesReady(int nGeneration)
+{
+    if (m_pMainWnd->currentMdiChild() == this)
+    {
+        m_pMainWnd->commitFilesReady(this, nGeneration);
+    }
+}
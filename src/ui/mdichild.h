@@ -9,6 +9,7 @@ class HistoryView;
 class GBL_HistoryModel;
 class GBL_Repository;
 class GBL_Thread;
+class GBL_StatusJournal;
 QT_END_NAMESPACE
 
 class MdiChild : public QFrame
@@ -30,6 +31,10 @@ public:
     void pull(GBL_String sBranch);
     void push(GBL_String sBranch);
     void checkout(GBL_String sBranch);
+    int diff(int nType, GBL_String sOid, QStringList paths, const GBL_Diff_Limits *pLimits = Q_NULLPTR);
+    bool takeDiff(int nGeneration, GBL_DiffBuffer &buffer);
+    int commitFiles(GBL_String sOid);
+    bool takeCommitFiles(int nGeneration, GBL_FileList &files);
 
     QString currentPath() { return m_sRepoPath; }
     QString repoName() { return m_sRepoName; }
@@ -37,19 +42,27 @@ public:
 signals:
 
 public slots:
-    void historyUpdated(GBL_String *psError, GBL_History_Array *pHistArr);
-    void statusUpdated(GBL_String *psError, GBL_File_Array *pStagedArr, GBL_File_Array *pUnstagedArr);
+    void historyUpdated(GBL_String *psError, GBL_CommitStore *pPage, int nUpdate, bool bMore);
+    void historyFetchMore();
+    void historyFinished();
+    void statusUpdated(GBL_String *psError, GBL_FileList *pStagedArr, GBL_FileList *pUnstagedArr);
     void refsUpdated(GBL_String *psError, GBL_RefItem *pRefItem);
     void fetchFinished(GBL_String *psError);
     void pullFinished(GBL_String *psError);
     void pushFinished(GBL_String *psError);
     void checkoutFinished(GBL_String *psError);
+    void diffReady(int nGeneration, bool bComplete);
+    void commitFilesReady(int nGeneration);
+    void statusWatch(const QStringList &dirs, bool bReplace);
+    void statusFinished();
+    void workTreeChanged();
 
 private slots:
     virtual void resizeEvent(QResizeEvent *event);
 
 private:
     void createHistoryTable();
+    void startStatus();
 
     GBL_Repository *m_qpRepo;
     QString m_sRepoPath, m_sRepoName;
@@ -57,6 +70,11 @@ private:
     GBL_HistoryModel *m_pHistModel;
     QMap<QString, GBL_Thread*> m_threads;
     GBL_RefItem *m_pRefRoot;
+    GBL_StatusJournal *m_pStatusJournal;
+    bool m_bHistoryRunning;
+    bool m_bHistoryPending;
+    bool m_bHistoryFetchPending;
+    bool m_bStatusPending;
     MainWindow *m_pMainWnd;
 };
 
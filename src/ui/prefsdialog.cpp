@@ -124,6 +124,18 @@ void PrefsDialog::getAutoFetch(bool &bAutoFetch, int &nAutoFetchInterval)
     nAutoFetchInterval = pPage->getAutoFetchInterval();
 }
 
+void PrefsDialog::setDiffLimits(const GBL_Diff_Limits &limits)
+{
+    GeneralPrefsPage *pPage = dynamic_cast<GeneralPrefsPage*>(m_pPages->widget(0));
+    pPage->setDiffLimits(limits);
+}
+
+void PrefsDialog::getDiffLimits(GBL_Diff_Limits &limits)
+{
+    GeneralPrefsPage *pPage = dynamic_cast<GeneralPrefsPage*>(m_pPages->widget(0));
+    pPage->getDiffLimits(limits);
+}
+
 int PrefsDialog::getUIToolbarButtonType()
 {
     UIPrefsPage *pPage = dynamic_cast<UIPrefsPage*>(m_pPages->widget(1));
@@ -147,6 +159,13 @@ GeneralPrefsPage::GeneralPrefsPage(QWidget *parent) : QWidget(parent)
     m_pAutoFetchSB = new QSpinBox();
     m_pAutoFetchSB->setMaximumWidth(80);
     m_pAutoFetchSB->setRange(1,100);
+    m_pDiffKBytesSB = new QSpinBox();
+    m_pDiffKBytesSB->setRange(1,1024*1024);
+    m_pDiffKBytesSB->setSuffix(tr(" KB"));
+    m_pDiffLinesSB = new QSpinBox();
+    m_pDiffLinesSB->setRange(1,10000000);
+    m_pDiffLineLengthSB = new QSpinBox();
+    m_pDiffLineLengthSB->setRange(1,1000000);
 
     QGroupBox *pGGUBox = new QGroupBox(tr("Goblal Git User"));
     QGridLayout *pGGULayout = new QGridLayout();
@@ -163,6 +182,17 @@ GeneralPrefsPage::GeneralPrefsPage(QWidget *parent) : QWidget(parent)
     pAFLayout->addWidget(m_pAutoFetchSB);
     pAFLayout->addSpacing(180);
     mainLayout->addLayout(pAFLayout);
+
+    QGroupBox *pDiffBox = new QGroupBox(tr("Summarize Diffs Of Files Over"));
+    QGridLayout *pDiffLayout = new QGridLayout();
+    pDiffLayout->addWidget(new QLabel(tr("Size:")),0,0);
+    pDiffLayout->addWidget(m_pDiffKBytesSB,0,1);
+    pDiffLayout->addWidget(new QLabel(tr("Lines:")),1,0);
+    pDiffLayout->addWidget(m_pDiffLinesSB,1,1);
+    pDiffLayout->addWidget(new QLabel(tr("Line Length:")),2,0);
+    pDiffLayout->addWidget(m_pDiffLineLengthSB,2,1);
+    pDiffBox->setLayout(pDiffLayout);
+    mainLayout->addWidget(pDiffBox);
     mainLayout->addSpacing(60);
 
     setLayout(mainLayout);
@@ -207,6 +237,20 @@ void GeneralPrefsPage::setAutoFetchInterval(int nAutoFetchInterval)
 {
     m_pAutoFetchSB->setValue(nAutoFetchInterval);
 }
+
+void GeneralPrefsPage::getDiffLimits(GBL_Diff_Limits &limits)
+{
+    limits.max_bytes = (qint64)m_pDiffKBytesSB->value() * 1024;
+    limits.max_lines = m_pDiffLinesSB->value();
+    limits.max_line_length = m_pDiffLineLengthSB->value();
+}
+
+void GeneralPrefsPage::setDiffLimits(const GBL_Diff_Limits &limits)
+{
+    m_pDiffKBytesSB->setValue((int)(limits.max_bytes / 1024));
+    m_pDiffLinesSB->setValue(limits.max_lines);
+    m_pDiffLineLengthSB->setValue(limits.max_line_length);
+}
 /******************* UIPrefsPage ***************/
 UIPrefsPage::UIPrefsPage(QWidget *parent) : QWidget(parent)
 {
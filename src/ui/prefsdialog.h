@@ -27,16 +27,19 @@ public:
     QString getEmail();
     bool getAutoFetch();
     int getAutoFetchInterval();
+    void getDiffLimits(GBL_Diff_Limits &limits);
 
     void setName(QString sName);
     void setEmail(QString sEmail);
     void setAutoFetch(bool bAutoFetch);
     void setAutoFetchInterval(int nAutoFetchInterval);
+    void setDiffLimits(const GBL_Diff_Limits &limits);
 
 private:
     QLineEdit *m_pNameEdit, *m_pEmailEdit;
     QSpinBox *m_pAutoFetchSB;
     QCheckBox *m_pAutoFetchCB;
+    QSpinBox *m_pDiffKBytesSB, *m_pDiffLinesSB, *m_pDiffLineLengthSB;
 };
 
 class UIPrefsPage : public QWidget
@@ -67,6 +70,9 @@ public:
     void setAutoFetch(bool bAutoFetch, int nAutoFetchInterval);
     void getAutoFetch(bool &bAutoFetch, int &nAutoFetchInterval);
 
+    void setDiffLimits(const GBL_Diff_Limits &limits);
+    void getDiffLimits(GBL_Diff_Limits &limits);
+
     int getUIToolbarButtonType();
 
 signals:
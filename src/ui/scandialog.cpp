@@ -32,6 +32,10 @@ ScanDialog::ScanDialog(QWidget *parent) : QDialog(parent)
     m_pRootEdit = new QLineEdit();
     QLabel *pSearchLabel = new QLabel(tr("Search:"));
     m_pSearchEdit = new QLineEdit();
+    QLabel *pRangeLabel = new QLabel(tr("Commits:"));
+    m_pRangeEdit = new QLineEdit();
+    m_pRangeEdit->setPlaceholderText(tr("HEAD, a branch or tag, or a range like v1.0..master"));
+    m_pRangeEdit->setEnabled(false);
     QPushButton *pRootBtn = new QPushButton(tr("..."));
     m_pBtnBox = new QDialogButtonBox(QDialogButtonBox::Ok
                                          | QDialogButtonBox::Cancel);
@@ -58,6 +62,16 @@ ScanDialog::ScanDialog(QWidget *parent) : QDialog(parent)
     pMenu->addAction(pCIAct);
     pMenu->addAction(pCSAct);
     pMenu->addAction(pREAct);
+    pMenu->addSeparator();
+    QAction *pBlobCacheAct = pMenu->addAction(tr("Remember Searched Blobs"));
+    pBlobCacheAct->setCheckable(true);
+    connect(pBlobCacheAct, &QAction::toggled, this, &ScanDialog::optionBlobCache);
+    QAction *pIndexAct = pMenu->addAction(tr("Use Index"));
+    pIndexAct->setCheckable(true);
+    connect(pIndexAct, &QAction::toggled, this, &ScanDialog::optionUseIndex);
+    QAction *pHistoryAct = pMenu->addAction(tr("Search History"));
+    pHistoryAct->setCheckable(true);
+    connect(pHistoryAct, &QAction::toggled, this, &ScanDialog::optionHistory);
 
     connect(m_pBtnBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
     connect(m_pBtnBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
@@ -80,12 +94,15 @@ ScanDialog::ScanDialog(QWidget *parent) : QDialog(parent)
     //mainLayout->addWidget(pDstBtn, 1,2);
     //m_pDstValidateLabel = new QLabel(EMPTY_FORMAT);
     //mainLayout->addWidget(m_pDstValidateLabel,1,3);
-    mainLayout->addWidget(m_pBtnBox,2,1,1,2, Qt::AlignBottom);
+    mainLayout->addWidget(pRangeLabel,2,0);
+    mainLayout->addWidget(m_pRangeEdit,2,1);
+    mainLayout->addWidget(m_pBtnBox,3,1,1,2, Qt::AlignBottom);
     setLayout(mainLayout);
 
     setWindowTitle(tr("Scan"));
 
     m_nSearchType = SCAN_THREAD_SEARCH_TYPE_INSENSITIVE;
+    m_nOptions = 0;
 }
 
 
@@ -125,6 +142,26 @@ void ScanDialog::searchTypeRegex()
     m_nSearchType = SCAN_THREAD_SEARCH_TYPE_REGEX;
 }
 
+void ScanDialog::optionBlobCache(bool bChecked)
+{
+    if (bChecked) m_nOptions |= SCAN_THREAD_OPTION_BLOB_CACHE;
+    else m_nOptions &= ~SCAN_THREAD_OPTION_BLOB_CACHE;
+}
+
+void ScanDialog::optionUseIndex(bool bChecked)
+{
+    if (bChecked) m_nOptions |= SCAN_THREAD_OPTION_USE_INDEX;
+    else m_nOptions &= ~SCAN_THREAD_OPTION_USE_INDEX;
+}
+
+void ScanDialog::optionHistory(bool bChecked)
+{
+    if (bChecked) m_nOptions |= SCAN_THREAD_OPTION_HISTORY;
+    else m_nOptions &= ~SCAN_THREAD_OPTION_HISTORY;
+
+    m_pRangeEdit->setEnabled(bChecked);
+}
+
 void ScanDialog::validate()
 {
     QString sRoot = m_pRootEdit->text();
@@ -148,3 +185,12 @@ QString ScanDialog::getSearch()
     return m_pSearchEdit->text();
 }
 
+
+QString ScanDialog::getRange()
+{
+    if (!(m_nOptions & SCAN_THREAD_OPTION_HISTORY)) return QString();
+
+    QString sRange = m_pRangeEdit->text().trimmed();
+
+    return sRange == "HEAD" ? QString() : sRange;
+}
@@ -20,8 +20,10 @@ public:
 
     QString getRootPath();
     QString getSearch();
+    QString getRange();
 
     int getSearchType() { return m_nSearchType; }
+    int getOptions() { return m_nOptions; }
 
 signals:
 
@@ -34,15 +36,19 @@ private slots:
     void searchTypeCaseInsensitive();
     void searchTypeCaseSensitive();
     void searchTypeRegex();
+    void optionBlobCache(bool bChecked);
+    void optionUseIndex(bool bChecked);
+    void optionHistory(bool bChecked);
 
 private:
     void validate();
 
     QDialogButtonBox *m_pBtnBox;
-    QLineEdit *m_pRootEdit, *m_pSearchEdit;
+    QLineEdit *m_pRootEdit, *m_pSearchEdit, *m_pRangeEdit;
     OptionsMenuButton *m_pSearchOptionsBtn;
     QActionGroup *m_pActGrp;
     int m_nSearchType;
+    int m_nOptions;
 };
 
 #endif // SCANDIALOG_H
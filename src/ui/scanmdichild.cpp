@@ -1,20 +1,27 @@
 #include "scanmdichild.h"
 #include "src/gbl/gbl_string.h"
 #include "src/gbl/gbl_threads.h"
+#include "src/gbl/gbl_scanresultsmodel.h"
 
-#include <QTextEdit>
+#include <QTableView>
+#include <QHeaderView>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QProgressBar>
 #include <QPushButton>
+#include <QLabel>
 #include <QDebug>
 
 ScanMdiChild::ScanMdiChild(QWidget *parent) : QFrame(parent)
 {
     m_pScanThread = new GBL_ScanThread(this);
     m_pScanScrollArea = new ScanScrollArea(this);
-    connect(m_pScanThread, SIGNAL(scanUpdated(int, int, GBL_String*)), this, SLOT(scanUpdated(int, int, GBL_String*)));
+    m_pResultsModel = new GBL_ScanResultsModel(this);
+    m_pScanScrollArea->getResultsView()->setModel(m_pResultsModel);
+    connect(m_pScanThread, SIGNAL(scanUpdated(int, int)), this, SLOT(scanUpdated(int, int)));
+    connect(m_pScanThread, SIGNAL(scanResultsReady()), this, SLOT(scanResultsReady()));
     connect(m_pScanThread, SIGNAL(scanFinished()), this, SLOT(scanFinished()));
+    connect(m_pScanThread, SIGNAL(scanThroughput(double, double, qint64)), this, SLOT(scanThroughput(double, double, qint64)));
 
     QPushButton *pCancel = m_pScanScrollArea->getCancelButton();
     connect(pCancel,&QPushButton::clicked, this, &ScanMdiChild::cancel);
@@ -26,13 +33,14 @@ ScanMdiChild::~ScanMdiChild()
     delete m_pScanThread;
 }
 
-void ScanMdiChild::init(GBL_String sRoot, GBL_String sSearch, int nSearchType)
+void ScanMdiChild::init(GBL_String sRoot, GBL_String sSearch, int nSearchType, int nOptions, GBL_String sRange)
 {
     GBL_String sTitle = "Scan - ";
     sTitle += sRoot;
     setWindowTitle(sTitle);
 
-    m_pScanThread->scan(sRoot, sSearch, nSearchType);
+    m_pResultsModel->reset();
+    m_pScanThread->scan(sRoot, sSearch, nSearchType, nOptions, sRange);
 }
 
 void ScanMdiChild::cancel()
@@ -48,16 +56,29 @@ void ScanMdiChild::resizeEvent(QResizeEvent *event)
     m_pScanScrollArea->resize(sz);
 }
 
-void ScanMdiChild::scanUpdated(int prog_value, int prog_max, GBL_String* psOutput)
+void ScanMdiChild::scanUpdated(int prog_value, int prog_max)
 {
     QProgressBar *pProgress = m_pScanScrollArea->getProgressBar();
     pProgress->setRange(0,prog_max);
     pProgress->setValue(prog_value);
+}
 
-    if (!psOutput->isEmpty())
-    {
-        m_pScanScrollArea->getOutputEdit()->setHtml(*psOutput);
-    }
+/**
+ * @brief ScanMdiChild::scanResultsReady
+ * appends the matches queued since the last update, rows already shown
+ * aren't touched
+ */
+void ScanMdiChild::scanResultsReady()
+{
+    GBL_Scan_Match_Array batch;
+    m_pScanThread->takeResults(batch);
+    m_pResultsModel->addResults(batch);
+}
+
+void ScanMdiChild::scanThroughput(double dBlobsPerSec, double dMBPerSec, qint64 nSkippedBlobs)
+{
+    QLabel *pRateLabel = m_pScanScrollArea->getScanProgress()->getRateLabel();
+    pRateLabel->setText(tr("%1 blobs/s  %2 MB/s  %3 skipped").arg(qRound(dBlobsPerSec)).arg(dMBPerSec, 0, 'f', 1).arg(nSkippedBlobs));
 }
 
 void ScanMdiChild::scanFinished()
@@ -69,11 +90,19 @@ void ScanMdiChild::scanFinished()
 ScanScrollArea::ScanScrollArea(QWidget *parent) : QScrollArea(parent)
 {
     m_pScanProgress = new ScanProgress(this);
-    m_pOutput = new QTextEdit(this);
+    m_pResultsView = new QTableView(this);
+    m_pResultsView->setShowGrid(false);
+    m_pResultsView->setWordWrap(false);
+    m_pResultsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_pResultsView->verticalHeader()->hide();
+    // a fixed row height lets the view lay out only the visible rows
+    m_pResultsView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_pResultsView->verticalHeader()->setDefaultSectionSize(m_pResultsView->fontMetrics().height() + 4);
+    m_pResultsView->horizontalHeader()->setStretchLastSection(true);
 
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
     mainLayout->addWidget(m_pScanProgress);
-    mainLayout->addWidget(m_pOutput);
+    mainLayout->addWidget(m_pResultsView);
     mainLayout->setSpacing(2);
     mainLayout->setMargin(0);
 }
@@ -91,10 +120,12 @@ QProgressBar* ScanScrollArea::getProgressBar()
 ScanProgress::ScanProgress(QWidget *parent) : QWidget(parent)
 {
    m_pProgress = new QProgressBar(this);
+   m_pRateLabel = new QLabel(this);
    m_pCancelBtn = new QPushButton(tr("Cancel"), this);
 
    QHBoxLayout *mainLayout = new QHBoxLayout(this);
    mainLayout->addWidget(m_pProgress);
+   mainLayout->addWidget(m_pRateLabel);
    mainLayout->addWidget(m_pCancelBtn);
 
    setMaximumHeight(50);
@@ -7,9 +7,11 @@
 QT_BEGIN_NAMESPACE
 class GBL_String;
 class GBL_ScanThread;
-class QTextEdit;
+class GBL_ScanResultsModel;
+class QTableView;
 class QProgressBar;
 class QPushButton;
+class QLabel;
 QT_END_NAMESPACE
 
 class ScanProgress : public QWidget
@@ -21,9 +23,11 @@ public:
 
     QProgressBar* getProgressBar() { return m_pProgress; }
     QPushButton* getCancelButton() { return m_pCancelBtn; }
+    QLabel* getRateLabel() { return m_pRateLabel; }
 
 private:
     QProgressBar *m_pProgress;
+    QLabel *m_pRateLabel;
     QPushButton *m_pCancelBtn;
 };
 
@@ -36,14 +40,14 @@ public:
 
     ScanProgress* getScanProgress() { return m_pScanProgress; }
     QProgressBar* getProgressBar();
-    QTextEdit* getOutputEdit() { return m_pOutput; }
+    QTableView* getResultsView() { return m_pResultsView; }
     QPushButton* getCancelButton() { return m_pScanProgress->getCancelButton(); }
 signals:
 
 public slots:
 
 private:
-    QTextEdit *m_pOutput;
+    QTableView *m_pResultsView;
     ScanProgress *m_pScanProgress;
 };
 
@@ -54,19 +58,22 @@ public:
     explicit ScanMdiChild(QWidget *parent = nullptr);
     ~ScanMdiChild();
 
-    void init(GBL_String sRoot, GBL_String sSearch, int nSearchType);
+    void init(GBL_String sRoot, GBL_String sSearch, int nSearchType, int nOptions = 0, GBL_String sRange = GBL_String());
 
 signals:
 
 public slots:
     void resizeEvent(QResizeEvent *event);
-    void scanUpdated(int, int, GBL_String*);
+    void scanUpdated(int, int);
+    void scanResultsReady();
+    void scanThroughput(double dBlobsPerSec, double dMBPerSec, qint64 nSkippedBlobs);
     void scanFinished();
     void cancel();
 
 private:
     GBL_ScanThread *m_pScanThread;
     ScanScrollArea *m_pScanScrollArea;
+    GBL_ScanResultsModel *m_pResultsModel;
     int m_nSearchType;
 };
 
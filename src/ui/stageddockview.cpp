@@ -41,10 +41,10 @@ StagedDockView::StagedDockView(QWidget *parent) : QSplitter(Qt::Vertical,parent)
     connect(m_pFileView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &StagedDockView::stagedFileSelectionChanged);
 }
 
-void StagedDockView::setFileArray(GBL_File_Array *pArr)
+void StagedDockView::setFileArray(GBL_FileList *pArr)
 {
     GBL_FileModel *pMod = dynamic_cast<GBL_FileModel*>(m_pFileView->model());
-    pMod->setFileArray(pArr);
+    pMod->updateFileArray(pArr);
 
     StagedCommitView *pView = dynamic_cast<StagedCommitView*>(widget(1));
     StagedButtonBar *pBtnBar = pView->getButtonBar();
@@ -56,7 +56,7 @@ void StagedDockView::setFileArray(GBL_File_Array *pArr)
     pBtn->setDisabled(pArr->size() == 0);
 }
 
-GBL_File_Array* StagedDockView::getFileArray()
+GBL_FileList* StagedDockView::getFileArray()
 {
     GBL_FileModel *pMod = dynamic_cast<GBL_FileModel*>(m_pFileView->model());
     return pMod->getFileArray();
@@ -68,6 +68,11 @@ void StagedDockView::reset()
     m_pCommitView->reset();
 }
 
+void StagedDockView::clearCommitMessage()
+{
+    m_pCommitView->clearCommitMessage();
+}
+
 void StagedDockView::stagedFileSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
 {
     StagedCommitView *pView = dynamic_cast<StagedCommitView*>(widget(1));
@@ -133,6 +138,11 @@ QString StagedCommitView::getCommitMessage()
     return m_pCommitEdit->toPlainText();
 }
 
+void StagedCommitView::clearCommitMessage()
+{
+    m_pCommitEdit->setText("");
+}
+
 void StagedCommitView::reset()
 {
     if (!m_pCommitEdit->hasFocus())
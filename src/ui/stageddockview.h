@@ -69,6 +69,7 @@ public:
 
     StagedButtonBar* getButtonBar() { return m_pBtnBar; }
     QString getCommitMessage();
+    void clearCommitMessage();
 
     void reset();
 
@@ -89,9 +90,10 @@ class StagedDockView : public QSplitter
 public:
     explicit StagedDockView(QWidget *parent = Q_NULLPTR);
 
-    void setFileArray(GBL_File_Array *pArr);
-    GBL_File_Array* getFileArray();
+    void setFileArray(GBL_FileList *pArr);
+    GBL_FileList* getFileArray();
     void reset();
+    void clearCommitMessage();
     FileView* getFileView() { return m_pFileView; }
     QString getCommitMessage();
 
@@ -31,16 +31,16 @@ UnstagedDockView::UnstagedDockView(QWidget *parent) : QScrollArea(parent)
 
 }
 
-void UnstagedDockView::setFileArray(GBL_File_Array *pArr)
+void UnstagedDockView::setFileArray(GBL_FileList *pArr)
 {
     GBL_FileModel *pMod = (GBL_FileModel*)m_pFileView->model();
-    pMod->setFileArray(pArr);
+    pMod->updateFileArray(pArr);
     UnstagedButton *pBtn = m_pBtnBar->getButton(ADD_ALL_BTN);
     pBtn->setDisabled(pArr->size() == 0);
 }
 
 
-GBL_File_Array* UnstagedDockView::getFileArray()
+GBL_FileList* UnstagedDockView::getFileArray()
 {
     GBL_FileModel *pMod = (GBL_FileModel*)m_pFileView->model();
     return pMod->getFileArray();
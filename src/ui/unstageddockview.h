@@ -49,8 +49,8 @@ class UnstagedDockView : public QScrollArea
 public:
     explicit UnstagedDockView(QWidget *parent = 0);
 
-    void setFileArray(GBL_File_Array *pArr);
-    GBL_File_Array* getFileArray();
+    void setFileArray(GBL_FileList *pArr);
+    GBL_FileList* getFileArray();
 
     FileView* getFileView() { return m_pFileView; }
     void reset();